@@ -230,6 +230,16 @@ void AnimationWindow::Create(EditorComponent* _editor)
 		{
 			const float current_time = animation->timer;
 
+			// Recording modifies the raw keyframes:
+			for (auto& sam : animation->samplers)
+			{
+				AnimationDataComponent* animation_data = scene.animation_datas.GetComponent(sam.data);
+				if (animation_data != nullptr)
+				{
+					animation_data->Decompress();
+				}
+			}
+
 			if (args.userdata == ~0ull)
 			{
 				// Close loop:
@@ -821,6 +831,14 @@ void AnimationWindow::Create(EditorComponent* _editor)
 				const AnimationComponent::AnimationChannel& channel = animation->channels[channelIndex];
 				const AnimationComponent::AnimationSampler& sam = animation->samplers[channel.samplerIndex];
 				const AnimationDataComponent* animation_data = scene.animation_datas.GetComponent(sam.data);
+				AnimationDataComponent decompressed;
+				if (animation_data != nullptr && animation_data->IsCompressed())
+				{
+					// The list shows the keyframes of the decompressed data:
+					decompressed = *animation_data;
+					decompressed.Decompress();
+					animation_data = &decompressed;
+				}
 				if (animation_data != nullptr && animation_data->keyframe_times.size() > timeIndex)
 				{
 					float time = animation_data->keyframe_times[timeIndex];
@@ -841,6 +859,11 @@ void AnimationWindow::Create(EditorComponent* _editor)
 				const AnimationComponent::AnimationChannel& channel = animation->channels[channelIndex];
 				const AnimationComponent::AnimationSampler& sam = animation->samplers[channel.samplerIndex];
 				AnimationDataComponent* animation_data = scene.animation_datas.GetComponent(sam.data);
+				if (animation_data != nullptr && timeIndex != 0xFFFFFFFF)
+				{
+					// Deletion modifies the raw keyframes, the indices of the listed keyframes match the decompressed data:
+					animation_data->Decompress();
+				}
 
 				if (animation_data != nullptr && animation_data->keyframe_times.size() > timeIndex)
 				{
@@ -900,6 +923,19 @@ void AnimationWindow::Create(EditorComponent* _editor)
 	AddWidget(&keyframesList);
 
 
+	compressButton.Create("Compress keyframes");
+	compressButton.SetTooltip("Compress the keyframes of all animations in the scene that use Linear or Step sampling.\nKeyframes that can be interpolated are removed and the rest are quantized to 16 bits.\nCompressed keyframes are decompressed when recording.");
+	compressButton.SetSize(XMFLOAT2(wid, hei));
+	compressButton.SetPos(XMFLOAT2(x, y += step));
+	compressButton.OnClick([=](wi::gui::EventArgs args) {
+		wi::scene::Scene& scene = editor->GetCurrentScene();
+		const uint32_t count = scene.CompressAnimations();
+		wi::backlog::post("Compressed keyframes of " + std::to_string(count) + " animation data components");
+		RefreshKeyframesList();
+	});
+	AddWidget(&compressButton);
+
+
 	retargetCombo.Create("Retarget: ");
 	retargetCombo.SetSize(XMFLOAT2(wid, hei));
 	retargetCombo.selected_font.anim.typewriter.looped = true;
@@ -1112,7 +1148,15 @@ void AnimationWindow::RefreshKeyframesList()
 		keyframesList.AddItem(item);
 
 		auto& sam = animation.samplers[channel.samplerIndex];
-		AnimationDataComponent* animation_data = scene.animation_datas.GetComponent(sam.data);
+		const AnimationDataComponent* animation_data = scene.animation_datas.GetComponent(sam.data);
+		AnimationDataComponent decompressed;
+		if (animation_data != nullptr && animation_data->IsCompressed())
+		{
+			// Compressed keyframes are listed from a decompressed copy:
+			decompressed = *animation_data;
+			decompressed.Decompress();
+			animation_data = &decompressed;
+		}
 		if (animation_data != nullptr)
 		{
 			uint32_t timeIndex = 0;
@@ -1212,6 +1256,7 @@ void AnimationWindow::ResizeLayout()
 	add(startInput);
 	add(endInput);
 	add(recordCombo);
+	add(compressButton);
 	add(retargetCombo);
 	add_fullwidth(keyframesList);
 }
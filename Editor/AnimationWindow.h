@@ -24,6 +24,8 @@ public:
 	wi::gui::ComboBox recordCombo;
 	wi::gui::TreeList keyframesList;
 
+	wi::gui::Button compressButton;
+
 	wi::gui::ComboBox retargetCombo;
 
 	void Update();
@@ -3085,6 +3085,7 @@ void EditorComponent::Save(const std::string& filename)
 			wi::resourcemanager::Mode embed_mode = (wi::resourcemanager::Mode)optionsWnd.generalWnd.saveModeComboBox.GetItemUserData(optionsWnd.generalWnd.saveModeComboBox.GetSelected());
 			wi::resourcemanager::SetMode(embed_mode);
 
+			archive.SetFileCompressionEnabled(optionsWnd.generalWnd.saveCompressionCheckBox.GetCheck());
 			scene.Serialize(archive);
 
 			if (dump_to_header)
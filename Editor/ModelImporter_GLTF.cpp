@@ -3472,6 +3472,18 @@ void ExportModel_GLTF(const std::string& filename, Scene& scene)
 	state.scene = &scene;
 	auto& wiscene = *state.scene;
 
+	// Compressed animation keyframes are exported in decompressed form, the compressed data is restored after export:
+	wi::vector<std::pair<Entity, AnimationDataComponent>> compressed_animation_datas;
+	for (size_t i = 0; i < wiscene.animation_datas.GetCount(); ++i)
+	{
+		AnimationDataComponent& animation_data = wiscene.animation_datas[i];
+		if (animation_data.IsCompressed())
+		{
+			compressed_animation_datas.emplace_back(wiscene.animation_datas.GetEntity(i), animation_data);
+			animation_data.Decompress();
+		}
+	}
+
 	// Prerequisite: flip world Z coordinate
 	FlipZAxis(state);
 	wiscene.Update(0.f);
@@ -4753,5 +4765,13 @@ void ExportModel_GLTF(const std::string& filename, Scene& scene)
 
 	// Restore scene world orientation
 	FlipZAxis(state);
+	for (auto& it : compressed_animation_datas)
+	{
+		AnimationDataComponent* animation_data = wiscene.animation_datas.GetComponent(it.first);
+		if (animation_data != nullptr)
+		{
+			*animation_data = std::move(it.second);
+		}
+	}
 	wiscene.Update(0.f);
 }
@@ -25,6 +25,10 @@ enum TEST_TYPE
 	INVERSEKINEMATICSTEST,
 	INSTANCESTEST,
 	CONTAINERPERF,
+	SCENEQUERYPERF,
+	ANIMATIONPERF,
+	SKINNINGPERF,
+	HIERARCHYPERF,
 };
 
 // Controller Test UI Data, info down below will be using Xbox Controller as reference
@@ -156,6 +160,10 @@ void TestsRenderer::Load()
 	testSelector.AddItem("Inverse Kinematics", INVERSEKINEMATICSTEST);
 	testSelector.AddItem("65k Instances", INSTANCESTEST);
 	testSelector.AddItem("Container perf", CONTAINERPERF);
+	testSelector.AddItem("Scene query perf", SCENEQUERYPERF);
+	testSelector.AddItem("Animation perf", ANIMATIONPERF);
+	testSelector.AddItem("Skinned query perf", SKINNINGPERF);
+	testSelector.AddItem("Hierarchy perf", HIERARCHYPERF);
 	testSelector.SetMaxVisibleItemCount(10);
 	testSelector.OnSelect([=](wi::gui::EventArgs args) {
 
@@ -415,6 +423,22 @@ void TestsRenderer::Load()
 			ContainerTest();
 			break;
 
+		case SCENEQUERYPERF:
+			SceneQueryTest();
+			break;
+
+		case ANIMATIONPERF:
+			AnimationTest();
+			break;
+
+		case SKINNINGPERF:
+			SkinningTest();
+			break;
+
+		case HIERARCHYPERF:
+			HierarchyTest();
+			break;
+
 		default:
 			assert(0);
 			break;
@@ -684,6 +708,87 @@ void TestsRenderer::RunJobSystemTest()
 		ss += "wi::jobsystem::Dispatch() took " + std::to_string(time) + " milliseconds\n";
 	}
 
+	// ParallelFor test, the group size is chosen automatically:
+	{
+		wi::vector<wi::scene::CameraComponent> dataSet(itemCount);
+		timer.record();
+		wi::jobsystem::ParallelFor(ctx, itemCount, [&](wi::jobsystem::JobArgs args) {
+			dataSet[args.jobIndex].UpdateCamera();
+		});
+		wi::jobsystem::Wait(ctx);
+		double time = timer.elapsed();
+		ss += "wi::jobsystem::ParallelFor() took " + std::to_string(time) + " milliseconds\n";
+	}
+
+	// ParallelReduce test, sum of the camera near planes:
+	{
+		wi::vector<wi::scene::CameraComponent> dataSet(itemCount);
+		timer.record();
+		const float sum = wi::jobsystem::ParallelReduce(itemCount, 0.0f,
+			[&](float& partial, uint32_t index) { partial += dataSet[index].zNearP; },
+			[](float& result, const float& partial) { result += partial; }
+		);
+		double time = timer.elapsed();
+		ss += "wi::jobsystem::ParallelReduce() took " + std::to_string(time) + " milliseconds (result: " + std::to_string(sum) + ")\n";
+	}
+
+	ss += "\n3) Scheduling throughput test (empty jobs):\n";
+
+	// Dispatch throughput with different group sizes, this measures the job queue overhead:
+	for (uint32_t groupSize : { 1u, 64u })
+	{
+		std::atomic<uint32_t> sink{ 0 };
+		timer.record();
+		for (int repeat = 0; repeat < 10; ++repeat)
+		{
+			wi::jobsystem::Dispatch(ctx, itemCount, groupSize, [&](wi::jobsystem::JobArgs args) {
+				if (args.isLastJobInGroup)
+				{
+					sink.fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+		double time = timer.elapsed();
+		const double groupCount = 10.0 * wi::jobsystem::DispatchGroupCount(itemCount, groupSize);
+		ss += "Dispatch(groupSize = " + std::to_string(groupSize) + "): " + std::to_string(time * 1000000.0 / groupCount) + " ns/group\n";
+	}
+
+	// Execute throughput:
+	{
+		std::atomic<uint32_t> sink{ 0 };
+		timer.record();
+		for (uint32_t i = 0; i < itemCount; ++i)
+		{
+			wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+				sink.fetch_add(1, std::memory_order_relaxed);
+			});
+		}
+		wi::jobsystem::Wait(ctx);
+		double time = timer.elapsed();
+		ss += "Execute(): " + std::to_string(time * 1000000.0 / itemCount) + " ns/job\n";
+	}
+
+	// Execute throughput with larger captures, these are stored inline in the task without heap allocation:
+	{
+		std::atomic<uint32_t> sink{ 0 };
+		XMFLOAT4X3 payload = {};
+		payload._11 = 1;
+		timer.record();
+		for (uint32_t i = 0; i < itemCount; ++i)
+		{
+			wi::jobsystem::Execute(ctx, [&sink, payload](wi::jobsystem::JobArgs args) {
+				sink.fetch_add(uint32_t(payload._11), std::memory_order_relaxed);
+			});
+		}
+		wi::jobsystem::Wait(ctx);
+		double time = timer.elapsed();
+		ss += "Execute(" + std::to_string(sizeof(payload) + sizeof(&sink)) + " bytes of captures): " + std::to_string(time * 1000000.0 / itemCount) + " ns/job\n";
+	}
+
+	const wi::jobsystem::Statistics statistics = wi::jobsystem::GetStatistics();
+	ss += "\nScheduler statistics: " + std::to_string(statistics.wakeups) + " wakeups, " + std::to_string(statistics.spins) + " spins, " + std::to_string(statistics.parks) + " parks\n";
+
 	static wi::SpriteFont font;
 	font = wi::SpriteFont(ss);
 	font.params.posX = GetLogicalWidth() / 2;
@@ -1157,6 +1262,51 @@ void TestsRenderer::RunNetworkTest()
 	font.params.size = 24;
 	AddFont(&font);
 }
+// Components for the ECS lookup benchmark, they only differ in the lookup table of their ComponentManager:
+struct HashLookupTestComponent
+{
+	float value = 0;
+	void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri) {}
+};
+struct PagedLookupTestComponent
+{
+	float value = 0;
+	void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri) {}
+};
+namespace wi::ecs
+{
+	template<> struct ComponentLookup<PagedLookupTestComponent> { using type = PagedLookup; };
+}
+template<typename Component>
+void ComponentLookupTest(const char* name, const wi::vector<wi::ecs::Entity>& entities, size_t stride, std::string& ss)
+{
+	wi::Timer timer;
+	wi::ecs::ComponentManager<Component> manager;
+	for (size_t i = 0; i < entities.size(); i += stride)
+	{
+		manager.Create(entities[i]);
+	}
+
+	// Every entity is looked up in shuffled order, including the ones without component:
+	const size_t repeat = 10;
+	float sum = 0;
+	timer.record();
+	for (size_t r = 0; r < repeat; ++r)
+	{
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			const Component* component = manager.GetComponent(entities[(i * 7919) % entities.size()]);
+			if (component != nullptr)
+			{
+				sum += component->value;
+			}
+		}
+	}
+	const double time = timer.elapsed_milliseconds();
+	volatile float result = sum; // keep the lookups from being optimized away
+	(void)result;
+	ss += std::string(name) + ": " + std::to_string(time * 1000000.0 / double(repeat * entities.size())) + " ns/GetComponent, lookup memory: " + std::to_string(manager.GetLookupMemoryUsage() / 1024) + " KB\n";
+}
 void TestsRenderer::ContainerTest()
 {
 	wi::Timer timer;
@@ -1244,6 +1394,488 @@ void TestsRenderer::ContainerTest()
 	ss += "wi::vector implementation uses std::vector. There is nothing to test.";
 #endif // WI_VECTOR_TYPE
 
+	// ComponentManager lookup tables, with components on every entity (like transforms) and on every 16th entity (like lights):
+	{
+		wi::vector<wi::ecs::Entity> entities(200000);
+		for (auto& entity : entities)
+		{
+			entity = wi::ecs::CreateEntity();
+		}
+		ss += "\nComponentManager lookup with " + std::to_string(entities.size()) + " entities:\n";
+		ComponentLookupTest<HashLookupTestComponent>("HashLookup, every entity", entities, 1, ss);
+		ComponentLookupTest<PagedLookupTestComponent>("PagedLookup, every entity", entities, 1, ss);
+		ComponentLookupTest<HashLookupTestComponent>("HashLookup, every 16th entity", entities, 16, ss);
+		ComponentLookupTest<PagedLookupTestComponent>("PagedLookup, every 16th entity", entities, 16, ss);
+		wi::ecs::DestroyEntities(entities.data(), entities.size());
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::SceneQueryTest()
+{
+	wi::Timer timer;
+
+	// A large terrain-like mesh is created in a separate scene, so it is not rendered:
+	Scene scene;
+	const uint32_t grid_size = 708;
+	Entity entity = scene.Entity_CreateObject("grid");
+	ObjectComponent& object = *scene.objects.GetComponent(entity);
+	object.meshID = scene.Entity_CreateMesh("grid_mesh");
+	MeshComponent& grid_mesh = *scene.meshes.GetComponent(object.meshID);
+	wi::random::RNG rng;
+	for (uint32_t z = 0; z <= grid_size; ++z)
+	{
+		for (uint32_t x = 0; x <= grid_size; ++x)
+		{
+			grid_mesh.vertex_positions.push_back(XMFLOAT3(float(x) - grid_size * 0.5f, rng.next_float() * 0.5f, float(z) - grid_size * 0.5f));
+		}
+	}
+	for (uint32_t z = 0; z < grid_size; ++z)
+	{
+		for (uint32_t x = 0; x < grid_size; ++x)
+		{
+			const uint32_t i0 = z * (grid_size + 1) + x;
+			const uint32_t i1 = i0 + 1;
+			const uint32_t i2 = i0 + grid_size + 1;
+			const uint32_t i3 = i2 + 1;
+			grid_mesh.indices.insert(grid_mesh.indices.end(), { i0, i2, i1, i1, i2, i3 });
+		}
+	}
+	grid_mesh.subsets.emplace_back();
+	grid_mesh.subsets.back().indexCount = (uint32_t)grid_mesh.indices.size();
+	grid_mesh.vertex_normals.resize(grid_mesh.vertex_positions.size(), XMFLOAT3(0, 1, 0));
+	grid_mesh.CreateRenderData();
+	scene.Update(0);
+
+	std::string ss = "Scene query test with " + std::to_string(grid_mesh.indices.size() / 3) + " triangles:\n";
+
+	const uint32_t query_count = 100;
+	wi::vector<XMFLOAT3> positions(query_count);
+	for (auto& position : positions)
+	{
+		position = XMFLOAT3(rng.next_float() * grid_size - grid_size * 0.5f, 0.25f, rng.next_float() * grid_size - grid_size * 0.5f);
+	}
+	auto run_queries = [&](const char* name) {
+		uint32_t hits = 0;
+		timer.record();
+		for (auto& position : positions)
+		{
+			wi::primitive::Ray ray(XMFLOAT3(position.x, 10, position.z), XMFLOAT3(0, -1, 0));
+			hits += scene.Intersects(ray).entity != INVALID_ENTITY ? 1 : 0;
+		}
+		double time = timer.elapsed_seconds();
+		ss += std::string(name) + " ray: " + std::to_string(int(query_count / time)) + " queries/sec (" + std::to_string(hits) + " hits)\n";
+		hits = 0;
+		timer.record();
+		for (auto& position : positions)
+		{
+			wi::primitive::Sphere sphere(position, 0.5f);
+			hits += scene.Intersects(sphere).entity != INVALID_ENTITY ? 1 : 0;
+		}
+		time = timer.elapsed_seconds();
+		ss += std::string(name) + " sphere: " + std::to_string(int(query_count / time)) + " queries/sec (" + std::to_string(hits) + " hits)\n";
+		hits = 0;
+		timer.record();
+		for (auto& position : positions)
+		{
+			wi::primitive::Capsule capsule(XMFLOAT3(position.x, -0.5f, position.z), XMFLOAT3(position.x, 1.5f, position.z), 0.5f);
+			hits += scene.Intersects(capsule).entity != INVALID_ENTITY ? 1 : 0;
+		}
+		time = timer.elapsed_seconds();
+		ss += std::string(name) + " capsule: " + std::to_string(int(query_count / time)) + " queries/sec (" + std::to_string(hits) + " hits)\n";
+	};
+
+	// The brute force path is measured with a triangle BVH placeholder that never becomes ready:
+	grid_mesh.triangle_bvh = std::make_shared<MeshComponent::TriangleBVH>();
+	run_queries("Brute force");
+
+	grid_mesh.InvalidateTriangleBVH();
+	timer.record();
+	while (grid_mesh.GetTriangleBVH() == nullptr)
+	{
+		std::this_thread::yield();
+	}
+	ss += "Triangle BVH build: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+	run_queries("Triangle BVH");
+
+	// Ray throughput of single queries compared to one batched query:
+	wi::vector<Scene::RayQuery> ray_queries(10000);
+	for (auto& query : ray_queries)
+	{
+		query.ray = wi::primitive::Ray(XMFLOAT3(rng.next_float() * grid_size - grid_size * 0.5f, 10, rng.next_float() * grid_size - grid_size * 0.5f), XMFLOAT3(rng.next_float() - 0.5f, -1, rng.next_float() - 0.5f));
+	}
+	wi::vector<Scene::RayIntersectionResult> ray_results(ray_queries.size());
+	timer.record();
+	for (size_t i = 0; i < ray_queries.size(); ++i)
+	{
+		ray_results[i] = scene.Intersects(ray_queries[i].ray, ray_queries[i].filterMask, ray_queries[i].layerMask, ray_queries[i].lod);
+	}
+	double time = timer.elapsed_seconds();
+	ss += "Single rays: " + std::to_string(int(ray_queries.size() / time)) + " rays/sec\n";
+	timer.record();
+	scene.Intersects(ray_queries.data(), (uint32_t)ray_queries.size(), ray_results.data());
+	time = timer.elapsed_seconds();
+	ss += "Batched rays: " + std::to_string(int(ray_queries.size() / time)) + " rays/sec\n";
+
+	// Many small objects below the grid, these are only rejected by their bounds in the queries:
+	const uint32_t object_count = 100000;
+	Entity small_mesh = scene.Entity_CreateMesh("small_mesh");
+	MeshComponent& mesh = *scene.meshes.GetComponent(small_mesh);
+	mesh.vertex_positions = { XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 1), XMFLOAT3(1, 0, 0) };
+	mesh.vertex_normals.resize(mesh.vertex_positions.size(), XMFLOAT3(0, 1, 0));
+	mesh.indices = { 0, 1, 2 };
+	mesh.subsets.emplace_back();
+	mesh.subsets.back().indexCount = (uint32_t)mesh.indices.size();
+	mesh.CreateRenderData();
+	for (uint32_t i = 0; i < object_count; ++i)
+	{
+		Entity small_object = scene.Entity_CreateObject("small_object");
+		scene.objects.GetComponent(small_object)->meshID = small_mesh;
+		scene.transforms.GetComponent(small_object)->Translate(XMFLOAT3(rng.next_float() * grid_size - grid_size * 0.5f, -10 - rng.next_float() * 100, rng.next_float() * grid_size - grid_size * 0.5f));
+	}
+	timer.record();
+	scene.Update(0);
+	ss += "\nScene update with " + std::to_string(scene.objects.GetCount()) + " objects (object BVH build): " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+	scene.SetObjectBVHEnabled(false);
+	run_queries("Linear objects");
+	scene.SetObjectBVHEnabled(true);
+	scene.Update(0);
+	run_queries("Object BVH");
+
+	// Frustum culling throughput of single boxes compared to the SIMD bounds stream:
+	wi::primitive::Frustum frustum;
+	frustum.Create(XMMatrixLookToLH(XMVectorSet(0, 10, 0, 1), XMVectorSet(1, -0.2f, 1, 0), XMVectorSet(0, 1, 0, 0)) * XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.5f, 1000, 0.1f));
+	uint32_t visible = 0;
+	timer.record();
+	for (const wi::primitive::AABB& aabb : scene.aabb_objects)
+	{
+		visible += frustum.CheckBoxFast(aabb) ? 1 : 0;
+	}
+	time = timer.elapsed_seconds();
+	ss += "\nFrustum culling single boxes: " + std::to_string(int(scene.aabb_objects.size() / time)) + " boxes/sec (" + std::to_string(visible) + " visible)\n";
+	visible = 0;
+	timer.record();
+	for (const wi::primitive::AABB4& block : scene.aabb_objects_soa)
+	{
+		const uint32_t mask = frustum.CheckBoxFast(block);
+		visible += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+	}
+	time = timer.elapsed_seconds();
+	ss += "Frustum culling AABB4 blocks: " + std::to_string(int(scene.aabb_objects.size() / time)) + " boxes/sec (" + std::to_string(visible) + " visible)\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::AnimationTest()
+{
+	wi::Timer timer;
+
+	// A long animation on a large armature is created in a separate scene, so it is not rendered:
+	Scene scene;
+	const uint32_t bone_count = 200;
+	const uint32_t key_count = 30000;
+	const float key_interval = 1.0f / 60.0f;
+	Entity animation_entity = CreateEntity();
+	AnimationComponent& animation = scene.animations.Create(animation_entity);
+	animation.end = key_interval * (key_count - 1);
+	animation.Play();
+	wi::random::RNG rng;
+	for (uint32_t i = 0; i < bone_count; ++i)
+	{
+		Entity bone = scene.Entity_CreateTransform("bone");
+		for (auto path : { AnimationComponent::AnimationChannel::Path::TRANSLATION, AnimationComponent::AnimationChannel::Path::ROTATION })
+		{
+			Entity data_entity = CreateEntity();
+			AnimationDataComponent& data = scene.animation_datas.Create(data_entity);
+			const uint32_t components = path == AnimationComponent::AnimationChannel::Path::ROTATION ? 4 : 3;
+			data.keyframe_times.resize(key_count);
+			data.keyframe_data.resize(key_count * components);
+			// Smooth motion with some noise, similar to motion capture data:
+			const float frequency = rng.next_float(0.5f, 2.0f);
+			for (uint32_t k = 0; k < key_count; ++k)
+			{
+				const float time = key_interval * k;
+				data.keyframe_times[k] = time;
+				const float noise = rng.next_float() * 0.0005f;
+				if (components == 4)
+				{
+					const XMVECTOR axis = XMVector3Normalize(XMVectorSet(std::sin(time * frequency), std::cos(time), 1, 0));
+					XMStoreFloat4((XMFLOAT4*)&data.keyframe_data[k * 4], XMQuaternionRotationAxis(axis, std::sin(time * frequency + noise)));
+				}
+				else
+				{
+					data.keyframe_data[k * 3 + 0] = std::sin(time * frequency) + noise;
+					data.keyframe_data[k * 3 + 1] = std::cos(time * frequency) + noise;
+					data.keyframe_data[k * 3 + 2] = 0;
+				}
+			}
+
+			AnimationComponent::AnimationSampler& sampler = animation.samplers.emplace_back();
+			sampler.data = data_entity;
+			AnimationComponent::AnimationChannel& channel = animation.channels.emplace_back();
+			channel.target = bone;
+			channel.path = path;
+			channel.samplerIndex = int(animation.samplers.size() - 1);
+		}
+	}
+
+	std::string ss = "Animation test with " + std::to_string(animation.channels.size()) + " channels of " + std::to_string(key_count) + " keyframes:\n";
+
+	scene.Update(key_interval);
+	const uint32_t frame_count = 600;
+	timer.record();
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		scene.Update(key_interval);
+	}
+	ss += "Scene update: " + std::to_string(timer.elapsed_milliseconds() / frame_count) + " ms per frame\n";
+
+	// Seeking to random times can't use the cached keyframe cursors:
+	timer.record();
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		scene.animations[0].timer = rng.next_float() * scene.animations[0].end;
+		scene.Update(0);
+	}
+	ss += "Scene update with random seeking: " + std::to_string(timer.elapsed_milliseconds() / frame_count) + " ms per frame\n";
+
+	// Compressed keyframes:
+	size_t memory_uncompressed = 0;
+	for (size_t i = 0; i < scene.animation_datas.GetCount(); ++i)
+	{
+		memory_uncompressed += scene.animation_datas[i].GetMemorySizeInBytes();
+	}
+	timer.record();
+	const uint32_t compressed_count = scene.CompressAnimations(0.001f);
+	const double compression_time = timer.elapsed_milliseconds();
+	size_t memory_compressed = 0;
+	for (size_t i = 0; i < scene.animation_datas.GetCount(); ++i)
+	{
+		memory_compressed += scene.animation_datas[i].GetMemorySizeInBytes();
+	}
+	ss += "\nCompressed " + std::to_string(compressed_count) + " animation data in " + std::to_string(compression_time) + " ms\n";
+	ss += "Keyframe memory: " + std::to_string(memory_uncompressed / 1024) + " KB -> " + std::to_string(memory_compressed / 1024) + " KB\n";
+
+	scene.animations[0].timer = 0;
+	scene.Update(key_interval);
+	timer.record();
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		scene.Update(key_interval);
+	}
+	ss += "Scene update (compressed): " + std::to_string(timer.elapsed_milliseconds() / frame_count) + " ms per frame\n";
+
+	timer.record();
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		scene.animations[0].timer = rng.next_float() * scene.animations[0].end;
+		scene.Update(0);
+	}
+	ss += "Scene update with random seeking (compressed): " + std::to_string(timer.elapsed_milliseconds() / frame_count) + " ms per frame\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+void TestsRenderer::SkinningTest()
+{
+	wi::Timer timer;
+
+	// A dense skinned strip with a row of bones is created in a separate scene, so it is not rendered:
+	Scene scene;
+	const uint32_t bone_count = 64;
+	const uint32_t grid_size = 256;
+	Entity armature_entity = scene.Entity_CreateTransform("armature");
+	ArmatureComponent& armature = scene.armatures.Create(armature_entity);
+	for (uint32_t i = 0; i < bone_count; ++i)
+	{
+		Entity bone = scene.Entity_CreateTransform("bone");
+		scene.transforms.GetComponent(bone)->Translate(XMFLOAT3(float(i), std::sin(i * 0.2f), 0));
+		armature.boneCollection.push_back(bone);
+		XMFLOAT4X4 inverseBindMatrix;
+		XMStoreFloat4x4(&inverseBindMatrix, XMMatrixTranslation(-float(i), 0, 0));
+		armature.inverseBindMatrices.push_back(inverseBindMatrix);
+	}
+
+	Entity entity = scene.Entity_CreateObject("skinned_strip");
+	ObjectComponent& object = *scene.objects.GetComponent(entity);
+	object.meshID = scene.Entity_CreateMesh("skinned_strip_mesh");
+	MeshComponent& mesh = *scene.meshes.GetComponent(object.meshID);
+	mesh.armatureID = armature_entity;
+	for (uint32_t z = 0; z <= grid_size; ++z)
+	{
+		for (uint32_t x = 0; x <= grid_size; ++x)
+		{
+			const float bone_position = float(x) / grid_size * (bone_count - 1);
+			const uint32_t bone = std::min(uint32_t(bone_position), bone_count - 2);
+			const float weight = bone_position - bone;
+			mesh.vertex_positions.push_back(XMFLOAT3(bone_position, 0, float(z) / grid_size * 2 - 1));
+			mesh.vertex_boneindices.push_back(XMUINT4(bone, bone + 1, 0, 0));
+			mesh.vertex_boneweights.push_back(XMFLOAT4(1 - weight, weight, 0, 0));
+		}
+	}
+	for (uint32_t z = 0; z < grid_size; ++z)
+	{
+		for (uint32_t x = 0; x < grid_size; ++x)
+		{
+			const uint32_t i0 = z * (grid_size + 1) + x;
+			const uint32_t i1 = i0 + 1;
+			const uint32_t i2 = i0 + grid_size + 1;
+			const uint32_t i3 = i2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { i0, i2, i1, i1, i2, i3 });
+		}
+	}
+	mesh.subsets.emplace_back();
+	mesh.subsets.back().indexCount = (uint32_t)mesh.indices.size();
+	mesh.vertex_normals.resize(mesh.vertex_positions.size(), XMFLOAT3(0, 1, 0));
+	mesh.CreateRenderData();
+	scene.Update(0);
+
+	const uint32_t triangle_count = (uint32_t)mesh.indices.size() / 3;
+	std::string ss = "Skinned query test with " + std::to_string(triangle_count) + " triangles and " + std::to_string(bone_count) + " bones:\n";
+
+	// The cost of skinning every triangle vertex separately, which every query had to do for each skinned mesh before:
+	wi::vector<XMFLOAT3> skinned_positions(mesh.vertex_positions.size());
+	timer.record();
+	for (uint32_t index : mesh.indices)
+	{
+		XMStoreFloat3(&skinned_positions[index], SkinVertex(mesh, armature, index));
+	}
+	ss += "SkinVertex for every triangle vertex: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	timer.record();
+	SkinVertices(mesh, armature, nullptr, (uint32_t)skinned_positions.size(), skinned_positions.data());
+	ss += "SkinVertices for the whole mesh: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	// Every frame, the first query skins the mesh once and the rest reuse it:
+	wi::random::RNG rng;
+	const uint32_t frame_count = 10;
+	const uint32_t query_count = 100;
+	uint32_t hits = 0;
+	double query_time = 0;
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		for (uint32_t i = 0; i < bone_count; ++i)
+		{
+			scene.transforms.GetComponent(armature.boneCollection[i])->Translate(XMFLOAT3(0, std::sin(frame + i * 0.2f) * 0.1f, 0));
+		}
+		scene.Update(0);
+		timer.record();
+		for (uint32_t i = 0; i < query_count; ++i)
+		{
+			wi::primitive::Ray ray(XMFLOAT3(rng.next_float() * (bone_count - 1), 10, rng.next_float() * 2 - 1), XMFLOAT3(0, -1, 0));
+			hits += scene.Intersects(ray).entity != INVALID_ENTITY ? 1 : 0;
+		}
+		query_time += timer.elapsed_seconds();
+	}
+	ss += "Rays against the skinned mesh: " + std::to_string(int(frame_count * query_count / query_time)) + " queries/sec (" + std::to_string(hits) + " hits)\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+void TestsRenderer::HierarchyTest()
+{
+	wi::Timer timer;
+
+	// The hierarchy is created in a separate scene, mixing long chains and wide trees:
+	Scene scene;
+	const uint32_t node_count = 100000;
+	wi::random::RNG rng;
+	wi::vector<Entity> entities;
+	entities.reserve(node_count);
+	for (uint32_t i = 0; i < node_count; ++i)
+	{
+		Entity entity = CreateEntity();
+		TransformComponent& transform = scene.transforms.Create(entity);
+		transform.Translate(XMFLOAT3(rng.next_float() * 2 - 1, rng.next_float() * 2 - 1, rng.next_float() * 2 - 1));
+		transform.RotateRollPitchYaw(XMFLOAT3(rng.next_float() * 0.1f, rng.next_float() * 0.1f, 0));
+		transform.UpdateTransform();
+		if (i % 1000 != 0)
+		{
+			// every 1000th node is a root, the others are attached to the previous node (chain) or a random earlier node of the same root (tree):
+			const uint32_t root = i - i % 1000;
+			const uint32_t parent = rng.next_uint(0u, 3u) == 0 ? i - 1 : root + rng.next_uint(0u, i - root);
+			scene.hierarchy.Create(entity).parentID = entities[parent];
+		}
+		entities.push_back(entity);
+	}
+
+	std::string ss = "Hierarchy test with " + std::to_string(node_count) + " nodes:\n";
+
+	wi::jobsystem::context ctx;
+	timer.record();
+	scene.RunHierarchyUpdateSystem(ctx);
+	wi::jobsystem::Wait(ctx);
+	ss += "First update, building the update order: " + std::to_string(timer.elapsed_milliseconds()) + " ms (" + std::to_string(scene.hierarchy_level_offsets.size() - 1) + " levels)\n";
+
+	const uint32_t frame_count = 10;
+	timer.record();
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		scene.RunHierarchyUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+	}
+	ss += "Static update: " + std::to_string(timer.elapsed_milliseconds() / frame_count) + " ms\n";
+
+	double elapsed = 0;
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		// only the first 10 roots are moving, so the rest of the subtrees are skipped:
+		for (uint32_t i = 0; i < 10; ++i)
+		{
+			scene.transforms.GetComponent(entities[i * 1000])->Translate(XMFLOAT3(0, 0.1f, 0));
+		}
+		scene.RunTransformUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+		timer.record();
+		scene.RunHierarchyUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+		elapsed += timer.elapsed_milliseconds();
+	}
+	ss += "Update with 10 moving subtrees: " + std::to_string(elapsed / frame_count) + " ms\n";
+
+	elapsed = 0;
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		for (uint32_t i = 0; i < node_count; i += 1000)
+		{
+			scene.transforms.GetComponent(entities[i])->Translate(XMFLOAT3(0, 0.1f, 0));
+		}
+		scene.RunTransformUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+		timer.record();
+		scene.RunHierarchyUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+		elapsed += timer.elapsed_milliseconds();
+	}
+	ss += "Update with every subtree moving: " + std::to_string(elapsed / frame_count) + " ms\n";
+
 	static wi::SpriteFont font;
 	font = wi::SpriteFont(ss);
 	font.params.posX = GetLogicalWidth() / 2;
@@ -15,6 +15,10 @@ public:
 	void RunSpriteTest();
 	void RunNetworkTest();
 	void ContainerTest();
+	void SceneQueryTest();
+	void AnimationTest();
+	void SkinningTest();
+	void HierarchyTest();
 };
 
 class Tests : public wi::Application
@@ -469,9 +469,18 @@ int main(int argc, char* argv[])
 	std::cout << "[Wicked Engine Offline Shader Compiler] Searching for outdated shaders...\n";
 	wi::Timer timer;
 
+	// Every shader will be compiled at least once, even without permutations:
+	for (auto& shader : shaders)
+	{
+		if (shader.permutations.empty())
+		{
+			shader.permutations.emplace_back();
+		}
+	}
+
 	for (auto& target : targets)
 	{
-		std::string SHADERPATH = target.dir;
+		const std::string& SHADERPATH = target.dir;
 		wi::helper::DirectoryCreate(SHADERPATH);
 
 		for (auto& shader : shaders)
@@ -488,15 +497,10 @@ int main(int argc, char* argv[])
 					continue;
 				}
 			}
-			wi::vector<ShaderEntry::Permutation> permutations = shader.permutations;
-			if (permutations.empty())
-			{
-				permutations.emplace_back();
-			}
-
-			for (auto permutation : permutations)
+			for (auto& permutation : shader.permutations)
 			{
-				wi::jobsystem::Execute(ctx, [=](wi::jobsystem::JobArgs args) {
+				// Captured by reference, the targets and shaders are alive until the Wait() below:
+				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
 					std::string shaderbinaryfilename = SHADERPATH + shader.name;
 					for (auto& def : permutation.defines)
 					{
@@ -1,11 +1,160 @@
 #include "wiArchive.h"
 #include "wiHelper.h"
+#include "wiPlatform.h"
+#include "wiJobSystem.h"
+#include "wiBacklog.h"
+
+#include "Utility/basis_universal/zstd/zstd.h"
+
+#include <atomic>
+#include <algorithm>
+
+#ifdef PLATFORM_LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // PLATFORM_LINUX
 
 namespace wi
 {
+	static std::atomic_bool fileMappingEnabled{ true };
+
+	// Maps the whole file into memory as read only
+	//	Returns nullptr if it is not supported or failed, in which case the file should be read normally
+	static std::shared_ptr<void> MapFile(const std::string& fileName, const uint8_t*& data, size_t& data_size)
+	{
+#ifdef PLATFORM_LINUX
+		std::string filepath = fileName;
+		std::replace(filepath.begin(), filepath.end(), '\\', '/');
+		int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return nullptr;
+		struct stat st = {};
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < (off_t)sizeof(uint64_t))
+		{
+			close(fd);
+			return nullptr;
+		}
+		const size_t size = (size_t)st.st_size;
+		void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd); // the mapping remains valid after the file descriptor is closed
+		if (ptr == MAP_FAILED)
+			return nullptr;
+
+		// The archive is mostly read front to back, so the kernel can read ahead more aggressively and drop pages behind:
+		madvise(ptr, size, MADV_SEQUENTIAL);
+
+		data = (const uint8_t*)ptr;
+		data_size = size;
+		return std::shared_ptr<void>(ptr, [size](void* p) {
+			munmap(p, size);
+		});
+#else
+		return nullptr;
+#endif // PLATFORM_LINUX
+	}
+
+	// Block compressed file format:
+	//	CompressedFileHeader, followed by block_count CompressedBlock descriptors, followed by the block data
+	//	Every block contains block_size bytes of the uncompressed archive (except the last one) as an independent zstd frame,
+	//	or stored as is if it couldn't be compressed, so the blocks can be compressed and decompressed in parallel
+	static constexpr uint64_t compressed_file_magic = 0x315A484352414957ull; // "WIARCHZ1", can't be mistaken for an archive version
+	static constexpr uint32_t compressed_block_size = 256u * 1024u;
+	struct CompressedFileHeader
+	{
+		uint64_t magic;
+		uint64_t uncompressed_size;
+		uint32_t block_size;
+		uint32_t block_count;
+	};
+	struct CompressedBlock
+	{
+		uint64_t offset; // from the beginning of the file
+		uint32_t size;
+		uint32_t stored; // 1 if the block is not compressed
+	};
+	static_assert(sizeof(CompressedFileHeader) == 24);
+	static_assert(sizeof(CompressedBlock) == 16);
+
+	// Executes func(blockIndex) for every block, in parallel if the job system is available
+	template<typename F>
+	static void ForEachBlock(uint32_t block_count, const F& func)
+	{
+		if (block_count > 1 && wi::jobsystem::GetThreadCount() > 0)
+		{
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, block_count, 1, [&](wi::jobsystem::JobArgs args) {
+				func(args.jobIndex);
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < block_count; ++i)
+			{
+				func(i);
+			}
+		}
+	}
+
+	static bool IsCompressedFile(const uint8_t* data, size_t size)
+	{
+		uint64_t magic = 0;
+		if (size >= sizeof(magic))
+		{
+			std::memcpy(&magic, data, sizeof(magic));
+		}
+		return magic == compressed_file_magic;
+	}
+
+	static bool DecompressFile(const uint8_t* data, size_t size, wi::vector<uint8_t>& dest)
+	{
+		CompressedFileHeader header;
+		if (size < sizeof(header))
+			return false;
+		std::memcpy(&header, data, sizeof(header));
+		if (header.block_size == 0 || header.block_count != (header.uncompressed_size + header.block_size - 1) / header.block_size)
+			return false;
+		const size_t blocks_end = sizeof(header) + size_t(header.block_count) * sizeof(CompressedBlock);
+		if (blocks_end > size)
+			return false;
+
+		dest.resize((size_t)header.uncompressed_size);
+		std::atomic_bool success{ true };
+		ForEachBlock(header.block_count, [&](uint32_t i) {
+			CompressedBlock block;
+			std::memcpy(&block, data + sizeof(header) + i * sizeof(block), sizeof(block));
+			const size_t offset = size_t(i) * header.block_size;
+			const size_t uncompressed_size = std::min(size_t(header.uncompressed_size) - offset, size_t(header.block_size));
+			if (block.offset < blocks_end || block.offset + block.size > size)
+			{
+				success.store(false);
+				return;
+			}
+			if (block.stored)
+			{
+				if (block.size != uncompressed_size)
+				{
+					success.store(false);
+					return;
+				}
+				std::memcpy(dest.data() + offset, data + block.offset, uncompressed_size);
+			}
+			else
+			{
+				const size_t result = ZSTD_decompress(dest.data() + offset, uncompressed_size, data + block.offset, block.size);
+				if (ZSTD_isError(result) || result != uncompressed_size)
+				{
+					success.store(false);
+				}
+			}
+		});
+		return success.load();
+	}
 
 	// this should always be only INCREMENTED and only if a new serialization is implemeted somewhere!
-	static constexpr uint64_t __archiveVersion = 89;
+	static constexpr uint64_t __archiveVersion = 91;
 	// this is the version number of which below the archive is not compatible with the current version
 	static constexpr uint64_t __archiveVersionBarrier = 22;
 
@@ -23,9 +172,32 @@ namespace wi
 			directory = wi::helper::GetDirectoryFromPath(fileName);
 			if (readMode)
 			{
-				if (wi::helper::FileRead(fileName, DATA))
+				size_t size = 0;
+				if (fileMappingEnabled.load(std::memory_order_relaxed))
+				{
+					mapped_file = MapFile(fileName, data_ptr, size);
+				}
+				if (mapped_file == nullptr && wi::helper::FileRead(fileName, DATA))
 				{
 					data_ptr = DATA.data();
+					size = DATA.size();
+				}
+				if (data_ptr != nullptr && IsCompressedFile(data_ptr, size))
+				{
+					wi::vector<uint8_t> decompressed;
+					const bool success = DecompressFile(data_ptr, size, decompressed);
+					mapped_file.reset();
+					DATA = std::move(decompressed);
+					data_ptr = success ? DATA.data() : nullptr;
+					compressed_file = success;
+					if (!success)
+					{
+						DATA.clear();
+						wi::backlog::post("Archive decompression failed, the file is corrupted: " + fileName, wi::backlog::LogLevel::Error);
+					}
+				}
+				if (data_ptr != nullptr)
+				{
 					(*this) >> version;
 					if (version < __archiveVersionBarrier)
 					{
@@ -52,6 +224,18 @@ namespace wi
 		SetReadModeAndResetPos(true);
 	}
 
+	Archive Archive::CreateReadView(size_t pos) const
+	{
+		assert(readMode);
+		Archive view(data_ptr);
+		view.mapped_file = mapped_file;
+		view.compressed_file = compressed_file;
+		view.fileName = fileName;
+		view.directory = directory;
+		view.pos = pos;
+		return view;
+	}
+
 	void Archive::CreateEmpty()
 	{
 		version = __archiveVersion;
@@ -65,6 +249,14 @@ namespace wi
 		readMode = isReadMode;
 		pos = 0;
 
+		if (!readMode && mapped_file != nullptr)
+		{
+			// The mapped file is read only, writing starts into a new buffer:
+			mapped_file.reset();
+			DATA.resize(128);
+			data_ptr = DATA.data();
+		}
+
 		if (readMode)
 		{
 			(*this) >> version;
@@ -79,9 +271,21 @@ namespace wi
 	{
 		if (!readMode && !fileName.empty())
 		{
-			SaveFile(fileName);
+			if (compressed_file)
+			{
+				SaveFileCompressed(fileName);
+			}
+			else
+			{
+				SaveFile(fileName);
+			}
 		}
 		DATA.clear();
+		if (mapped_file != nullptr)
+		{
+			mapped_file.reset();
+			data_ptr = nullptr;
+		}
 	}
 
 	bool Archive::SaveFile(const std::string& fileName)
@@ -89,6 +293,57 @@ namespace wi
 		return wi::helper::FileWrite(fileName, data_ptr, pos);
 	}
 
+	bool Archive::SaveFileCompressed(const std::string& fileName, int level)
+	{
+		const size_t size = pos;
+		const uint32_t block_count = uint32_t((size + compressed_block_size - 1) / compressed_block_size);
+
+		wi::vector<CompressedBlock> blocks(block_count);
+		wi::vector<wi::vector<uint8_t>> block_datas(block_count);
+		ForEachBlock(block_count, [&](uint32_t i) {
+			const size_t offset = size_t(i) * compressed_block_size;
+			const size_t uncompressed_size = std::min(size - offset, size_t(compressed_block_size));
+			wi::vector<uint8_t>& block_data = block_datas[i];
+			block_data.resize(ZSTD_compressBound(uncompressed_size));
+			const size_t result = ZSTD_compress(block_data.data(), block_data.size(), data_ptr + offset, uncompressed_size, level);
+			if (ZSTD_isError(result) || result >= uncompressed_size)
+			{
+				block_data.resize(uncompressed_size);
+				std::memcpy(block_data.data(), data_ptr + offset, uncompressed_size);
+				blocks[i].stored = 1;
+			}
+			else
+			{
+				block_data.resize(result);
+				blocks[i].stored = 0;
+			}
+			blocks[i].size = (uint32_t)block_data.size();
+		});
+
+		CompressedFileHeader header = {};
+		header.magic = compressed_file_magic;
+		header.uncompressed_size = size;
+		header.block_size = compressed_block_size;
+		header.block_count = block_count;
+
+		size_t file_size = sizeof(header) + sizeof(CompressedBlock) * block_count;
+		for (CompressedBlock& block : blocks)
+		{
+			block.offset = file_size;
+			file_size += block.size;
+		}
+
+		wi::vector<uint8_t> file(file_size);
+		std::memcpy(file.data(), &header, sizeof(header));
+		std::memcpy(file.data() + sizeof(header), blocks.data(), sizeof(CompressedBlock) * block_count);
+		for (uint32_t i = 0; i < block_count; ++i)
+		{
+			std::memcpy(file.data() + blocks[i].offset, block_datas[i].data(), blocks[i].size);
+		}
+
+		return wi::helper::FileWrite(fileName, file.data(), file.size());
+	}
+
 	bool Archive::SaveHeaderFile(const std::string& fileName, const std::string& dataName)
 	{
 		return wi::helper::Bin2H(data_ptr, pos, fileName, dataName.c_str());
@@ -104,4 +359,13 @@ namespace wi
 		return fileName;
 	}
 
+	void Archive::SetFileMappingEnabled(bool value)
+	{
+		fileMappingEnabled.store(value, std::memory_order_relaxed);
+	}
+	bool Archive::IsFileMappingEnabled()
+	{
+		return fileMappingEnabled.load(std::memory_order_relaxed);
+	}
+
 }
@@ -5,6 +5,8 @@
 #include "wiColor.h"
 
 #include <string>
+#include <memory>
+#include <type_traits>
 
 namespace wi
 {
@@ -20,6 +22,8 @@ namespace wi
 		size_t pos = 0; // position of the next memory operation, relative to the data's beginning
 		wi::vector<uint8_t> DATA; // data suitable for read/write operations
 		const uint8_t* data_ptr = nullptr; // this can either be a memory mapped pointer (read only), or the DATA's pointer
+		std::shared_ptr<void> mapped_file; // keeps the memory mapped file alive while this archive or a copy of it is using it
+		bool compressed_file = false; // read mode: the file was block compressed, write mode: the file will be block compressed when closing
 
 		std::string fileName; // save to this file on closing if not empty
 		std::string directory; // the directory part from the fileName
@@ -32,11 +36,15 @@ namespace wi
 		Archive(const Archive&) = default;
 		Archive(Archive&&) = default;
 		// Create archive from a file.
-		//	If readMode == true, the whole file will be loaded into the archive in read mode
+		//	If readMode == true, the file will be memory mapped if it is supported (see SetFileMappingEnabled()), otherwise the whole file will be loaded into the archive in read mode
+		//		Block compressed files (see SaveFileCompressed()) are decompressed into the archive in parallel
 		//	If readMode == false, the file will be written when the archive is destroyed or Close() is called
 		Archive(const std::string& fileName, bool readMode = true);
 		// Creates a memory mapped archive in read mode
 		Archive(const uint8_t* data);
+		// Creates an archive in read mode that is reading the data of this archive without copying it, starting from the specified position
+		//	The view can be read independently of this archive (for example on a different thread), but this archive's data must remain valid while it is used
+		Archive CreateReadView(size_t pos) const;
 		~Archive() { Close(); }
 
 		Archive& operator=(const Archive&) = default;
@@ -51,6 +59,8 @@ namespace wi
 		void SetReadModeAndResetPos(bool isReadMode);
 		// Check if the archive has any data
 		bool IsOpen() const { return data_ptr != nullptr; };
+		// Check if the archive data is a memory mapped file
+		bool IsFileMapped() const { return mapped_file != nullptr; }
 		// Close the archive.
 		//	If it was opened from a file in write mode, the file will be written at this point
 		//	The data will be deleted, the archive will be empty after this
@@ -58,6 +68,15 @@ namespace wi
 		// Write the archive contents to a specific file
 		//	The archive data will be written starting from the beginning, to the current position
 		bool SaveFile(const std::string& fileName);
+		// Write the archive contents to a specific file in block compressed format
+		//	The file can be opened the same way as uncompressed archive files, positions within the archive are not affected by the compression
+		//	level : compression level in range [1, 22], higher levels are slower to save but result in smaller files, decompression speed is similar for all levels
+		bool SaveFileCompressed(const std::string& fileName, int level = 3);
+		// Enable or disable block compression of the file that will be written when the archive is closed (for archives that were opened with a file name in write mode)
+		void SetFileCompressionEnabled(bool value) { compressed_file = value; }
+		// Read mode: returns true if the archive was opened from a block compressed file
+		//	Write mode: returns true if the file will be block compressed when the archive is closed
+		bool IsFileCompressed() const { return compressed_file; }
 		// Write the archive contents into a C++ header file
 		//	dataName : it will be the name of the byte data array in the header, that can be memory mapped
 		bool SaveHeaderFile(const std::string& fileName, const std::string& dataName);
@@ -67,6 +86,13 @@ namespace wi
 		//	The file's name will include the directory as well
 		const std::string& GetSourceFileName() const;
 
+		// Enable or disable memory mapping of files that are opened in read mode (enabled by default)
+		//	Memory mapping avoids reading the whole file into a separate allocation, the pages are loaded on demand and shared with the OS file cache
+		//	It is currently supported on Linux, other platforms (or mapping failure) will fall back to reading the whole file
+		//	The file must not be modified while an archive is mapping it
+		static void SetFileMappingEnabled(bool value);
+		static bool IsFileMappingEnabled();
+
 		// Appends the current archive write offset as uint64_t to the archive
 		//	Returns the previous write offset of the archive, which can be used by PatchUnknownJumpPosition()
 		//	to write the current archive position to that previous position
@@ -214,11 +240,19 @@ namespace wi
 		template<typename T>
 		inline Archive& operator<<(const wi::vector<T>& data)
 		{
-			// Here we will use the << operator so that non-specified types will have compile error!
 			(*this) << data.size();
-			for (const T& x : data)
+			if constexpr (is_raw_serialized<T>)
 			{
-				(*this) << x;
+				// The elements would be written one by one with the same layout, so they are copied at once:
+				_write_bytes(data.data(), data.size() * sizeof(T));
+			}
+			else
+			{
+				// Here we will use the << operator so that non-specified types will have compile error!
+				for (const T& x : data)
+				{
+					(*this) << x;
+				}
 			}
 			return *this;
 		}
@@ -366,17 +400,74 @@ namespace wi
 		template<typename T>
 		inline Archive& operator>>(wi::vector<T>& data)
 		{
-			// Here we will use the >> operator so that non-specified types will have compile error!
 			size_t count;
 			(*this) >> count;
 			data.resize(count);
-			for (size_t i = 0; i < count; ++i)
+			if constexpr (is_raw_serialized<T>)
 			{
-				(*this) >> data[i];
+				_read_bytes(data.data(), count * sizeof(T));
+			}
+			else
+			{
+				// Here we will use the >> operator so that non-specified types will have compile error!
+				for (size_t i = 0; i < count; ++i)
+				{
+					(*this) >> data[i];
+				}
 			}
 			return *this;
 		}
 
+		// Bulk array serialization, intended for large arrays like vertex and index buffers:
+		//	From archive version 91, the element count is followed by padding to a 16-byte aligned archive offset, then the elements are copied with their exact memory layout
+		//	Earlier archive versions are using the element by element serialization of the << and >> operators
+		template<typename T>
+		inline void WriteArray(const wi::vector<T>& data)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			if (GetVersion() < 91)
+			{
+				(*this) << data;
+				return;
+			}
+			_write(uint64_t(data.size()));
+			_write_padding(array_alignment);
+			_write_bytes(data.data(), data.size() * sizeof(T));
+		}
+		template<typename T>
+		inline void ReadArray(wi::vector<T>& data)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			if (GetVersion() < 91)
+			{
+				(*this) >> data;
+				return;
+			}
+			uint64_t count;
+			_read(count);
+			pos = _align(pos, array_alignment);
+			data.resize((size_t)count);
+			_read_bytes(data.data(), data.size() * sizeof(T));
+		}
+		// Reads an array that was written with WriteArray() without copying it
+		//	The result points into the archive data and it remains valid while the archive data exists
+		//	The result is aligned to 16 bytes if the archive data is aligned (file and DATA based archives are)
+		//	Returns false and doesn't read anything if the archive version doesn't support it, ReadArray() must be used in that case
+		template<typename T>
+		inline bool ReadArrayView(const T*& data, size_t& count)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			if (GetVersion() < 91)
+				return false;
+			uint64_t _count;
+			_read(_count);
+			pos = _align(pos, array_alignment);
+			data = (const T*)(data_ptr + pos);
+			count = (size_t)_count;
+			pos += count * sizeof(T);
+			return true;
+		}
+
 
 
 	private:
@@ -385,6 +476,30 @@ namespace wi
 		// Any specific type serialization should be implemented by hand
 		// But these can be used as helper functions inside this class
 
+		// Types that the << and >> operators serialize with their exact memory layout, so arrays of them can be copied at once
+		template<typename T>
+		static constexpr bool is_raw_serialized =
+			std::is_same_v<T, char> ||
+			std::is_same_v<T, unsigned char> ||
+			std::is_same_v<T, float> ||
+			std::is_same_v<T, double> ||
+			std::is_same_v<T, XMFLOAT2> ||
+			std::is_same_v<T, XMFLOAT3> ||
+			std::is_same_v<T, XMFLOAT4> ||
+			std::is_same_v<T, XMFLOAT3X3> ||
+			std::is_same_v<T, XMFLOAT4X3> ||
+			std::is_same_v<T, XMFLOAT4X4> ||
+			std::is_same_v<T, XMUINT2> ||
+			std::is_same_v<T, XMUINT3> ||
+			std::is_same_v<T, XMUINT4> ||
+			std::is_same_v<T, wi::Color>;
+
+		static constexpr size_t array_alignment = 16;
+		static constexpr size_t _align(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
 		// Write data using memory operations
 		template<typename T>
 		inline void _write(const T& data)
@@ -401,6 +516,32 @@ namespace wi
 			pos = _right;
 		}
 
+		// Write a block of memory
+		inline void _write_bytes(const void* data, size_t size)
+		{
+			assert(!readMode);
+			assert(!DATA.empty());
+			const size_t _right = pos + size;
+			if (_right > DATA.size())
+			{
+				DATA.resize(_right * 2);
+				data_ptr = DATA.data();
+			}
+			if (size > 0)
+			{
+				std::memcpy(DATA.data() + pos, data, size);
+			}
+			pos = _right;
+		}
+
+		// Write zeroes until the position is aligned
+		inline void _write_padding(size_t alignment)
+		{
+			static constexpr uint8_t zeroes[array_alignment] = {};
+			assert(alignment <= array_alignment);
+			_write_bytes(zeroes, _align(pos, alignment) - pos);
+		}
+
 		// Read data using memory operations
 		template<typename T>
 		inline void _read(T& data)
@@ -410,5 +551,17 @@ namespace wi
 			data = *(const T*)(data_ptr + pos);
 			pos += (size_t)(sizeof(data));
 		}
+
+		// Read a block of memory
+		inline void _read_bytes(void* data, size_t size)
+		{
+			assert(readMode);
+			assert(data_ptr != nullptr);
+			if (size > 0)
+			{
+				std::memcpy(data, data_ptr + pos, size);
+			}
+			pos += size;
+		}
 	};
 }
@@ -1,10 +1,11 @@
 #pragma once
 #include "CommonInclude.h"
 #include "wiPrimitive.h"
+#include "wiJobSystem.h"
 
 namespace wi
 {
-	// Simple fast update BVH
+	// Simple BVH built with binned SAH
 	//	https://jacco.ompf2.com/2022/04/13/how-to-build-a-bvh-part-1-basics/
 	struct BVH
 	{
@@ -23,14 +24,27 @@ namespace wi
 		uint32_t leaf_count = 0;
 		const wi::primitive::AABB* leaf_aabb_data = nullptr;
 
-		void Build(const wi::primitive::AABB* aabbs, uint32_t aabb_count)
+		constexpr bool IsValid() const { return node_count > 0; }
+		void Clear()
 		{
 			node_count = 0;
+			leaf_count = 0;
+			leaf_aabb_data = nullptr;
+		}
+
+		// Subtrees with at least this many leaves are built in parallel by the job system
+		static constexpr uint32_t parallel_build_threshold = 16 * 1024;
+
+		// Builds the tree for an array of AABBs, the AABBs must be kept alive while the BVH is used
+		//	priority	: priority of the jobs that build the large subtrees in parallel
+		void Build(const wi::primitive::AABB* aabbs, uint32_t aabb_count, wi::jobsystem::Priority priority = wi::jobsystem::Priority::Normal)
+		{
+			Clear();
 			if (aabb_count == 0)
 				return;
 
 			const uint32_t node_capacity = aabb_count * 2 - 1;
-			allocation.reserve(
+			allocation.resize(
 				sizeof(Node) * node_capacity +
 				sizeof(uint32_t) * aabb_count
 			);
@@ -39,7 +53,7 @@ namespace wi
 			leaf_count = aabb_count;
 			leaf_aabb_data = aabbs;
 
-			Node& node = nodes[node_count++];
+			Node& node = nodes[0];
 			node.aabb = {};
 			node.offset = 0;
 			node.count = aabb_count;
@@ -48,31 +62,139 @@ namespace wi
 				node.aabb = wi::primitive::AABB::Merge(node.aabb, aabbs[i]);
 				leaf_indices[i] = i;
 			}
-			Subdivide(0);
+
+			// Nodes are allocated in pairs from an atomic counter, so subtrees can be subdivided concurrently:
+			std::atomic<uint32_t> node_allocator{ 1 };
+			wi::jobsystem::context ctx;
+			ctx.priority = priority;
+			ctx.name = "BVH::Build";
+			Subdivide(0, node_allocator, ctx);
+			wi::jobsystem::Wait(ctx);
+			node_count = node_allocator.load();
+		}
+
+		// Half surface area of the box, it is proportional to the probability of hitting it in the surface area heuristic (SAH)
+		static float SurfaceArea(const XMVECTOR& _min, const XMVECTOR& _max)
+		{
+			const XMVECTOR extent = XMVectorMax(XMVectorZero(), _max - _min);
+			return XMVectorGetX(XMVector3Dot(extent, XMVectorSwizzle<1, 2, 0, 3>(extent)));
+		}
+		static float SurfaceArea(const wi::primitive::AABB& aabb)
+		{
+			return SurfaceArea(XMLoadFloat3(&aabb._min), XMLoadFloat3(&aabb._max));
 		}
 
-		void Subdivide(uint32_t nodeIndex)
+		// The split plane is chosen by binning the leaf centers along each axis and picking the boundary with the lowest SAH cost
+		//	https://jacco.ompf2.com/2022/04/21/how-to-build-a-bvh-part-3-quick-builds/
+		static constexpr uint32_t bin_count = 16;
+
+		void Subdivide(uint32_t nodeIndex, std::atomic<uint32_t>& node_allocator, wi::jobsystem::context& ctx)
 		{
 			Node& node = nodes[nodeIndex];
 			if (node.count <= 2)
 				return;
 
-			XMFLOAT3 extent = node.aabb.getHalfWidth();
-			XMFLOAT3 min = node.aabb.getMin();
-			int axis = 0;
-			if (extent.y > extent.x) axis = 1;
-			if (extent.z > ((float*)&extent)[axis]) axis = 2;
-			float splitPos = ((float*)&min)[axis] + ((float*)&extent)[axis] * 0.5f;
+			XMVECTOR center_min = XMVectorReplicate(std::numeric_limits<float>::max());
+			XMVECTOR center_max = XMVectorReplicate(std::numeric_limits<float>::lowest());
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				const wi::primitive::AABB& aabb = leaf_aabb_data[leaf_indices[node.offset + i]];
+				const XMVECTOR center = XMLoadFloat3(&aabb._min) + XMLoadFloat3(&aabb._max);
+				center_min = XMVectorMin(center_min, center);
+				center_max = XMVectorMax(center_max, center);
+			}
+			center_min *= 0.5f;
+			center_max *= 0.5f;
+
+			// All three axes are binned in one pass over the leaves:
+			const XMVECTOR extent = center_max - center_min;
+			const XMVECTOR scale = XMVectorSelect(XMVectorZero(), XMVectorReplicate(float(bin_count)) / extent, XMVectorGreater(extent, XMVectorZero()));
+			XMVECTOR bin_min[3][bin_count];
+			XMVECTOR bin_max[3][bin_count];
+			uint32_t bin_leaf_count[3][bin_count] = {};
+			for (int a = 0; a < 3; ++a)
+			{
+				for (uint32_t bin = 0; bin < bin_count; ++bin)
+				{
+					bin_min[a][bin] = XMVectorReplicate(std::numeric_limits<float>::max());
+					bin_max[a][bin] = XMVectorReplicate(std::numeric_limits<float>::lowest());
+				}
+			}
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				const wi::primitive::AABB& aabb = leaf_aabb_data[leaf_indices[node.offset + i]];
+				const XMVECTOR _min = XMLoadFloat3(&aabb._min);
+				const XMVECTOR _max = XMLoadFloat3(&aabb._max);
+				XMFLOAT3 bin_position;
+				XMStoreFloat3(&bin_position, ((_min + _max) * 0.5f - center_min) * scale);
+				for (int a = 0; a < 3; ++a)
+				{
+					const uint32_t bin = std::min(bin_count - 1, uint32_t(((float*)&bin_position)[a]));
+					bin_min[a][bin] = XMVectorMin(bin_min[a][bin], _min);
+					bin_max[a][bin] = XMVectorMax(bin_max[a][bin], _max);
+					bin_leaf_count[a][bin]++;
+				}
+			}
 
-			// in-place partition
+			int axis = -1;
+			uint32_t split_bin = 0;
+			float best_cost = node.count * SurfaceArea(node.aabb); // cost of not splitting
+			for (int a = 0; a < 3; ++a)
+			{
+				if (XMVectorGetByIndex(scale, a) == 0)
+					continue; // all centers are on the same plane
+
+				// Sweep from both sides to get the cost of every boundary between the bins:
+				float left_area[bin_count - 1];
+				float right_area[bin_count - 1];
+				uint32_t left_count[bin_count - 1];
+				uint32_t right_count[bin_count - 1];
+				XMVECTOR left_min = XMVectorReplicate(std::numeric_limits<float>::max());
+				XMVECTOR left_max = XMVectorReplicate(std::numeric_limits<float>::lowest());
+				XMVECTOR right_min = left_min;
+				XMVECTOR right_max = left_max;
+				uint32_t left_sum = 0;
+				uint32_t right_sum = 0;
+				for (uint32_t i = 0; i < bin_count - 1; ++i)
+				{
+					left_sum += bin_leaf_count[a][i];
+					left_count[i] = left_sum;
+					left_min = XMVectorMin(left_min, bin_min[a][i]);
+					left_max = XMVectorMax(left_max, bin_max[a][i]);
+					left_area[i] = SurfaceArea(left_min, left_max);
+					right_sum += bin_leaf_count[a][bin_count - 1 - i];
+					right_count[bin_count - 2 - i] = right_sum;
+					right_min = XMVectorMin(right_min, bin_min[a][bin_count - 1 - i]);
+					right_max = XMVectorMax(right_max, bin_max[a][bin_count - 1 - i]);
+					right_area[bin_count - 2 - i] = SurfaceArea(right_min, right_max);
+				}
+				for (uint32_t i = 0; i < bin_count - 1; ++i)
+				{
+					if (left_count[i] == 0 || right_count[i] == 0)
+						continue;
+					const float cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+					if (cost < best_cost)
+					{
+						best_cost = cost;
+						axis = a;
+						split_bin = i;
+					}
+				}
+			}
+			if (axis < 0)
+				return; // splitting would not be cheaper than keeping this as a leaf
+
+			// in-place partition, with the same bin computation as above:
 			int i = node.offset;
 			int j = i + node.count - 1;
 			while (i <= j)
 			{
-				XMFLOAT3 center = leaf_aabb_data[leaf_indices[i]].getCenter();
-				float value = ((float*)&center)[axis];
+				const wi::primitive::AABB& aabb = leaf_aabb_data[leaf_indices[i]];
+				XMFLOAT3 bin_position;
+				XMStoreFloat3(&bin_position, ((XMLoadFloat3(&aabb._min) + XMLoadFloat3(&aabb._max)) * 0.5f - center_min) * scale);
+				const uint32_t bin = std::min(bin_count - 1, uint32_t(((float*)&bin_position)[axis]));
 
-				if (value < splitPos)
+				if (bin <= split_bin)
 				{
 					i++;
 				}
@@ -88,20 +210,52 @@ namespace wi
 				return;
 
 			// create child nodes
-			uint32_t left_child_index = node_count++;
-			uint32_t right_child_index = node_count++;
+			uint32_t left_child_index = node_allocator.fetch_add(2);
+			uint32_t right_child_index = left_child_index + 1;
 			node.left = left_child_index;
 			nodes[left_child_index].offset = node.offset;
 			nodes[left_child_index].count = leftCount;
 			nodes[right_child_index].offset = i;
 			nodes[right_child_index].count = node.count - leftCount;
 			node.count = 0;
-			UpdateNodeBounds(left_child_index);
-			UpdateNodeBounds(right_child_index);
 
-			// recurse
-			Subdivide(left_child_index);
-			Subdivide(right_child_index);
+			// The child bounds are the merged bounds of the bins on each side:
+			XMVECTOR left_min = XMVectorReplicate(std::numeric_limits<float>::max());
+			XMVECTOR left_max = XMVectorReplicate(std::numeric_limits<float>::lowest());
+			XMVECTOR right_min = left_min;
+			XMVECTOR right_max = left_max;
+			for (uint32_t bin = 0; bin < bin_count; ++bin)
+			{
+				if (bin <= split_bin)
+				{
+					left_min = XMVectorMin(left_min, bin_min[axis][bin]);
+					left_max = XMVectorMax(left_max, bin_max[axis][bin]);
+				}
+				else
+				{
+					right_min = XMVectorMin(right_min, bin_min[axis][bin]);
+					right_max = XMVectorMax(right_max, bin_max[axis][bin]);
+				}
+			}
+			nodes[left_child_index].aabb = {};
+			nodes[right_child_index].aabb = {};
+			XMStoreFloat3(&nodes[left_child_index].aabb._min, left_min);
+			XMStoreFloat3(&nodes[left_child_index].aabb._max, left_max);
+			XMStoreFloat3(&nodes[right_child_index].aabb._min, right_min);
+			XMStoreFloat3(&nodes[right_child_index].aabb._max, right_max);
+
+			// recurse, large subtrees on other threads:
+			if (nodes[left_child_index].count >= parallel_build_threshold)
+			{
+				wi::jobsystem::Execute(ctx, [this, left_child_index, &node_allocator, &ctx](wi::jobsystem::JobArgs args) {
+					Subdivide(left_child_index, node_allocator, ctx);
+				});
+			}
+			else
+			{
+				Subdivide(left_child_index, node_allocator, ctx);
+			}
+			Subdivide(right_child_index, node_allocator, ctx);
 		}
 
 		void UpdateNodeBounds(uint32_t nodeIndex)
@@ -116,24 +270,176 @@ namespace wi
 			}
 		}
 
-		template <typename T>
+		// Recomputes the node bounds from the leaf AABBs without changing the tree structure
+		//	This is much faster than Build(), but the tree quality degrades as the leaves move away from where they were at build time
+		//	aabbs	: the updated leaf AABBs, the count must be the same as at build time
+		void Refit(const wi::primitive::AABB* aabbs)
+		{
+			leaf_aabb_data = aabbs;
+			// Child nodes are always allocated after their parent, so a reverse iteration is bottom-up:
+			for (uint32_t nodeIndex = node_count; nodeIndex > 0; --nodeIndex)
+			{
+				Node& node = nodes[nodeIndex - 1];
+				if (node.isLeaf())
+				{
+					UpdateNodeBounds(nodeIndex - 1);
+				}
+				else
+				{
+					node.aabb = wi::primitive::AABB::Merge(nodes[node.left].aabb, nodes[node.left + 1].aabb);
+				}
+			}
+		}
+
+		// Returns the SAH cost of the tree relative to the surface area of the root
+		//	It can be compared to the cost after the build to decide whether refitted tree should be rebuilt
+		float GetCost() const
+		{
+			if (!IsValid())
+				return 0;
+			const float root_area = SurfaceArea(nodes[0].aabb);
+			if (root_area <= 0)
+				return 0;
+			float cost = 0;
+			for (uint32_t nodeIndex = 0; nodeIndex < node_count; ++nodeIndex)
+			{
+				const Node& node = nodes[nodeIndex];
+				cost += SurfaceArea(node.aabb) * (node.isLeaf() ? node.count : 1);
+			}
+			return cost / root_area;
+		}
+
+		// The leaves of a subtree are stored contiguously in leaf_indices, this returns their range
+		void GetLeafRange(uint32_t nodeIndex, uint32_t& offset, uint32_t& count) const
+		{
+			const Node* node = &nodes[nodeIndex];
+			offset = node->offset;
+			while (!node->isLeaf())
+			{
+				node = &nodes[node->left + 1];
+			}
+			count = node->offset + node->count - offset;
+		}
+
+		// Entry distance of the ray into the box within [TMin, TMax], or std::numeric_limits<float>::max() if it misses it
+		static float RayDistance(const wi::primitive::Ray& ray, const wi::primitive::AABB& aabb)
+		{
+			const XMVECTOR origin = XMLoadFloat3(&ray.origin);
+			const XMVECTOR direction_inverse = XMLoadFloat3(&ray.direction_inverse);
+			const XMVECTOR t1 = (XMLoadFloat3(&aabb._min) - origin) * direction_inverse;
+			const XMVECTOR t2 = (XMLoadFloat3(&aabb._max) - origin) * direction_inverse;
+			const XMVECTOR tmin = XMVectorMin(t1, t2);
+			const XMVECTOR tmax = XMVectorMax(t1, t2);
+			const float tnear = std::max(std::max(XMVectorGetX(tmin), XMVectorGetY(tmin)), std::max(XMVectorGetZ(tmin), ray.TMin));
+			const float tfar = std::min(std::min(XMVectorGetX(tmax), XMVectorGetY(tmax)), std::min(XMVectorGetZ(tmax), ray.TMax));
+			if (tnear > tfar)
+				return std::numeric_limits<float>::max();
+			return tnear;
+		}
+
+		// Calls callback(uint32_t index) for every leaf in the nodes that intersect the primitive
+		//	The primitive can be any type that AABB::intersects() accepts
+		template <typename T, typename F>
 		void Intersects(
 			const T& primitive,
 			uint32_t nodeIndex,
-			const std::function<void(uint32_t index)>& callback
-		)
+			F&& callback
+		) const
 		{
-			Node& node = nodes[nodeIndex];
-			if (!node.aabb.intersects(primitive))
-				return;
-			if (node.isLeaf())
+			uint32_t stack[64];
+			uint32_t stack_size = 0;
+			stack[stack_size++] = nodeIndex;
+			while (stack_size > 0)
 			{
-				callback(leaf_indices[node.offset]);
+				const Node& node = nodes[stack[--stack_size]];
+				if (!node.aabb.intersects(primitive))
+					continue;
+				if (node.isLeaf())
+				{
+					for (uint32_t i = 0; i < node.count; ++i)
+					{
+						callback(leaf_indices[node.offset + i]);
+					}
+				}
+				else if (stack_size + 2 <= arraysize(stack))
+				{
+					stack[stack_size++] = node.left + 1;
+					stack[stack_size++] = node.left;
+				}
+				else
+				{
+					// very deep trees continue in a nested traversal when the stack is full:
+					Intersects(primitive, node.left, callback);
+					Intersects(primitive, node.left + 1, callback);
+				}
 			}
-			else
+		}
+
+		// Nearest hit query along a ray: nodes are visited front to back and skipped when they are farther than the closest hit so far
+		//	closest		: the closest hit distance, it should be initialized to the maximum distance of interest
+		//	callback	: callback(uint32_t index, float& closest) is called for the leaves, it must reduce closest when it finds a closer hit
+		template <typename F>
+		void IntersectsClosest(
+			const wi::primitive::Ray& ray,
+			uint32_t nodeIndex,
+			float& closest,
+			F&& callback
+		) const
+		{
+			const float distance = RayDistance(ray, nodes[nodeIndex].aabb);
+			if (distance >= closest)
+				return;
+			struct Entry
+			{
+				uint32_t nodeIndex;
+				float distance;
+			};
+			Entry stack[64];
+			uint32_t stack_size = 0;
+			stack[stack_size++] = { nodeIndex, distance };
+			while (stack_size > 0)
 			{
-				Intersects(primitive, node.left, callback);
-				Intersects(primitive, node.left + 1, callback);
+				const Entry entry = stack[--stack_size];
+				if (entry.distance >= closest)
+					continue;
+				const Node& node = nodes[entry.nodeIndex];
+				if (node.isLeaf())
+				{
+					for (uint32_t i = 0; i < node.count; ++i)
+					{
+						callback(leaf_indices[node.offset + i], closest);
+					}
+					continue;
+				}
+				Entry near_entry = { node.left, RayDistance(ray, nodes[node.left].aabb) };
+				Entry far_entry = { node.left + 1, RayDistance(ray, nodes[node.left + 1].aabb) };
+				if (far_entry.distance < near_entry.distance)
+				{
+					std::swap(near_entry, far_entry);
+				}
+				// the nearer child is pushed last, so it is visited first:
+				if (far_entry.distance < closest)
+				{
+					if (stack_size < arraysize(stack))
+					{
+						stack[stack_size++] = far_entry;
+					}
+					else
+					{
+						IntersectsClosest(ray, far_entry.nodeIndex, closest, callback);
+					}
+				}
+				if (near_entry.distance < closest)
+				{
+					if (stack_size < arraysize(stack))
+					{
+						stack[stack_size++] = near_entry;
+					}
+					else
+					{
+						IntersectsClosest(ray, near_entry.nodeIndex, closest, callback);
+					}
+				}
 			}
 		}
 	};
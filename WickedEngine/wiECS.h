@@ -2,13 +2,17 @@
 #define WI_ENTITY_COMPONENT_SYSTEM_H
 
 #include "wiArchive.h"
+#include "wiBacklog.h"
 #include "wiJobSystem.h"
+#include "wiSpinLock.h"
 #include "wiUnorderedMap.h"
 #include "wiVector.h"
 
 #include <cstdint>
 #include <cassert>
 #include <atomic>
+#include <algorithm>
+#include <mutex>
 #include <memory>
 #include <string>
 
@@ -16,16 +20,126 @@
 namespace wi::ecs
 {
 	// The Entity is a global unique persistent identifier within the entity-component system
-	//	It can be stored and used for the duration of the application
+	//	It can be stored and used for the duration of the application, unless it is destroyed with DestroyEntity()
 	//	The entity can be a different value on a different run of the application, if it was serialized
 	//	It must be only serialized with the SerializeEntity() function. It will ensure that entities still match with their components correctly after serialization
 	using Entity = uint32_t;
 	static const Entity INVALID_ENTITY = 0;
+
+	// The entity value is made of an index in the lower bits and a generation in the upper bits
+	//	The index of a destroyed entity can be reused by a new entity, but with an incremented generation,
+	//	so handles that were kept to the destroyed entity will not refer to the new entity
+	//	The generation is 8 bits, so it wraps around after an index was reused 256 times, after that a stale handle can match a new entity again
+	static constexpr uint32_t ENTITY_INDEX_BITS = 24;
+	static constexpr Entity ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+	constexpr uint32_t GetEntityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+	constexpr uint32_t GetEntityGeneration(Entity entity) { return entity >> ENTITY_INDEX_BITS; }
+
+	struct EntityAllocator
+	{
+		// Destroyed entities are only reused when this many are waiting, so the same index is not recycled
+		//	in quick succession, which makes it unlikely that a stale handle matches after the generation wraps around
+		static constexpr size_t recycle_threshold = 1024;
+		// When the new indices are running out, destroyed entities are reused immediately instead of waiting for the threshold
+		static constexpr uint32_t recycle_always_index = ENTITY_INDEX_MASK - (ENTITY_INDEX_MASK >> 3);
+
+		std::atomic<uint32_t> next_index{ GetEntityIndex(INVALID_ENTITY) + 1 };
+		std::atomic<size_t> free_count{ 0 };
+		std::atomic_bool exhausted_reported{ false };
+		wi::SpinLock locker;
+		wi::vector<Entity> free_list; // ring buffer, recycled in FIFO order
+		size_t free_head = 0;
+		wi::vector<uint8_t> generations; // current generation of the indices up to the highest destroyed one, to ignore destroying an entity more than once
+
+		static EntityAllocator& Get()
+		{
+			static EntityAllocator allocator;
+			return allocator;
+		}
+	};
+
+	// Reuses the oldest destroyed entity if more than threshold are waiting, returns INVALID_ENTITY otherwise
+	inline Entity RecycleEntity(EntityAllocator& allocator, size_t threshold)
+	{
+		if (allocator.free_count.load(std::memory_order_relaxed) <= threshold)
+			return INVALID_ENTITY;
+		std::scoped_lock lock(allocator.locker);
+		const size_t free_count = allocator.free_count.load(std::memory_order_relaxed);
+		if (free_count <= threshold)
+			return INVALID_ENTITY;
+		const Entity entity = allocator.free_list[allocator.free_head];
+		allocator.free_head = (allocator.free_head + 1) % allocator.free_list.size();
+		allocator.free_count.store(free_count - 1, std::memory_order_relaxed);
+		return entity;
+	}
+
 	// Runtime can create a new entity with this
 	inline Entity CreateEntity()
 	{
-		static std::atomic<Entity> next{ INVALID_ENTITY + 1 };
-		return next.fetch_add(1);
+		EntityAllocator& allocator = EntityAllocator::Get();
+		uint32_t index = allocator.next_index.load(std::memory_order_relaxed);
+		const size_t threshold = index < EntityAllocator::recycle_always_index ? EntityAllocator::recycle_threshold : 0;
+		Entity entity = RecycleEntity(allocator, threshold);
+		if (entity != INVALID_ENTITY)
+			return entity;
+
+		// The counter is never incremented past the last valid index, so it can't overflow into the generation bits:
+		while (index <= ENTITY_INDEX_MASK)
+		{
+			if (allocator.next_index.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+				return index;
+		}
+
+		// All indices are used, another thread could have destroyed an entity since the first check:
+		entity = RecycleEntity(allocator, 0);
+		if (entity != INVALID_ENTITY)
+			return entity;
+		if (!allocator.exhausted_reported.exchange(true))
+		{
+			wi::backlog::post("wi::ecs::CreateEntity() failed: out of entity indices! Entities must be removed with Scene::Entity_Remove(), Scene::Clear() or DestroyEntity() so that their indices can be reused.", wi::backlog::LogLevel::Error);
+		}
+		return INVALID_ENTITY;
+	}
+
+	// Releases the entities so that their indices can be reused by CreateEntity() with the next generation
+	//	The entities must not have components in any ComponentManager, and must not be used after this
+	//	Entities that were already destroyed, and the ones that were not created by CreateEntity() in this run (eg. deserialized without remapping) are ignored
+	inline void DestroyEntities(const Entity* entities, size_t count)
+	{
+		EntityAllocator& allocator = EntityAllocator::Get();
+		const uint32_t next_index = allocator.next_index.load(std::memory_order_relaxed);
+		std::scoped_lock lock(allocator.locker);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Entity entity = entities[i];
+			const uint32_t index = GetEntityIndex(entity);
+			if (index == GetEntityIndex(INVALID_ENTITY) || index >= next_index)
+				continue;
+			if (allocator.generations.size() <= index)
+			{
+				allocator.generations.resize(std::max(size_t(index) + 1, std::min(size_t(next_index), allocator.generations.size() * 2)));
+			}
+			if (allocator.generations[index] != GetEntityGeneration(entity))
+				continue;
+			const uint32_t generation = (GetEntityGeneration(entity) + 1) & (~0u >> ENTITY_INDEX_BITS);
+			allocator.generations[index] = uint8_t(generation);
+			const Entity recycled = index | (generation << ENTITY_INDEX_BITS);
+
+			const size_t free_count = allocator.free_count.load(std::memory_order_relaxed);
+			if (free_count == allocator.free_list.size())
+			{
+				// Grow the ring buffer, unwrapping it so that the FIFO order is kept:
+				std::rotate(allocator.free_list.begin(), allocator.free_list.begin() + allocator.free_head, allocator.free_list.end());
+				allocator.free_head = 0;
+				allocator.free_list.resize(std::max(EntityAllocator::recycle_threshold * 2, allocator.free_list.size() * 2));
+			}
+			allocator.free_list[(allocator.free_head + free_count) % allocator.free_list.size()] = recycled;
+			allocator.free_count.store(free_count + 1, std::memory_order_relaxed);
+		}
+	}
+	inline void DestroyEntity(Entity entity)
+	{
+		DestroyEntities(&entity, 1);
 	}
 
 	struct EntitySerializer
@@ -35,6 +149,11 @@ namespace wi::ecs
 		bool allow_remap = true;
 		uint64_t version = 0; // The ComponentLibrary serialization will modify this by the registered component's version number
 
+		// If this is set, the entities are remapped by the shared serializer, and the own remap is used as a cache
+		//	This way multiple serializers can be used concurrently while creating the same entity mapping
+		EntitySerializer* shared = nullptr;
+		wi::SpinLock locker; // protects the remap while other serializers are sharing it
+
 		~EntitySerializer()
 		{
 			wi::jobsystem::Wait(ctx); // automatically wait for all subtasks after serialization
@@ -59,14 +178,31 @@ namespace wi::ecs
 			if (mem != INVALID_ENTITY && seri.allow_remap)
 			{
 				auto it = seri.remap.find(mem);
-				if (it == seri.remap.end())
+				if (it != seri.remap.end())
+				{
+					entity = it->second;
+				}
+				else if (seri.shared == nullptr)
 				{
 					entity = CreateEntity();
 					seri.remap[mem] = entity;
 				}
 				else
 				{
-					entity = it->second;
+					EntitySerializer& shared = *seri.shared;
+					shared.locker.lock();
+					auto it_shared = shared.remap.find(mem);
+					if (it_shared == shared.remap.end())
+					{
+						entity = CreateEntity();
+						shared.remap[mem] = entity;
+					}
+					else
+					{
+						entity = it_shared->second;
+					}
+					shared.locker.unlock();
+					seri.remap[mem] = entity;
 				}
 			}
 			else
@@ -89,6 +225,185 @@ namespace wi::ecs
 		}
 	}
 
+	// Lookup tables that map entities to component indices in the ComponentManager:
+
+	// Hash map lookup (default): memory is proportional to the number of components
+	class HashLookup
+	{
+	public:
+		inline void Reserve(size_t count) { map.reserve(count); }
+		inline void Clear() { map.clear(); }
+
+		// Returns the component index of the entity, or ~0ull if it is not found
+		inline size_t Find(Entity entity) const
+		{
+			if (map.empty())
+				return ~0ull;
+			const auto it = map.find(entity);
+			if (it != map.end())
+			{
+				return it->second;
+			}
+			return ~0ull;
+		}
+		inline void Set(Entity entity, size_t index) { map[entity] = index; }
+		inline void Erase(Entity entity) { map.erase(entity); }
+		inline bool IsEmpty() const { return map.empty(); }
+		inline size_t GetCount() const { return map.size(); }
+
+		// Approximate memory usage in bytes (assuming an open addressing table with a metadata byte per slot)
+		inline size_t GetMemoryUsage() const
+		{
+			const size_t slots = size_t(map.size() / map.max_load_factor());
+			return sizeof(*this) + slots * (sizeof(std::pair<Entity, size_t>) + alignof(size_t));
+		}
+
+	private:
+		wi::unordered_map<Entity, size_t> map;
+	};
+
+	// Paged sparse set lookup: the entity index selects a page and a slot inside it, which stores the entity and component index
+	//	Lookups don't need hashing or probing, but memory is proportional to the range of entity values that have this component,
+	//	so it is best for components that most entities have, and which are looked up in hot loops (transforms, hierarchy...)
+	//	Pages are allocated when the first entity of their range gets a component, and freed when the last one is removed
+	//	The stored entity is compared on lookup, so a stale handle with an older generation of a recycled index is not found
+	//	If the slot is used by an other entity with the same index (a different generation, or a deserialized entity that was not remapped),
+	//	the entity is stored in a hash map instead
+	class PagedLookup
+	{
+	public:
+		static constexpr uint32_t page_bits = 10;
+		static constexpr uint32_t page_size = 1u << page_bits;
+		static constexpr uint32_t invalid = ~0u;
+
+		struct Slot
+		{
+			Entity entity = INVALID_ENTITY;
+			uint32_t index = invalid;
+		};
+
+		inline void Reserve(size_t count) {}
+		inline void Clear()
+		{
+			pages.clear();
+			page_counts.clear();
+			collisions.clear();
+			count = 0;
+		}
+
+		// Returns the component index of the entity, or ~0ull if it is not found
+		inline size_t Find(Entity entity) const
+		{
+			const uint32_t entity_index = GetEntityIndex(entity);
+			const size_t page = size_t(entity_index >> page_bits);
+			if (page < pages.size() && !pages[page].empty())
+			{
+				const Slot& slot = pages[page][entity_index & (page_size - 1)];
+				if (slot.entity == entity && entity != INVALID_ENTITY)
+				{
+					return slot.index;
+				}
+			}
+			if (!collisions.empty())
+			{
+				auto it = collisions.find(entity);
+				if (it != collisions.end())
+				{
+					return it->second;
+				}
+			}
+			return ~0ull;
+		}
+		inline void Set(Entity entity, size_t index)
+		{
+			assert(entity != INVALID_ENTITY);
+			assert(index < invalid);
+			const uint32_t entity_index = GetEntityIndex(entity);
+			const size_t page = size_t(entity_index >> page_bits);
+			if (page >= pages.size())
+			{
+				pages.resize(page + 1);
+				page_counts.resize(page + 1);
+			}
+			if (pages[page].empty())
+			{
+				pages[page].resize(page_size);
+			}
+			Slot& slot = pages[page][entity_index & (page_size - 1)];
+			if (slot.entity == INVALID_ENTITY)
+			{
+				page_counts[page]++;
+				if (collisions.empty() || collisions.erase(entity) == 0)
+				{
+					count++;
+				}
+			}
+			else if (slot.entity != entity)
+			{
+				// An other entity with the same index is stored in the slot:
+				if (collisions.insert_or_assign(entity, (uint32_t)index).second)
+				{
+					count++;
+				}
+				return;
+			}
+			slot.entity = entity;
+			slot.index = (uint32_t)index;
+		}
+		inline void Erase(Entity entity)
+		{
+			const uint32_t entity_index = GetEntityIndex(entity);
+			const size_t page = size_t(entity_index >> page_bits);
+			if (page < pages.size() && !pages[page].empty())
+			{
+				Slot& slot = pages[page][entity_index & (page_size - 1)];
+				if (slot.entity == entity)
+				{
+					slot = {};
+					count--;
+					if (--page_counts[page] == 0)
+					{
+						wi::vector<Slot>().swap(pages[page]); // free the memory of the empty page
+					}
+					return;
+				}
+			}
+			if (!collisions.empty() && collisions.erase(entity) > 0)
+			{
+				count--;
+			}
+		}
+		inline bool IsEmpty() const { return count == 0; }
+		inline size_t GetCount() const { return count; }
+
+		// Memory usage in bytes
+		inline size_t GetMemoryUsage() const
+		{
+			size_t usage = sizeof(*this) + pages.capacity() * sizeof(wi::vector<Slot>) + page_counts.capacity() * sizeof(uint32_t);
+			for (auto& page : pages)
+			{
+				usage += page.capacity() * sizeof(Slot);
+			}
+			usage += size_t(collisions.size() / collisions.max_load_factor()) * (sizeof(std::pair<Entity, uint32_t>) + alignof(uint32_t));
+			return usage;
+		}
+
+	private:
+		wi::vector<wi::vector<Slot>> pages;
+		wi::vector<uint32_t> page_counts; // number of used slots in each page
+		wi::unordered_map<Entity, uint32_t> collisions; // entities whose slot is used by an other entity with the same index
+		size_t count = 0;
+	};
+
+	// The lookup of a ComponentManager is selected by the component type, the default is HashLookup
+	//	It can be changed by specializing this inside the wi::ecs namespace, before the ComponentManager of the type is used:
+	//	template<> struct ComponentLookup<MyComponent> { using type = PagedLookup; };
+	template<typename Component>
+	struct ComponentLookup
+	{
+		using type = HashLookup;
+	};
+
 	// This is an interface class to implement a ComponentManager, 
 	// inherit this class if you want to work with ComponentLibrary
 	class ComponentManager_Interface
@@ -97,6 +412,7 @@ namespace wi::ecs
 		virtual ~ComponentManager_Interface() = default;
 		virtual void Copy(const ComponentManager_Interface& other) = 0;
 		virtual void Merge(ComponentManager_Interface& other) = 0;
+		virtual void MergeRange(ComponentManager_Interface& other, size_t first, size_t count) = 0;
 		virtual void Clear() = 0;
 		virtual void Serialize(wi::Archive& archive, EntitySerializer& seri) = 0;
 		virtual void Component_Serialize(Entity entity, wi::Archive& archive, EntitySerializer& seri) = 0;
@@ -123,7 +439,7 @@ namespace wi::ecs
 		{
 			components.reserve(reservedCount);
 			entities.reserve(reservedCount);
-			lookup.reserve(reservedCount);
+			lookup.Reserve(reservedCount);
 		}
 
 		// Clear the whole container
@@ -131,7 +447,8 @@ namespace wi::ecs
 		{
 			components.clear();
 			entities.clear();
-			lookup.clear();
+			lookup.Clear();
+			structure_version++;
 		}
 
 		// Perform deep copy of all the contents of "other" into this
@@ -141,6 +458,7 @@ namespace wi::ecs
 			components = other.components;
 			entities = other.entities;
 			lookup = other.lookup;
+			structure_version++;
 		}
 
 		// Merge in an other component manager of the same type to this. 
@@ -150,20 +468,39 @@ namespace wi::ecs
 		{
 			components.reserve(GetCount() + other.GetCount());
 			entities.reserve(GetCount() + other.GetCount());
-			lookup.reserve(GetCount() + other.GetCount());
+			lookup.Reserve(GetCount() + other.GetCount());
 
 			for (size_t i = 0; i < other.GetCount(); ++i)
 			{
 				Entity entity = other.entities[i];
 				assert(!Contains(entity));
 				entities.push_back(entity);
-				lookup[entity] = components.size();
+				lookup.Set(entity, components.size());
 				components.push_back(std::move(other.components[i]));
 			}
+			structure_version++;
 
 			other.Clear();
 		}
 
+		// Merge a range of components of an other component manager of the same type to this.
+		//	The other component manager MUST NOT contain any of the same entities!
+		//	The merged components are moved out, but they are not removed from the other component manager, it should be cleared after all of its ranges were merged
+		//	This can be used to split up a big merge into smaller steps
+		inline void MergeRange(ComponentManager<Component>& other, size_t first, size_t count)
+		{
+			const size_t last = std::min(first + count, other.GetCount());
+			for (size_t i = first; i < last; ++i)
+			{
+				Entity entity = other.entities[i];
+				assert(!Contains(entity));
+				entities.push_back(entity);
+				lookup.Set(entity, components.size());
+				components.push_back(std::move(other.components[i]));
+			}
+			structure_version++;
+		}
+
 		inline void Copy(const ComponentManager_Interface& other)
 		{
 			Copy((ComponentManager<Component>&)other);
@@ -174,6 +511,11 @@ namespace wi::ecs
 			Merge((ComponentManager<Component>&)other);
 		}
 
+		inline void MergeRange(ComponentManager_Interface& other, size_t first, size_t count)
+		{
+			MergeRange((ComponentManager<Component>&)other, first, count);
+		}
+
 		// Read/Write everything to an archive depending on the archive state
 		inline void Serialize(wi::Archive& archive, EntitySerializer& seri)
 		{
@@ -196,7 +538,7 @@ namespace wi::ecs
 					Entity entity;
 					SerializeEntity(archive, entity, seri);
 					entities[i] = entity;
-					lookup[entity] = i;
+					lookup.Set(entity, i);
 				}
 			}
 			else
@@ -248,14 +590,14 @@ namespace wi::ecs
 			assert(entity != INVALID_ENTITY);
 
 			// Only one of this component type per entity is allowed!
-			assert(lookup.find(entity) == lookup.end());
+			assert(lookup.Find(entity) == ~0ull);
 
 			// Entity count must always be the same as the number of coponents!
 			assert(entities.size() == components.size());
-			assert(lookup.size() == components.size());
+			assert(lookup.GetCount() == components.size());
 
 			// Update the entity lookup table:
-			lookup[entity] = components.size();
+			lookup.Set(entity, components.size());
 
 			// New components are always pushed to the end:
 			components.emplace_back();
@@ -263,18 +605,18 @@ namespace wi::ecs
 			// Also push corresponding entity:
 			entities.push_back(entity);
 
+			structure_version++;
+
 			return components.back();
 		}
 
 		// Remove a component of a certain entity if it exists
 		inline void Remove(Entity entity)
 		{
-			auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.Find(entity);
+			if (index != ~0ull)
 			{
 				// Directly index into components and entities array:
-				const size_t index = it->second;
-				const Entity entity = entities[index];
 
 				if (index < components.size() - 1)
 				{
@@ -283,25 +625,24 @@ namespace wi::ecs
 					entities[index] = entities.back();
 
 					// Update the lookup table:
-					lookup[entities[index]] = index;
+					lookup.Set(entities[index], index);
 				}
 
 				// Shrink the container:
 				components.pop_back();
 				entities.pop_back();
-				lookup.erase(entity);
+				lookup.Erase(entity);
+				structure_version++;
 			}
 		}
 
 		// Remove a component of a certain entity if it exists while keeping the current ordering
 		inline void Remove_KeepSorted(Entity entity)
 		{
-			auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.Find(entity);
+			if (index != ~0ull)
 			{
 				// Directly index into components and entities array:
-				const size_t index = it->second;
-				const Entity entity = entities[index];
 
 				if (index < components.size() - 1)
 				{
@@ -314,14 +655,15 @@ namespace wi::ecs
 					for (size_t i = index + 1; i < entities.size(); ++i)
 					{
 						entities[i - 1] = entities[i];
-						lookup[entities[i - 1]] = i - 1;
+						lookup.Set(entities[i - 1], i - 1);
 					}
 				}
 
 				// Shrink the container:
 				components.pop_back();
 				entities.pop_back();
-				lookup.erase(entity);
+				lookup.Erase(entity);
+				structure_version++;
 			}
 		}
 
@@ -346,32 +688,29 @@ namespace wi::ecs
 				const size_t next = i + direction;
 				components[i] = std::move(components[next]);
 				entities[i] = entities[next];
-				lookup[entities[i]] = i;
+				lookup.Set(entities[i], i);
 			}
 
 			// Saved entity-component moved to the required position:
 			components[index_to] = std::move(component);
 			entities[index_to] = entity;
-			lookup[entity] = index_to;
+			lookup.Set(entity, index_to);
+			structure_version++;
 		}
 
 		// Check if a component exists for a given entity or not
 		inline bool Contains(Entity entity) const
 		{
-			if (lookup.empty())
-				return false;
-			return lookup.find(entity) != lookup.end();
+			return lookup.Find(entity) != ~0ull;
 		}
 
 		// Retrieve a [read/write] component specified by an entity (if it exists, otherwise nullptr)
 		inline Component* GetComponent(Entity entity)
 		{
-			if (lookup.empty())
-				return nullptr;
-			auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.Find(entity);
+			if (index != ~0ull)
 			{
-				return &components[it->second];
+				return &components[index];
 			}
 			return nullptr;
 		}
@@ -379,12 +718,10 @@ namespace wi::ecs
 		// Retrieve a [read only] component specified by an entity (if it exists, otherwise nullptr)
 		inline const Component* GetComponent(Entity entity) const
 		{
-			if (lookup.empty())
-				return nullptr;
-			const auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.Find(entity);
+			if (index != ~0ull)
 			{
-				return &components[it->second];
+				return &components[index];
 			}
 			return nullptr;
 		}
@@ -392,14 +729,7 @@ namespace wi::ecs
 		// Retrieve component index by entity handle (if not exists, returns ~0ull value)
 		inline size_t GetIndex(Entity entity) const 
 		{
-			if (lookup.empty())
-				return ~0ull;
-			const auto it = lookup.find(entity);
-			if (it != lookup.end())
-			{
-				return it->second;
-			}
-			return ~0ull;
+			return lookup.Find(entity);
 		}
 
 		// Retrieve the number of existing entries
@@ -423,13 +753,22 @@ namespace wi::ecs
 		// Returns the tightly packed [read only] component array
 		inline const wi::vector<Component>& GetComponentArray() const { return components; }
 
+		// Returns the memory usage of the entity lookup table in bytes
+		inline size_t GetLookupMemoryUsage() const { return lookup.GetMemoryUsage(); }
+
+		// Returns a number that changes every time components are added, removed or reordered
+		//	Data that depends on the component indices can be cached until this changes
+		inline uint64_t GetStructureVersion() const { return structure_version; }
+
 	private:
 		// This is a linear array of alive components
 		wi::vector<Component> components;
 		// This is a linear array of entities corresponding to each alive component
 		wi::vector<Entity> entities;
 		// This is a lookup table for entities
-		wi::unordered_map<Entity, size_t> lookup;
+		typename ComponentLookup<Component>::type lookup;
+		// Incremented by every structural change
+		uint64_t structure_version = 0;
 
 		// Disallow this to be copied by mistake
 		ComponentManager(const ComponentManager&) = delete;
@@ -447,6 +786,16 @@ namespace wi::ecs
 		};
 		wi::unordered_map<std::string, LibraryEntry> entries;
 
+		// If enabled, the component managers are deserialized concurrently by Serialize()
+		//	Every registered component type must support deserializing concurrently with other component types in this case
+		//	The loaded content is the same, but the remapped entity IDs depend on the order in which the jobs reach each entity, so they differ between loads
+		//	This is disabled by default until it is benchmarked, when disabled the remapping is deterministic
+		bool parallel_deserialization = false;
+
+		// The deserialization progress of Serialize(), these can be read from other threads while it's running (for example to display the loading progress)
+		std::atomic<uint32_t> deserialize_section_count{ 0 };
+		std::atomic<uint32_t> deserialized_section_count{ 0 };
+
 		// Create an instance of ComponentManager of a certain data type
 		//	The name must be unique, it will be used in serialization
 		//	version is optional, it will be propagated to ComponentManager::Serialize() inside the EntitySerializer parameter
@@ -463,6 +812,13 @@ namespace wi::ecs
 		{
 			if(archive.IsReadMode())
 			{
+				// First the data ranges of the registered component managers are collected by using the jump positions:
+				struct Section
+				{
+					ComponentManager_Interface* component_manager = nullptr;
+					size_t pos = 0;
+				};
+				wi::vector<Section> sections;
 				bool has_next = false;
 				do
 				{
@@ -476,17 +832,46 @@ namespace wi::ecs
 						auto it = entries.find(name);
 						if(it != entries.end())
 						{
-							archive >> seri.version;
-							it->second.component_manager->Serialize(archive, seri);
-						}
-						else
-						{
-							// component manager of this name was not registered, skip serialization by jumping over the data
-							archive.Jump(jump_size);
+							Section& section = sections.emplace_back();
+							section.component_manager = it->second.component_manager.get();
+							section.pos = archive.GetPos();
 						}
+						// component managers that were not registered are skipped by jumping over the data
+						archive.Jump(jump_size);
 					}
 				}
 				while(has_next);
+				const size_t end_pos = archive.GetPos();
+				deserialized_section_count.store(0);
+				deserialize_section_count.store((uint32_t)sections.size());
+
+				if (parallel_deserialization && sections.size() > 1 && wi::jobsystem::GetThreadCount() > 1)
+				{
+					// Every component manager is read by a separate job with its own archive view, the entity remapping is shared:
+					wi::jobsystem::context ctx;
+					wi::jobsystem::Dispatch(ctx, (uint32_t)sections.size(), 1, [&](wi::jobsystem::JobArgs args) {
+						const Section& section = sections[args.jobIndex];
+						wi::Archive section_archive = archive.CreateReadView(section.pos);
+						EntitySerializer section_seri;
+						section_seri.shared = &seri;
+						section_seri.allow_remap = seri.allow_remap;
+						section_archive >> section_seri.version;
+						section.component_manager->Serialize(section_archive, section_seri);
+						deserialized_section_count.fetch_add(1);
+					});
+					wi::jobsystem::Wait(ctx);
+				}
+				else
+				{
+					for (const Section& section : sections)
+					{
+						archive.Jump(section.pos);
+						archive >> seri.version;
+						section.component_manager->Serialize(archive, seri);
+						deserialized_section_count.fetch_add(1);
+					}
+				}
+				archive.Jump(end_pos);
 			}
 			else
 			{
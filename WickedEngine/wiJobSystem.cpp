@@ -6,84 +6,667 @@
 
 #include <memory>
 #include <algorithm>
-#include <deque>
+#include <cassert>
 #include <string>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
+#include <climits>
+#include <fstream>
+#include <chrono>
+
+#ifdef _WIN32
+#pragma comment(lib, "Synchronization.lib") // WaitOnAddress
+#endif // _WIN32
 
 #ifdef PLATFORM_LINUX
 #include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sched.h>
 #endif
 
 namespace wi::jobsystem
 {
+	// The task is shared by all job groups of an Execute() or Dispatch(), so groups don't need to copy it
+	//	It is returned to the task pool when the last group referencing it finished
+	struct Task
+	{
+		TaskFunction func;
+		context* ctx = nullptr;
+		uint32_t sharedmemory_size = 0;
+		std::atomic<uint32_t> refcount{ 0 };
+
+		// Only used while the task is waiting for its dependencies to finish:
+		uint32_t jobCount = 0;
+		uint32_t groupSize = 0;
+		std::atomic<uint32_t> dependencies{ 0 };
+
+		// Only used by ParallelFor(), the range of a job is split on demand:
+		bool splittable = false;
+		std::atomic<uint32_t> grainSize{ 1 };		// jobs executed between two split checks, adapted to the measured job duration
+		std::atomic<uint32_t> groupCounter{ 0 };	// the groups are numbered in the order they started
+	};
 	struct Job
 	{
-		std::function<void(JobArgs)> task;
-		context* ctx;
-		uint32_t groupID;
-		uint32_t groupJobOffset;
-		uint32_t groupJobEnd;
-		uint32_t sharedmemory_size;
+		Task* task = nullptr;
+		uint32_t groupID = 0;
+		uint32_t groupJobOffset = 0;
+		uint32_t groupJobEnd = 0;
+	};
+
+	// One continuation is linked into the continuation list of every dependency context of a waiting task
+	struct Continuation
+	{
+		Task* pending = nullptr;
+		Continuation* next = nullptr;
+	};
+
+	// Recycles objects, so that submitting jobs doesn't need to allocate memory after warm up
+	//	Every thread has a small local cache, and exchanges objects in batches with the shared free list.
+	//	Objects are allocated in blocks that are only freed when the pool is destroyed.
+	template<typename T>
+	struct ObjectPool
+	{
+		static constexpr size_t block_size = 256;
+		static constexpr size_t batch_size = 64;
+
+		wi::SpinLock locker;
+		wi::vector<std::unique_ptr<T[]>> blocks;
+		wi::vector<T*> free_list;
+
+		struct ThreadCache
+		{
+			ObjectPool* pool = nullptr;
+			wi::vector<T*> items;
+			~ThreadCache()
+			{
+				// Thread exit: return cached objects to the shared free list
+				if (pool != nullptr && !items.empty())
+				{
+					std::scoped_lock lock(pool->locker);
+					pool->free_list.insert(pool->free_list.end(), items.begin(), items.end());
+				}
+			}
+		};
+		inline ThreadCache& GetThreadCache()
+		{
+			static thread_local ThreadCache cache;
+			if (cache.pool == nullptr)
+			{
+				cache.pool = this;
+				cache.items.reserve(batch_size * 2);
+			}
+			return cache;
+		}
+
+		inline T* allocate()
+		{
+			ThreadCache& cache = GetThreadCache();
+			if (cache.items.empty())
+			{
+				std::scoped_lock lock(locker);
+				if (free_list.empty())
+				{
+					T* block = blocks.emplace_back(new T[block_size]).get();
+					for (size_t i = 0; i < block_size; ++i)
+					{
+						free_list.push_back(block + i);
+					}
+				}
+				const size_t count = std::min(batch_size, free_list.size());
+				cache.items.insert(cache.items.end(), free_list.end() - count, free_list.end());
+				free_list.resize(free_list.size() - count);
+			}
+			T* item = cache.items.back();
+			cache.items.pop_back();
+			return item;
+		}
+
+		inline void free(T* item)
+		{
+			ThreadCache& cache = GetThreadCache();
+			cache.items.push_back(item);
+			if (cache.items.size() >= batch_size * 2)
+			{
+				std::scoped_lock lock(locker);
+				free_list.insert(free_list.end(), cache.items.end() - batch_size, cache.items.end());
+				cache.items.resize(cache.items.size() - batch_size);
+			}
+		}
 	};
+	// The pools are declared before the internal state, so they outlive the worker threads:
+	static ObjectPool<Task> task_pool;
+	static ObjectPool<Continuation> continuation_pool;
+
+	// Chase-Lev work stealing deque:
+	//	The owner thread pushes and pops at the bottom end (LIFO), other threads steal from the top end (FIFO)
+	//	https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+	//	https://fzn.fr/readings/ppopp13.pdf (C11 memory model version)
 	struct JobQueue
 	{
-		std::deque<Job> queue;
-		std::mutex locker;
+		// The slots are accessed with relaxed atomics because a thief can read a slot while the owner is overwriting it.
+		//	The thief discards the torn data in this case, because its CAS on the top index will fail
+		struct Slot
+		{
+			std::atomic<Task*> task{ nullptr };
+			std::atomic<uint32_t> groupID{ 0 };
+			std::atomic<uint32_t> groupJobOffset{ 0 };
+			std::atomic<uint32_t> groupJobEnd{ 0 };
+		};
+		struct Ring
+		{
+			int64_t capacity = 0; // power of two
+			std::unique_ptr<Slot[]> slots;
+
+			Ring(int64_t capacity) : capacity(capacity), slots(new Slot[capacity]) {}
+
+			inline void put(int64_t index, const Job& item)
+			{
+				Slot& slot = slots[index & (capacity - 1)];
+				slot.task.store(item.task, std::memory_order_relaxed);
+				slot.groupID.store(item.groupID, std::memory_order_relaxed);
+				slot.groupJobOffset.store(item.groupJobOffset, std::memory_order_relaxed);
+				slot.groupJobEnd.store(item.groupJobEnd, std::memory_order_relaxed);
+			}
+			inline void get(int64_t index, Job& item) const
+			{
+				const Slot& slot = slots[index & (capacity - 1)];
+				item.task = slot.task.load(std::memory_order_relaxed);
+				item.groupID = slot.groupID.load(std::memory_order_relaxed);
+				item.groupJobOffset = slot.groupJobOffset.load(std::memory_order_relaxed);
+				item.groupJobEnd = slot.groupJobEnd.load(std::memory_order_relaxed);
+			}
+		};
+
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		std::atomic<Ring*> ring{ nullptr };
+		wi::vector<std::unique_ptr<Ring>> rings; // owns current and retired rings, thieves might still read retired ones
+		wi::SpinLock owner_locker; // only used when the queue is shared by multiple owner threads
+		bool shared = false;
 
+		JobQueue()
+		{
+			rings.emplace_back(new Ring(256));
+			ring.store(rings.back().get(), std::memory_order_relaxed);
+		}
+
+		// Owner only
 		inline void push_back(const Job& item)
 		{
-			std::scoped_lock lock(locker);
-			queue.push_back(item);
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			Ring* r = ring.load(std::memory_order_relaxed);
+			if (b - t > r->capacity - 1)
+			{
+				// Grow: the previous ring is retired but not deleted, because thieves can still read from it
+				Ring* grown = new Ring(r->capacity * 2);
+				for (int64_t i = t; i < b; ++i)
+				{
+					Job job;
+					r->get(i, job);
+					grown->put(i, job);
+				}
+				rings.emplace_back(grown);
+				ring.store(grown, std::memory_order_release);
+				r = grown;
+			}
+			r->put(b, item);
+			bottom.store(b + 1, std::memory_order_release); // publish to thieves
 		}
 
-		inline bool pop_front(Job& item)
+		// Owner only
+		inline bool pop_back(Job& item)
 		{
-			std::scoped_lock lock(locker);
-			if (queue.empty())
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			Ring* r = ring.load(std::memory_order_relaxed);
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			if (t > b)
 			{
+				// Empty:
+				bottom.store(b + 1, std::memory_order_relaxed);
 				return false;
 			}
-			item = std::move(queue.front());
-			queue.pop_front();
+			r->get(b, item);
+			if (t == b)
+			{
+				// Last item, race against thieves:
+				const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
 			return true;
 		}
 
+		// Any thread
+		inline bool steal(Job& item)
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+			{
+				return false;
+			}
+			Ring* r = ring.load(std::memory_order_acquire);
+			r->get(t, item);
+			return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+
+		inline bool empty() const
+		{
+			return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+		}
+	};
+
+	// Threads that are not workers (main thread, loading threads...) can also submit jobs.
+	//	They will receive their own queue on first use, or share the last queue if there are no more
+	static constexpr uint32_t external_queue_count = 8;
+
+	// Worker threads are separated by the priorities that they execute, so that long running background jobs
+	//	can never occupy the threads that are executing per-frame jobs:
+	enum class WorkerType
+	{
+		Frame,		// executes High and Normal priority jobs, one thread per core
+		Low,		// executes Low priority jobs, with lowered OS thread priority
+		Streaming,	// executes Streaming priority jobs, with lowered OS thread priority
+		Count
+	};
+	constexpr WorkerType GetWorkerType(Priority priority)
+	{
+		switch (priority)
+		{
+		case Priority::Low:
+			return WorkerType::Low;
+		case Priority::Streaming:
+			return WorkerType::Streaming;
+		default:
+			return WorkerType::Frame;
+		}
+	}
+
+	// Frame workers pick a Normal priority job before High ones this often, so Normal jobs can't be starved:
+	static constexpr uint32_t normal_priority_boost_interval = 8;
+
+	// Blocks the calling thread while the value at address is equal to expected (it can also return spuriously)
+	inline void FutexWait(std::atomic<uint32_t>& address, uint32_t expected)
+	{
+#ifdef _WIN32
+		WaitOnAddress(&address, &expected, sizeof(expected), INFINITE);
+#elif defined(PLATFORM_LINUX)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&address), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#endif // _WIN32
+	}
+	// Wakes up at most count threads that are blocked in FutexWait() on address
+	inline void FutexWake(std::atomic<uint32_t>& address, uint32_t count)
+	{
+#ifdef _WIN32
+		if (count >= (uint32_t)INT_MAX)
+		{
+			WakeByAddressAll(&address);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				WakeByAddressSingle(&address);
+			}
+		}
+#elif defined(PLATFORM_LINUX)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&address), FUTEX_WAKE_PRIVATE, (int)std::min(count, (uint32_t)INT_MAX), nullptr, nullptr, 0);
+#endif // _WIN32
+	}
+
+	// Event count: lets threads park until they are notified, without missing a notification that happens
+	//	between checking for work and going to sleep:
+	//	1) the waiter calls prepare_wait(), then checks for work again
+	//	2) if there is still no work, it calls wait() with the key returned by prepare_wait(), otherwise cancel_wait()
+	//	The notifier makes the work visible first, then calls notify(), which only costs an atomic load when nobody is waiting
+	struct EventCount
+	{
+		alignas(64) std::atomic<uint32_t> epoch{ 0 };
+		alignas(64) std::atomic<uint32_t> waiters{ 0 };
+
+		inline uint32_t prepare_wait()
+		{
+			waiters.fetch_add(1, std::memory_order_seq_cst);
+			std::atomic_thread_fence(std::memory_order_seq_cst); // the work check must happen after registering as waiter
+			return epoch.load(std::memory_order_seq_cst);
+		}
+		inline void cancel_wait()
+		{
+			waiters.fetch_sub(1, std::memory_order_seq_cst);
+		}
+		inline void wait(uint32_t key)
+		{
+			while (epoch.load(std::memory_order_acquire) == key)
+			{
+				FutexWait(epoch, key);
+			}
+			waiters.fetch_sub(1, std::memory_order_seq_cst);
+		}
+		inline void notify(uint32_t count)
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst); // the waiters check must happen after making the work visible
+			if (waiters.load(std::memory_order_seq_cst) == 0)
+				return;
+			epoch.fetch_add(1, std::memory_order_seq_cst);
+			FutexWake(epoch, count);
+		}
+		inline void notify_all()
+		{
+			notify(~0u);
+		}
 	};
 
+	// Idle threads spin for a while before parking, the spin length is adapted per thread:
+	//	it is increased when spinning was successful, and decreased when the thread had to park anyway
+	static constexpr uint32_t spin_count_min = 4;
+	static constexpr uint32_t spin_count_max = 256;
+
+	// ParallelFor() adapts its grain size so that executing a chunk of jobs takes about this long:
+	//	long enough to amortize the split checks and timing, short enough to react quickly when other threads become idle
+	static constexpr std::chrono::nanoseconds parallel_for_chunk_time = std::chrono::microseconds(10);
+	static constexpr uint32_t parallel_for_grain_max = 1u << 16;
+
+	struct Configuration
+	{
+		AffinityPolicy affinityPolicy = AffinityPolicy::PhysicalCoresFirst;
+		uint64_t affinityMask = 0;
+	} static configuration;
+
+	// Logical CPUs that the process is allowed to run on, detected at Initialize()
+	struct CPUTopology
+	{
+		struct CPU
+		{
+			uint32_t id = 0;		// logical CPU index used by the OS
+			uint32_t core = 0;		// physical core (unique within package)
+			uint32_t package = 0;	// physical CPU socket
+			uint32_t node = 0;		// NUMA node
+			uint32_t smt = 0;		// index of this logical CPU among the SMT siblings of its core
+		};
+		wi::vector<CPU> cpus;		// ordered by physical cores first: the first SMT sibling of every core, then the second ones, etc.
+		uint32_t physicalCoreCount = 0;
+		uint32_t numaNodeCount = 1;
+		uint32_t quotaCount = ~0u;	// number of CPUs worth of time allowed by the CPU quota (cgroup), ~0u if not limited
+
+		// Number of CPUs that can be effectively used
+		uint32_t GetAvailableCount() const
+		{
+			return std::max(1u, std::min(uint32_t(cpus.size()), quotaCount));
+		}
+	};
+
+#ifdef PLATFORM_LINUX
+	inline bool ReadTextFile(const char* path, std::string& text)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+			return false;
+		std::getline(file, text);
+		return true;
+	}
+	inline bool ReadNumberFile(const char* path, uint32_t& value)
+	{
+		std::string text;
+		if (!ReadTextFile(path, text) || text.empty())
+			return false;
+		value = (uint32_t)std::strtoul(text.c_str(), nullptr, 10);
+		return true;
+	}
+	// Parses the CPU list format of sysfs, for example "0-3,8,10-11"
+	inline void ParseCPUList(const std::string& text, wi::vector<uint32_t>& result)
+	{
+		const char* str = text.c_str();
+		while (*str != 0)
+		{
+			char* end = nullptr;
+			const uint32_t first = (uint32_t)std::strtoul(str, &end, 10);
+			if (end == str)
+				break;
+			uint32_t last = first;
+			str = end;
+			if (*str == '-')
+			{
+				last = (uint32_t)std::strtoul(str + 1, &end, 10);
+				str = end;
+			}
+			for (uint32_t i = first; i <= last; ++i)
+			{
+				result.push_back(i);
+			}
+			if (*str == ',')
+			{
+				str++;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+#endif // PLATFORM_LINUX
+
+	inline CPUTopology DetectTopology()
+	{
+		CPUTopology topology;
+
+#ifdef PLATFORM_LINUX
+		// The affinity mask of the process already reflects the cgroup cpuset:
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+		{
+			for (uint32_t id = 0; id < CPU_SETSIZE; ++id)
+			{
+				if (!CPU_ISSET(id, &allowed))
+					continue;
+				CPUTopology::CPU& cpu = topology.cpus.emplace_back();
+				cpu.id = id;
+				cpu.core = id;
+				const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+				ReadNumberFile((path + "core_id").c_str(), cpu.core);
+				ReadNumberFile((path + "physical_package_id").c_str(), cpu.package);
+			}
+		}
+
+		// NUMA nodes:
+		std::string text;
+		if (ReadTextFile("/sys/devices/system/node/online", text))
+		{
+			wi::vector<uint32_t> nodes;
+			ParseCPUList(text, nodes);
+			topology.numaNodeCount = std::max(1u, (uint32_t)nodes.size());
+			for (uint32_t node_index = 0; node_index < (uint32_t)nodes.size(); ++node_index)
+			{
+				const std::string path = "/sys/devices/system/node/node" + std::to_string(nodes[node_index]) + "/cpulist";
+				wi::vector<uint32_t> node_cpus;
+				if (ReadTextFile(path.c_str(), text))
+				{
+					ParseCPUList(text, node_cpus);
+				}
+				for (auto& cpu : topology.cpus)
+				{
+					if (std::find(node_cpus.begin(), node_cpus.end(), cpu.id) != node_cpus.end())
+					{
+						cpu.node = node_index;
+					}
+				}
+			}
+		}
+
+		// CPU quota of containers, cgroup v2 first, then v1:
+		uint32_t quota = 0;
+		uint32_t period = 0;
+		if (ReadTextFile("/sys/fs/cgroup/cpu.max", text))
+		{
+			// "max 100000" when not limited, "<quota> <period>" otherwise
+			if (text.compare(0, 3, "max") != 0)
+			{
+				char* end = nullptr;
+				quota = (uint32_t)std::strtoul(text.c_str(), &end, 10);
+				period = (uint32_t)std::strtoul(end, nullptr, 10);
+			}
+		}
+		else if (ReadTextFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", text))
+		{
+			const long value = std::strtol(text.c_str(), nullptr, 10); // -1 when not limited
+			if (value > 0)
+			{
+				quota = (uint32_t)value;
+				ReadNumberFile("/sys/fs/cgroup/cpu/cpu.cfs_period_us", period);
+			}
+		}
+		if (quota > 0 && period > 0)
+		{
+			topology.quotaCount = std::max(1u, (quota + period - 1) / period);
+		}
+#elif defined(_WIN32)
+		DWORD_PTR process_mask = 0;
+		DWORD_PTR system_mask = 0;
+		GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+
+		// Only the first processor group is handled, same as the thread affinity masks below:
+		DWORD size = 0;
+		GetLogicalProcessorInformationEx(RelationAll, nullptr, &size);
+		wi::vector<uint8_t> buffer(size);
+		if (size > 0 && GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data(), &size))
+		{
+			uint32_t core_index = 0;
+			for (DWORD offset = 0; offset < size;)
+			{
+				auto info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer.data() + offset);
+				if (info->Relationship == RelationProcessorCore && info->Processor.GroupMask[0].Group == 0)
+				{
+					const KAFFINITY mask = info->Processor.GroupMask[0].Mask & process_mask;
+					for (uint32_t id = 0; id < sizeof(KAFFINITY) * 8; ++id)
+					{
+						if ((mask & (KAFFINITY(1) << id)) == 0)
+							continue;
+						CPUTopology::CPU& cpu = topology.cpus.emplace_back();
+						cpu.id = id;
+						cpu.core = core_index;
+					}
+					core_index++;
+				}
+				offset += info->Size;
+			}
+			uint32_t node_index = 0;
+			for (DWORD offset = 0; offset < size;)
+			{
+				auto info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer.data() + offset);
+				if (info->Relationship == RelationNumaNode && info->NumaNode.GroupMask.Group == 0)
+				{
+					for (auto& cpu : topology.cpus)
+					{
+						if (info->NumaNode.GroupMask.Mask & (KAFFINITY(1) << cpu.id))
+						{
+							cpu.node = node_index;
+						}
+					}
+					node_index++;
+				}
+				offset += info->Size;
+			}
+			topology.numaNodeCount = std::max(1u, node_index);
+		}
+#endif // PLATFORM_LINUX
+
+		if (topology.cpus.empty())
+		{
+			// Unknown topology, assume every logical CPU is a separate core:
+			const uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+			for (uint32_t id = 0; id < count; ++id)
+			{
+				CPUTopology::CPU& cpu = topology.cpus.emplace_back();
+				cpu.id = id;
+				cpu.core = id;
+			}
+		}
+
+		// Determine the SMT sibling index of the logical CPUs within their physical core:
+		std::sort(topology.cpus.begin(), topology.cpus.end(), [](const CPUTopology::CPU& a, const CPUTopology::CPU& b) {
+			if (a.package != b.package)
+				return a.package < b.package;
+			if (a.core != b.core)
+				return a.core < b.core;
+			return a.id < b.id;
+		});
+		for (size_t i = 0; i < topology.cpus.size(); ++i)
+		{
+			CPUTopology::CPU& cpu = topology.cpus[i];
+			const bool sibling = i > 0 && topology.cpus[i - 1].package == cpu.package && topology.cpus[i - 1].core == cpu.core;
+			cpu.smt = sibling ? topology.cpus[i - 1].smt + 1 : 0;
+			if (cpu.smt == 0)
+			{
+				topology.physicalCoreCount++;
+			}
+		}
+
+		// Physical cores first, NUMA nodes are kept contiguous:
+		std::stable_sort(topology.cpus.begin(), topology.cpus.end(), [](const CPUTopology::CPU& a, const CPUTopology::CPU& b) {
+			if (a.smt != b.smt)
+				return a.smt < b.smt;
+			return a.node < b.node;
+		});
+
+		return topology;
+	}
+
 	// This structure is responsible to stop worker thread loops.
 	//	Once this is destroyed, worker threads will be woken up and end their loops.
 	struct InternalState
 	{
 		uint32_t numCores = 0;
-		uint32_t numThreads = 0;
-		std::unique_ptr<JobQueue[]> jobQueuePerThread;
+		uint32_t numThreads = 0; // frame worker threads
+		uint32_t numLowThreads = 0;
+		uint32_t numStreamingThreads = 0;
+		uint32_t numWorkers = 0; // all worker threads
+		uint32_t numQueues = 0;
+		std::unique_ptr<JobQueue[]> jobQueues[int(Priority::Count)]; // per priority: [0, numWorkers) : worker queues, [numWorkers, numQueues) : external thread queues
+		wi::vector<uint32_t> queueNodes; // NUMA node of the thread owning each queue, ~0u if unknown
+		uint32_t numaNodeCount = 1;
+		std::atomic<uint32_t> nextExternalQueue{ 0 };
+		std::atomic<uint32_t> generation{ 0 }; // incremented on every Initialize() to invalidate thread local queue assignments
 		std::atomic_bool alive{ true };
-		std::condition_variable wakeCondition;
-		std::mutex wakeMutex;
-		std::atomic<uint32_t> nextQueue{ 0 };
+		struct Waker
+		{
+			EventCount event; // idle threads of a worker type are parked here
+			std::atomic<uint32_t> context_waiters{ 0 }; // threads that are parked inside Wait(), they also need to be notified when a context becomes idle
+		} wakers[int(WorkerType::Count)];
 		wi::vector<std::thread> threads;
+		std::atomic<uint64_t> wakeups{ 0 };
+		std::atomic<uint64_t> spins{ 0 };
+		std::atomic<uint64_t> parks{ 0 };
 		void ShutDown()
 		{
 			alive.store(false); // indicate that new jobs cannot be started from this point
-			bool wake_loop = true;
-			std::thread waker([&] {
-				while (wake_loop)
-				{
-					wakeCondition.notify_all(); // wakes up sleeping worker threads
-				}
-				});
+			for (auto& x : wakers)
+			{
+				x.event.notify_all(); // wakes up sleeping worker threads
+			}
 			for (auto& thread : threads)
 			{
 				thread.join();
 			}
-			wake_loop = false;
-			waker.join();
-			jobQueuePerThread.reset();
+			for (auto& x : jobQueues)
+			{
+				x.reset();
+			}
 			threads.clear();
 			numCores = 0;
 			numThreads = 0;
+			numLowThreads = 0;
+			numStreamingThreads = 0;
+			numWorkers = 0;
+			numQueues = 0;
+			numaNodeCount = 1;
+			queueNodes.clear();
 		}
 		~InternalState()
 		{
@@ -91,45 +674,501 @@ namespace wi::jobsystem
 		}
 	} static internal_state;
 
-	// Start working on a job queue
-	//	After the job queue is finished, it can switch to an other queue and steal jobs from there
-	inline void work(uint32_t startingQueue)
+	struct ThreadState
 	{
-		Job job;
-		for (uint32_t i = 0; i < internal_state.numThreads; ++i)
+		uint32_t generation = ~0u;
+		uint32_t queue = 0;
+		uint32_t random_state = 0;
+		uint32_t search_count = 0;
+		uint32_t spin_count = spin_count_min * 4;
+		uint32_t numa_node = ~0u;
+		WorkerType type = WorkerType::Frame;
+	};
+	static thread_local ThreadState thread_state;
+
+	// Returns the state of the calling thread, including the queue index that is owned by it
+	inline ThreadState& GetThreadState()
+	{
+		const uint32_t generation = internal_state.generation.load(std::memory_order_relaxed);
+		if (thread_state.generation != generation)
 		{
-			JobQueue& job_queue = internal_state.jobQueuePerThread[startingQueue % internal_state.numThreads];
-			while (job_queue.pop_front(job))
+			// External thread submitting for the first time, it will help with frame jobs while waiting:
+			thread_state.generation = generation;
+			const uint32_t external = std::min(internal_state.nextExternalQueue.fetch_add(1), external_queue_count - 1);
+			thread_state.queue = internal_state.numWorkers + external;
+			thread_state.random_state = thread_state.queue * 2654435761u + 1;
+			thread_state.numa_node = ~0u;
+			thread_state.type = WorkerType::Frame;
+		}
+		return thread_state;
+	}
+
+	// Timeline capture, every thread writes its own ring buffer:
+	//	The slots are relaxed atomics, because the collector can read a slot while its owner is overwriting it.
+	//	After copying, the collector discards the events that could have been overwritten by checking the write position again.
+	static constexpr uint64_t trace_capacity = 1ull << 16; // events per thread, power of two
+	struct TraceBuffer
+	{
+		struct Slot
+		{
+			std::atomic<uint64_t> timestamp{ 0 };
+			std::atomic<const char*> name{ nullptr };
+			std::atomic<uint32_t> arg0{ 0 };
+			std::atomic<uint32_t> arg1{ 0 };
+			std::atomic<TraceEventType> type{ TraceEventType::JobBegin };
+		};
+		std::string thread_name;
+		std::unique_ptr<Slot[]> slots{ new Slot[trace_capacity] };
+		std::atomic<uint64_t> write_position{ 0 };
+		std::atomic<uint64_t> clear_position{ 0 };
+
+		// Owner only
+		inline void write(TraceEventType type, const char* name, uint32_t arg0, uint32_t arg1)
+		{
+			const uint64_t position = write_position.load(std::memory_order_relaxed);
+			Slot& slot = slots[position & (trace_capacity - 1)];
+			slot.timestamp.store((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+			slot.name.store(name, std::memory_order_relaxed);
+			slot.arg0.store(arg0, std::memory_order_relaxed);
+			slot.arg1.store(arg1, std::memory_order_relaxed);
+			slot.type.store(type, std::memory_order_relaxed);
+			write_position.store(position + 1, std::memory_order_release);
+		}
+
+		// Any thread
+		inline void read(TraceThread& thread) const
+		{
+			const uint64_t end = write_position.load(std::memory_order_acquire);
+			uint64_t begin = std::max(clear_position.load(std::memory_order_relaxed), end > trace_capacity ? end - trace_capacity : 0);
+			thread.name = thread_name;
+			thread.events.resize(size_t(end - begin));
+			for (uint64_t i = begin; i < end; ++i)
 			{
-				JobArgs args;
-				args.groupID = job.groupID;
-				if (job.sharedmemory_size > 0)
-				{
-					thread_local static wi::vector<uint8_t> shared_allocation_data;
-					shared_allocation_data.reserve(job.sharedmemory_size);
-					args.sharedmemory = shared_allocation_data.data();
-				}
-				else
+				const Slot& slot = slots[i & (trace_capacity - 1)];
+				TraceEvent& event = thread.events[size_t(i - begin)];
+				event.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+				event.name = slot.name.load(std::memory_order_relaxed);
+				event.arg0 = slot.arg0.load(std::memory_order_relaxed);
+				event.arg1 = slot.arg1.load(std::memory_order_relaxed);
+				event.type = slot.type.load(std::memory_order_relaxed);
+			}
+			// The owner is possibly writing the event at the current write position, which overwrites the slot of (position - capacity):
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t overwritten = write_position.load(std::memory_order_relaxed) + 1;
+			if (overwritten > begin + trace_capacity)
+			{
+				const size_t discard = std::min(thread.events.size(), size_t(overwritten - begin - trace_capacity));
+				thread.events.erase(thread.events.begin(), thread.events.begin() + discard);
+			}
+		}
+	};
+	struct TraceState
+	{
+		std::atomic<bool> enabled{ false };
+		std::mutex locker;
+		wi::vector<std::unique_ptr<TraceBuffer>> buffers; // not freed while running, because threads keep pointing to their own
+	} static trace_state;
+	static thread_local TraceBuffer* trace_buffer = nullptr;
+
+	// Creates the ring buffer of the calling thread when it records its first event
+	inline TraceBuffer* CreateTraceBuffer()
+	{
+		TraceBuffer* buffer = new TraceBuffer;
+		const ThreadState& state = thread_state;
+		if (state.generation == internal_state.generation.load() && state.queue < internal_state.numWorkers)
+		{
+			switch (state.type)
+			{
+			case WorkerType::Low:
+				buffer->thread_name = "wi::job_low::" + std::to_string(state.queue - internal_state.numThreads);
+				break;
+			case WorkerType::Streaming:
+				buffer->thread_name = "wi::job_strm::" + std::to_string(state.queue - internal_state.numThreads - internal_state.numLowThreads);
+				break;
+			default:
+				buffer->thread_name = "wi::job::" + std::to_string(state.queue);
+				break;
+			}
+		}
+		std::scoped_lock lock(trace_state.locker);
+		if (buffer->thread_name.empty())
+		{
+			buffer->thread_name = "thread::" + std::to_string(trace_state.buffers.size());
+		}
+		trace_state.buffers.emplace_back(buffer);
+		return buffer;
+	}
+
+	inline void Trace(TraceEventType type, const char* name = nullptr, uint32_t arg0 = 0, uint32_t arg1 = 0)
+	{
+		if (!trace_state.enabled.load(std::memory_order_relaxed))
+			return;
+		if (trace_buffer == nullptr)
+		{
+			trace_buffer = CreateTraceBuffer();
+		}
+		trace_buffer->write(type, name, arg0, arg1);
+	}
+
+	inline void PushJob(Priority priority, const Job& job)
+	{
+		JobQueue& job_queue = internal_state.jobQueues[int(priority)][GetThreadState().queue];
+		if (job_queue.shared)
+		{
+			std::scoped_lock lock(job_queue.owner_locker);
+			job_queue.push_back(job);
+		}
+		else
+		{
+			job_queue.push_back(job);
+		}
+	}
+
+	// Finds a job of the specified priority for the calling thread:
+	//	First it tries the thread's own queue, then steals from the other queues starting at a random victim
+	inline bool FindJob(ThreadState& state, Priority priority, Job& job)
+	{
+		JobQueue* queues = internal_state.jobQueues[int(priority)].get();
+		const uint32_t home = state.queue;
+		JobQueue& home_queue = queues[home];
+		if (home_queue.shared)
+		{
+			std::scoped_lock lock(home_queue.owner_locker);
+			if (home_queue.pop_back(job))
+				return true;
+		}
+		else if (home_queue.pop_back(job))
+		{
+			return true;
+		}
+
+		// xorshift:
+		uint32_t x = state.random_state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		state.random_state = x;
+
+		// On NUMA systems, the queues of threads on the same node are tried first, because their jobs are more likely
+		//	to work on memory that is local to this node. Queues with unknown node are tried in both passes
+		const uint32_t numQueues = internal_state.numQueues;
+		const uint32_t start = x % numQueues;
+		const bool numa_local = internal_state.numaNodeCount > 1 && state.numa_node != ~0u;
+		for (uint32_t pass = numa_local ? 0 : 1; pass < 2; ++pass)
+		{
+			for (uint32_t i = 0; i < numQueues; ++i)
+			{
+				const uint32_t victim = (start + i) % numQueues;
+				if (victim == home)
+					continue;
+				if (pass == 0 && internal_state.queueNodes[victim] != state.numa_node && internal_state.queueNodes[victim] != ~0u)
+					continue;
+				JobQueue& victim_queue = queues[victim];
+				while (!victim_queue.empty())
 				{
-					args.sharedmemory = nullptr;
+					if (victim_queue.steal(job))
+					{
+						Trace(TraceEventType::Steal, nullptr, victim);
+						return true;
+					}
+					// lost a race to an other thread, retry while the victim still has jobs
 				}
+			}
+		}
+		return false;
+	}
+
+	// Finds a job for the calling thread, only from the priorities that its worker type is allowed to execute
+	inline bool FindJob(Job& job)
+	{
+		ThreadState& state = GetThreadState();
+		switch (state.type)
+		{
+		case WorkerType::Low:
+			return FindJob(state, Priority::Low, job);
+		case WorkerType::Streaming:
+			return FindJob(state, Priority::Streaming, job);
+		default:
+			break;
+		}
+		if ((++state.search_count % normal_priority_boost_interval) == 0)
+		{
+			return FindJob(state, Priority::Normal, job) || FindJob(state, Priority::High, job);
+		}
+		return FindJob(state, Priority::High, job) || FindJob(state, Priority::Normal, job);
+	}
+
+	// Push all job groups of a task to the calling thread's queue and wake up workers
+	inline void Submit(Task* task, uint32_t jobCount, uint32_t groupSize)
+	{
+		const uint32_t groupCount = DispatchGroupCount(jobCount, groupSize);
+		const Priority priority = task->ctx->priority;
+
+		Job job;
+		job.task = task;
+		for (uint32_t groupID = 0; groupID < groupCount; ++groupID)
+		{
+			// For each group, generate one real job:
+			job.groupID = groupID;
+			job.groupJobOffset = groupID * groupSize;
+			job.groupJobEnd = std::min(job.groupJobOffset + groupSize, jobCount);
+
+			PushJob(priority, job);
+		}
+
+		// Only wake up as many threads as the number of new groups:
+		internal_state.wakers[int(GetWorkerType(priority))].event.notify(groupCount);
+	}
+
+	// Start the pending task if this was its last dependency
+	inline void ReleasePending(Task* pending)
+	{
+		if (pending->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Submit(pending, pending->jobCount, pending->groupSize);
+		}
+	}
+
+	inline void ResolveContinuations(Continuation* continuation)
+	{
+		while (continuation != nullptr)
+		{
+			Continuation* next = continuation->next;
+			ReleasePending(continuation->pending);
+			continuation_pool.free(continuation);
+			continuation = next;
+		}
+	}
 
-				for (uint32_t j = job.groupJobOffset; j < job.groupJobEnd; ++j)
+	// Threads that are parked in Wait() are notified when any context becomes idle
+	inline void NotifyContextWaiters()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst); // the waiter check must happen after the context became idle
+		for (auto& waker : internal_state.wakers)
+		{
+			if (waker.context_waiters.load(std::memory_order_relaxed) > 0)
+			{
+				waker.event.notify_all();
+			}
+		}
+	}
+
+	// Decrement the context's counter
+	//	When the context becomes idle, its continuations are started. The continuation list is taken and the counter is zeroed
+	//	inside the lock, and Wait() acquires the lock before returning, so the context is not touched after it could be destroyed
+	inline void Release(context& ctx)
+	{
+		uint32_t counter = ctx.counter.load(std::memory_order_acquire);
+		while (true)
+		{
+			assert(counter > 0);
+			if (counter > 1)
+			{
+				if (ctx.counter.compare_exchange_weak(counter, counter - 1, std::memory_order_acq_rel, std::memory_order_acquire))
+					return;
+				continue;
+			}
+			if (ctx.continuations.load(std::memory_order_acquire) == nullptr)
+			{
+				if (ctx.counter.compare_exchange_weak(counter, 0, std::memory_order_acq_rel, std::memory_order_acquire))
 				{
-					args.jobIndex = j;
-					args.groupIndex = j - job.groupJobOffset;
-					args.isFirstJobInGroup = (j == job.groupJobOffset);
-					args.isLastJobInGroup = (j == job.groupJobEnd - 1);
-					job.task(args);
+					NotifyContextWaiters();
+					return;
 				}
+				continue;
+			}
+			ctx.locker.lock();
+			if (ctx.counter.compare_exchange_strong(counter, 0, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				Continuation* continuations = ctx.continuations.exchange(nullptr, std::memory_order_acq_rel);
+				ctx.locker.unlock();
+				NotifyContextWaiters();
+				ResolveContinuations(continuations);
+				return;
+			}
+			ctx.locker.unlock();
+		}
+	}
+
+	// Shared memory of job groups, one buffer per nesting level, because a job can execute other jobs inside Wait()
+	struct SharedMemoryStack
+	{
+		wi::vector<wi::vector<uint8_t>> levels;
+		uint32_t depth = 0;
+	};
+	static thread_local SharedMemoryStack shared_memory_stack;
+
+	// Executes the range of a ParallelFor() job with lazy binary splitting:
+	//	Before every chunk, if the thread's own queue is empty, the second half of the remaining range is pushed as a new job that
+	//	idle threads can steal. If nobody steals it, then this thread pops it later, so splitting only costs much when there is parallelism.
+	//	The chunk size is adapted to the measured duration of the jobs, so small jobs are not dominated by the split checks.
+	//	The range that a job executes is one group, the groups are numbered dynamically.
+	inline void ExecuteRange(Task& task, const Job& job, JobArgs& args)
+	{
+		const Priority priority = task.ctx->priority;
+		const uint32_t groupBegin = job.groupJobOffset;
+		uint32_t begin = job.groupJobOffset;
+		uint32_t end = job.groupJobEnd;
+		args.groupID = task.groupCounter.fetch_add(1, std::memory_order_relaxed);
+
+		while (begin < end)
+		{
+			uint32_t grain = task.grainSize.load(std::memory_order_relaxed);
+			if (end - begin >= grain * 2 && internal_state.jobQueues[int(priority)][GetThreadState().queue].empty())
+			{
+				const uint32_t mid = begin + (end - begin) / 2;
+				task.refcount.fetch_add(1, std::memory_order_relaxed);
+				task.ctx->counter.fetch_add(1);
+
+				Job split;
+				split.task = &task;
+				split.groupJobOffset = mid;
+				split.groupJobEnd = end;
+				PushJob(priority, split);
+				internal_state.wakers[int(GetWorkerType(priority))].event.notify(1);
+				end = mid;
+			}
+
+			const uint32_t chunkEnd = std::min(end, begin + grain);
+			const auto chunkStart = std::chrono::steady_clock::now();
+			for (uint32_t j = begin; j < chunkEnd; ++j)
+			{
+				args.jobIndex = j;
+				args.groupIndex = j - groupBegin;
+				args.isFirstJobInGroup = (j == groupBegin);
+				args.isLastJobInGroup = (j == end - 1);
+				task.func(args);
+			}
+			const auto chunkTime = std::chrono::steady_clock::now() - chunkStart;
+			begin = chunkEnd;
+
+			if (chunkTime < parallel_for_chunk_time / 2 && grain < parallel_for_grain_max)
+			{
+				task.grainSize.store(grain * 2, std::memory_order_relaxed);
+			}
+			else if (chunkTime > parallel_for_chunk_time * 2 && grain > 1)
+			{
+				task.grainSize.store(grain / 2, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	inline void ExecuteJob(const Job& job)
+	{
+		Task& task = *job.task;
+
+		JobArgs args;
+		args.groupID = job.groupID;
+		SharedMemoryStack& shared_memory = shared_memory_stack;
+		if (task.sharedmemory_size > 0)
+		{
+			if (shared_memory.levels.size() <= shared_memory.depth)
+			{
+				shared_memory.levels.resize(shared_memory.depth + 1); // moving the outer buffers doesn't move their data
+			}
+			wi::vector<uint8_t>& shared_allocation_data = shared_memory.levels[shared_memory.depth];
+			shared_allocation_data.reserve(task.sharedmemory_size);
+			args.sharedmemory = shared_allocation_data.data();
+		}
+		else
+		{
+			args.sharedmemory = nullptr;
+		}
+		shared_memory.depth++;
+
+		context* ctx = task.ctx;
+		Trace(TraceEventType::JobBegin, ctx->name, job.groupJobOffset, job.groupJobEnd);
+
+		if (task.splittable)
+		{
+			ExecuteRange(task, job, args);
+		}
+		else
+		{
+			for (uint32_t j = job.groupJobOffset; j < job.groupJobEnd; ++j)
+			{
+				args.jobIndex = j;
+				args.groupIndex = j - job.groupJobOffset;
+				args.isFirstJobInGroup = (j == job.groupJobOffset);
+				args.isLastJobInGroup = (j == job.groupJobEnd - 1);
+				task.func(args);
+			}
+		}
 
-				job.ctx->counter.fetch_sub(1);
+		shared_memory.depth--;
+
+		Trace(TraceEventType::JobEnd);
+
+		if (task.refcount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			task.func.reset(); // release captured state
+			task_pool.free(&task);
+		}
+		Release(*ctx);
+	}
+
+	// Execute jobs until there are no more jobs to be found in any queue
+	inline void work()
+	{
+		Job job;
+		while (FindJob(job))
+		{
+			ExecuteJob(job);
+		}
+	}
+
+	inline void AdaptSpinCount(ThreadState& state, bool success)
+	{
+		state.spin_count = success ? std::min(spin_count_max, state.spin_count * 2) : std::max(spin_count_min, state.spin_count / 2);
+	}
+
+	// The loop of worker threads: execute jobs, spin for a while when there are none, then park until new jobs arrive
+	inline void WorkerLoop()
+	{
+		ThreadState& state = thread_state;
+		auto& waker = internal_state.wakers[int(state.type)];
+		Job job;
+		while (internal_state.alive.load())
+		{
+			work();
+
+			// New jobs often arrive shortly, so spinning a bit can avoid the cost of parking and waking:
+			bool found = false;
+			for (uint32_t i = 0; i < state.spin_count && !found; ++i)
+			{
+				_mm_pause();
+				found = FindJob(job);
 			}
-			startingQueue++; // go to next queue
+			AdaptSpinCount(state, found);
+			if (found)
+			{
+				internal_state.spins.fetch_add(1, std::memory_order_relaxed);
+				ExecuteJob(job);
+				continue;
+			}
+
+			// Finished with jobs, park:
+			const uint32_t key = waker.event.prepare_wait();
+			if (!internal_state.alive.load())
+			{
+				waker.event.cancel_wait();
+				break;
+			}
+			if (FindJob(job))
+			{
+				waker.event.cancel_wait();
+				ExecuteJob(job);
+				continue;
+			}
+			internal_state.parks.fetch_add(1, std::memory_order_relaxed);
+			Trace(TraceEventType::Park);
+			waker.event.wait(key);
+			Trace(TraceEventType::Wake);
+			internal_state.wakeups.fetch_add(1, std::memory_order_relaxed);
 		}
 	}
 
-	void Initialize(uint32_t maxThreadCount)
+	void Initialize(uint32_t maxThreadCount, uint32_t lowPriorityThreadCount, uint32_t streamingThreadCount)
 	{
 		if (internal_state.numThreads > 0)
 			return;
@@ -137,26 +1176,107 @@ namespace wi::jobsystem
 
 		wi::Timer timer;
 
-		// Retrieve the number of hardware threads in this system:
-		internal_state.numCores = std::thread::hardware_concurrency();
+		// Retrieve the logical CPUs that can be used by this process, and choose the CPUs that frame threads will be pinned to:
+		const CPUTopology topology = DetectTopology();
+		wi::vector<CPUTopology::CPU> pinned_cpus;
+		switch (configuration.affinityPolicy)
+		{
+		case AffinityPolicy::PhysicalCoresFirst:
+			pinned_cpus = topology.cpus;
+			break;
+		case AffinityPolicy::ExplicitMask:
+			for (auto& cpu : topology.cpus)
+			{
+				if (cpu.id < 64 && (configuration.affinityMask & (1ull << cpu.id)))
+				{
+					pinned_cpus.push_back(cpu);
+				}
+			}
+			if (pinned_cpus.empty())
+			{
+				wi::backlog::post("wi::jobsystem affinity mask doesn't contain any usable CPU, it will be ignored!", wi::backlog::LogLevel::Warning);
+				pinned_cpus = topology.cpus;
+			}
+			break;
+		default:
+			break;
+		}
+
+		// Retrieve the number of hardware threads that can be used (limited by process affinity, cgroup cpuset and quota):
+		internal_state.numCores = topology.GetAvailableCount();
+		if (configuration.affinityPolicy == AffinityPolicy::ExplicitMask)
+		{
+			internal_state.numCores = std::min(internal_state.numCores, (uint32_t)pinned_cpus.size());
+		}
 
 		// Calculate the actual number of worker threads we want (-1 main thread):
 		internal_state.numThreads = std::min(maxThreadCount, std::max(1u, internal_state.numCores - 1));
-		internal_state.jobQueuePerThread.reset(new JobQueue[internal_state.numThreads]);
-		internal_state.threads.reserve(internal_state.numThreads);
 
-		for (uint32_t threadID = 0; threadID < internal_state.numThreads; ++threadID)
+		// Background threads are reserved in addition to the frame workers, at least one for each background priority:
+		if (lowPriorityThreadCount == ~0u)
 		{
-			internal_state.threads.emplace_back([threadID] {
+			lowPriorityThreadCount = internal_state.numThreads / 2;
+		}
+		internal_state.numLowThreads = std::max(1u, lowPriorityThreadCount);
+		internal_state.numStreamingThreads = std::max(1u, streamingThreadCount);
+		internal_state.numWorkers = internal_state.numThreads + internal_state.numLowThreads + internal_state.numStreamingThreads;
 
-				while (internal_state.alive.load())
-				{
-					work(threadID);
+		internal_state.numQueues = internal_state.numWorkers + external_queue_count;
+		for (auto& x : internal_state.jobQueues)
+		{
+			x.reset(new JobQueue[internal_state.numQueues]);
+			x[internal_state.numQueues - 1].shared = true;
+		}
+		internal_state.numaNodeCount = topology.numaNodeCount;
+		internal_state.queueNodes.clear();
+		internal_state.queueNodes.resize(internal_state.numQueues, ~0u);
+		internal_state.nextExternalQueue.store(0);
+		internal_state.generation.fetch_add(1);
+		internal_state.alive.store(true);
+		internal_state.threads.reserve(internal_state.numWorkers);
 
-					// finished with jobs, put to sleep
-					std::unique_lock<std::mutex> lock(internal_state.wakeMutex);
-					internal_state.wakeCondition.wait(lock);
+		for (uint32_t threadID = 0; threadID < internal_state.numWorkers; ++threadID)
+		{
+			WorkerType type = WorkerType::Frame;
+			uint32_t typeThreadID = threadID;
+			if (threadID >= internal_state.numThreads + internal_state.numLowThreads)
+			{
+				type = WorkerType::Streaming;
+				typeThreadID = threadID - internal_state.numThreads - internal_state.numLowThreads;
+			}
+			else if (threadID >= internal_state.numThreads)
+			{
+				type = WorkerType::Low;
+				typeThreadID = threadID - internal_state.numThreads;
+			}
+
+			// Only frame threads are pinned, one per logical CPU in physical cores first order:
+			const CPUTopology::CPU* pinned_cpu = nullptr;
+			if (type == WorkerType::Frame && !pinned_cpus.empty())
+			{
+				pinned_cpu = &pinned_cpus[threadID % pinned_cpus.size()];
+				internal_state.queueNodes[threadID] = pinned_cpu->node;
+			}
+			const uint32_t numa_node = internal_state.queueNodes[threadID];
+
+			internal_state.threads.emplace_back([threadID, type, numa_node] {
+
+				// Worker threads own the queue with their own index:
+				thread_state.generation = internal_state.generation.load();
+				thread_state.queue = threadID;
+				thread_state.random_state = threadID * 2654435761u + 1;
+				thread_state.numa_node = numa_node;
+				thread_state.type = type;
+
+#ifdef PLATFORM_LINUX
+				if (type != WorkerType::Frame)
+				{
+					// Lower the OS priority of background threads (the nice value can be set per thread on Linux):
+					setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), type == WorkerType::Low ? 10 : 5);
 				}
+#endif // PLATFORM_LINUX
+
+				WorkerLoop();
 
 			});
 			std::thread& worker = internal_state.threads.back();
@@ -165,17 +1285,33 @@ namespace wi::jobsystem
 			// Do Windows-specific thread setup:
 			HANDLE handle = (HANDLE)worker.native_handle();
 
-			// Put each thread on to dedicated core:
-			DWORD_PTR affinityMask = 1ull << threadID;
-			DWORD_PTR affinity_result = SetThreadAffinityMask(handle, affinityMask);
-			assert(affinity_result > 0);
+			std::wstring wthreadname;
+			if (type == WorkerType::Frame)
+			{
+				if (pinned_cpu != nullptr)
+				{
+					// Put each thread on to dedicated core:
+					DWORD_PTR affinityMask = 1ull << pinned_cpu->id;
+					DWORD_PTR affinity_result = SetThreadAffinityMask(handle, affinityMask);
+					assert(affinity_result > 0);
+				}
+
+				//// Increase thread priority:
+				//BOOL priority_result = SetThreadPriority(handle, THREAD_PRIORITY_HIGHEST);
+				//assert(priority_result != 0);
+
+				wthreadname = L"wi::jobsystem_" + std::to_wstring(threadID);
+			}
+			else
+			{
+				// Background threads are not pinned, and they have lower priority than the frame workers:
+				BOOL priority_result = SetThreadPriority(handle, type == WorkerType::Low ? THREAD_PRIORITY_LOWEST : THREAD_PRIORITY_BELOW_NORMAL);
+				assert(priority_result != 0);
 
-			//// Increase thread priority:
-			//BOOL priority_result = SetThreadPriority(handle, THREAD_PRIORITY_HIGHEST);
-			//assert(priority_result != 0);
+				wthreadname = (type == WorkerType::Low ? L"wi::jobsystem_low_" : L"wi::jobsystem_streaming_") + std::to_wstring(typeThreadID);
+			}
 
 			// Name the thread:
-			std::wstring wthreadname = L"wi::jobsystem_" + std::to_wstring(threadID);
 			HRESULT hr = SetThreadDescription(handle, wthreadname.c_str());
 			assert(SUCCEEDED(hr));
 #elif defined(PLATFORM_LINUX)
@@ -183,25 +1319,42 @@ namespace wi::jobsystem
                do { errno = en; perror(msg); } while (0)
 
 			int ret;
-			cpu_set_t cpuset;
-			CPU_ZERO(&cpuset);
-			size_t cpusetsize = sizeof(cpuset);
+			std::string thread_name;
+			if (type == WorkerType::Frame)
+			{
+				if (pinned_cpu != nullptr)
+				{
+					cpu_set_t cpuset;
+					CPU_ZERO(&cpuset);
+					size_t cpusetsize = sizeof(cpuset);
 
-			CPU_SET(threadID, &cpuset);
-			ret = pthread_setaffinity_np(worker.native_handle(), cpusetsize, &cpuset);
-			if (ret != 0)
-				handle_error_en(ret, std::string(" pthread_setaffinity_np[" + std::to_string(threadID) + ']').c_str());
+					CPU_SET(pinned_cpu->id, &cpuset);
+					ret = pthread_setaffinity_np(worker.native_handle(), cpusetsize, &cpuset);
+					if (ret != 0)
+						handle_error_en(ret, std::string(" pthread_setaffinity_np[" + std::to_string(threadID) + ']').c_str());
+				}
+
+				thread_name = "wi::job::" + std::to_string(threadID);
+			}
+			else
+			{
+				// Background threads are not pinned
+				thread_name = (type == WorkerType::Low ? "wi::job_low::" : "wi::job_strm::") + std::to_string(typeThreadID);
+			}
 
 			// Name the thread
-			std::string thread_name = "wi::job::" + std::to_string(threadID);
 			ret = pthread_setname_np(worker.native_handle(), thread_name.c_str());
 			if (ret != 0)
 				handle_error_en(ret, std::string(" pthread_setname_np[" + std::to_string(threadID) + ']').c_str());
 #undef handle_error_en
+#else
+			(void)worker;
+			(void)typeThreadID;
+			(void)pinned_cpu;
 #endif // _WIN32
 		}
 
-		wi::backlog::post("wi::jobsystem Initialized with [" + std::to_string(internal_state.numCores) + " cores] [" + std::to_string(internal_state.numThreads) + " threads] (" + std::to_string((int)std::round(timer.elapsed())) + " ms)");
+		wi::backlog::post("wi::jobsystem Initialized with [" + std::to_string(internal_state.numCores) + " cores] [" + std::to_string(topology.physicalCoreCount) + " physical cores] [" + std::to_string(topology.numaNodeCount) + " NUMA nodes] [" + std::to_string(internal_state.numThreads) + " threads] [" + std::to_string(internal_state.numLowThreads) + " low priority threads] [" + std::to_string(internal_state.numStreamingThreads) + " streaming threads] (" + std::to_string((int)std::round(timer.elapsed())) + " ms)");
 	}
 
 	void ShutDown()
@@ -209,29 +1362,37 @@ namespace wi::jobsystem
 		internal_state.ShutDown();
 	}
 
+	void SetAffinityPolicy(AffinityPolicy policy, uint64_t affinityMask)
+	{
+		configuration.affinityPolicy = policy;
+		configuration.affinityMask = affinityMask;
+	}
+
 	uint32_t GetThreadCount()
 	{
 		return internal_state.numThreads;
 	}
 
-	void Execute(context& ctx, const std::function<void(JobArgs)>& task)
+	inline Task* AllocateTask(context& ctx, const TaskFunction& func, uint32_t refcount, size_t sharedmemory_size)
+	{
+		Task* task = task_pool.allocate();
+		task->func = func;
+		task->ctx = &ctx;
+		task->sharedmemory_size = (uint32_t)sharedmemory_size;
+		task->refcount.store(refcount, std::memory_order_relaxed);
+		task->splittable = false;
+		return task;
+	}
+
+	void Execute(context& ctx, const TaskFunction& task)
 	{
 		// Context state is updated:
 		ctx.counter.fetch_add(1);
 
-		Job job;
-		job.ctx = &ctx;
-		job.task = task;
-		job.groupID = 0;
-		job.groupJobOffset = 0;
-		job.groupJobEnd = 1;
-		job.sharedmemory_size = 0;
-
-		internal_state.jobQueuePerThread[internal_state.nextQueue.fetch_add(1) % internal_state.numThreads].push_back(job);
-		internal_state.wakeCondition.notify_one();
+		Submit(AllocateTask(ctx, task, 1, 0), 1, 1);
 	}
 
-	void Dispatch(context& ctx, uint32_t jobCount, uint32_t groupSize, const std::function<void(JobArgs)>& task, size_t sharedmemory_size)
+	void Dispatch(context& ctx, uint32_t jobCount, uint32_t groupSize, const TaskFunction& task, size_t sharedmemory_size)
 	{
 		if (jobCount == 0 || groupSize == 0)
 		{
@@ -243,22 +1404,77 @@ namespace wi::jobsystem
 		// Context state is updated:
 		ctx.counter.fetch_add(groupCount);
 
-		Job job;
-		job.ctx = &ctx;
-		job.task = task;
-		job.sharedmemory_size = (uint32_t)sharedmemory_size;
+		// All groups will reference the same task:
+		Submit(AllocateTask(ctx, task, groupCount, sharedmemory_size), jobCount, groupSize);
+	}
 
-		for (uint32_t groupID = 0; groupID < groupCount; ++groupID)
+	void ParallelFor(context& ctx, uint32_t count, const TaskFunction& task, size_t sharedmemory_size)
+	{
+		if (count == 0)
 		{
-			// For each group, generate one real job:
-			job.groupID = groupID;
-			job.groupJobOffset = groupID * groupSize;
-			job.groupJobEnd = std::min(job.groupJobOffset + groupSize, jobCount);
+			return;
+		}
+
+		// Context state is updated, it is incremented further by every split:
+		ctx.counter.fetch_add(1);
+
+		// The whole range starts as a single job, that will be split when other threads are idle:
+		Task* range = AllocateTask(ctx, task, 1, sharedmemory_size);
+		range->splittable = true;
+		range->grainSize.store(1, std::memory_order_relaxed);
+		range->groupCounter.store(0, std::memory_order_relaxed);
+		Submit(range, count, count);
+	}
+
+	// Link the task into the continuation list of every dependency, it will be submitted when the last one finishes
+	inline void SubmitAfter(Task* task, uint32_t jobCount, uint32_t groupSize, std::initializer_list<context*> dependencies)
+	{
+		task->jobCount = jobCount;
+		task->groupSize = groupSize;
+		task->dependencies.store(uint32_t(dependencies.size()) + 1, std::memory_order_relaxed); // +1: held until all continuations are linked
+
+		for (context* dependency : dependencies)
+		{
+			assert(dependency != nullptr);
+			assert(dependency != task->ctx); // a context can't wait for itself
+
+			// The dependency is kept busy while linking, so that it can't become idle in the meantime.
+			//	If it was already idle, then the Release() below will resolve this continuation immediately
+			Continuation* continuation = continuation_pool.allocate();
+			continuation->pending = task;
+			dependency->locker.lock();
+			dependency->counter.fetch_add(1);
+			continuation->next = dependency->continuations.load(std::memory_order_relaxed);
+			dependency->continuations.store(continuation, std::memory_order_release);
+			dependency->locker.unlock();
 
-			internal_state.jobQueuePerThread[internal_state.nextQueue.fetch_add(1) % internal_state.numThreads].push_back(job);
+			Release(*dependency);
 		}
 
-		internal_state.wakeCondition.notify_all();
+		ReleasePending(task);
+	}
+
+	void Execute(context& ctx, const TaskFunction& task, std::initializer_list<context*> dependencies)
+	{
+		// Context state is updated, the ctx is busy while waiting for dependencies too:
+		ctx.counter.fetch_add(1);
+
+		SubmitAfter(AllocateTask(ctx, task, 1, 0), 1, 1, dependencies);
+	}
+
+	void Dispatch(context& ctx, uint32_t jobCount, uint32_t groupSize, const TaskFunction& task, std::initializer_list<context*> dependencies, size_t sharedmemory_size)
+	{
+		if (jobCount == 0 || groupSize == 0)
+		{
+			return;
+		}
+
+		const uint32_t groupCount = DispatchGroupCount(jobCount, groupSize);
+
+		// Context state is updated, the ctx is busy while waiting for dependencies too:
+		ctx.counter.fetch_add(groupCount);
+
+		SubmitAfter(AllocateTask(ctx, task, groupCount, sharedmemory_size), jobCount, groupSize, dependencies);
 	}
 
 	uint32_t DispatchGroupCount(uint32_t jobCount, uint32_t groupSize)
@@ -277,20 +1493,114 @@ namespace wi::jobsystem
 	{
 		if (IsBusy(ctx))
 		{
-			// Wake any threads that might be sleeping:
-			internal_state.wakeCondition.notify_all();
-
-			// work() will pick up any jobs that are on stand by and execute them on this thread:
-			work(internal_state.nextQueue.fetch_add(1) % internal_state.numThreads);
+			ThreadState& state = GetThreadState();
+			auto& waker = internal_state.wakers[int(state.type)];
 
+			Job job;
 			while (IsBusy(ctx))
 			{
-				// If we are here, then there are still remaining jobs that work() couldn't pick up.
+				// Pick up any jobs that are on stand by (own queue first, then steal) and execute them on this thread:
+				//	Only the priorities that this thread is allowed to execute are picked up, so a frame thread
+				//	waiting for background work won't pick up long running background jobs
+				if (FindJob(job))
+				{
+					ExecuteJob(job);
+					continue;
+				}
+
+				// If we are here, then there are still remaining jobs that couldn't be picked up.
 				//	In this case those jobs are not standing by on a queue but currently executing
 				//	on other threads, so they cannot be picked up by this thread.
-				//	Allow to swap out this thread by OS to not spin endlessly for nothing
-				std::this_thread::yield();
+				//	Spin for a while, because they are often finished soon:
+				bool found = false;
+				bool idle = false;
+				for (uint32_t i = 0; i < state.spin_count && !found && !idle; ++i)
+				{
+					_mm_pause();
+					idle = !IsBusy(ctx);
+					found = !idle && FindJob(job);
+				}
+				AdaptSpinCount(state, found || idle);
+				if (found || idle)
+				{
+					internal_state.spins.fetch_add(1, std::memory_order_relaxed);
+					if (found)
+					{
+						ExecuteJob(job);
+					}
+					continue;
+				}
+
+				// Park until a context becomes idle, or a new job arrives that this thread can execute:
+				waker.context_waiters.fetch_add(1, std::memory_order_seq_cst);
+				const uint32_t key = waker.event.prepare_wait();
+				found = false;
+				if (IsBusy(ctx) && !(found = FindJob(job)))
+				{
+					internal_state.parks.fetch_add(1, std::memory_order_relaxed);
+					Trace(TraceEventType::Park);
+					waker.event.wait(key);
+					Trace(TraceEventType::Wake);
+					internal_state.wakeups.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					waker.event.cancel_wait();
+				}
+				waker.context_waiters.fetch_sub(1, std::memory_order_relaxed);
+				if (found)
+				{
+					ExecuteJob(job);
+				}
 			}
 		}
+
+		// A thread that made the context idle could be still starting its continuations inside the lock:
+		ctx.locker.lock();
+		ctx.locker.unlock();
+	}
+
+	Statistics GetStatistics()
+	{
+		Statistics statistics;
+		statistics.wakeups = internal_state.wakeups.load(std::memory_order_relaxed);
+		statistics.spins = internal_state.spins.load(std::memory_order_relaxed);
+		statistics.parks = internal_state.parks.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	void SetTraceEnabled(bool value)
+	{
+		trace_state.enabled.store(value);
+	}
+	bool IsTraceEnabled()
+	{
+		return trace_state.enabled.load(std::memory_order_relaxed);
+	}
+	void TraceRecord(TraceEventType type, const char* name, uint32_t arg0, uint32_t arg1)
+	{
+		Trace(type, name, arg0, arg1);
+	}
+	void GetTrace(wi::vector<TraceThread>& threads)
+	{
+		std::scoped_lock lock(trace_state.locker);
+		threads.clear();
+		for (auto& buffer : trace_state.buffers)
+		{
+			TraceThread& thread = threads.emplace_back();
+			buffer->read(thread);
+			if (thread.events.empty())
+			{
+				threads.pop_back();
+			}
+		}
+	}
+	void ClearTrace()
+	{
+		std::scoped_lock lock(trace_state.locker);
+		for (auto& buffer : trace_state.buffers)
+		{
+			buffer->clear_position.store(buffer->write_position.load());
+		}
 	}
 }
@@ -1,13 +1,49 @@
 #pragma once
 
+#include "wiSpinLock.h"
+#include "wiVector.h"
+
 #include <functional>
 #include <atomic>
+#include <initializer_list>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <string>
 
 namespace wi::jobsystem
 {
-	void Initialize(uint32_t maxThreadCount = ~0u);
+	// Initialize the worker threads
+	//	maxThreadCount			: maximum number of threads executing High and Normal priority jobs (by default one per CPU core, excluding the main thread)
+	//	lowPriorityThreadCount	: number of threads reserved for Low priority jobs (by default half of the frame threads, but at least one)
+	//	streamingThreadCount	: number of threads reserved for Streaming priority jobs (at least one)
+	void Initialize(uint32_t maxThreadCount = ~0u, uint32_t lowPriorityThreadCount = ~0u, uint32_t streamingThreadCount = 1);
 	void ShutDown();
 
+	// How the frame threads are assigned to logical CPUs
+	enum class AffinityPolicy
+	{
+		PhysicalCoresFirst,	// pin to one logical CPU of every physical core first, then to their SMT siblings (default)
+		NoPinning,			// don't pin, the OS scheduler decides
+		ExplicitMask,		// pin only to the logical CPUs that are set in the mask (the first 64 logical CPUs can be selected)
+	};
+	// Set the affinity policy, must be called before Initialize()
+	//	The number of threads is also limited by the process affinity, the cgroup cpuset and CPU quota (in containers), and the explicit mask
+	void SetAffinityPolicy(AffinityPolicy policy, uint64_t affinityMask = 0);
+
+	// The priority of the jobs is specified with the context that they are executed with
+	//	High and Normal priority jobs are executed by the frame threads, and High jobs are preferred
+	//	Low and Streaming priority jobs are executed by their own reserved threads with lower OS thread priority, so they never delay the frame threads
+	enum class Priority
+	{
+		High,		// per frame jobs that are on the critical path, such as culling
+		Normal,		// per frame jobs (default)
+		Low,		// long running background jobs, such as terrain generation
+		Streaming,	// resource loading
+		Count
+	};
+
 	struct JobArgs
 	{
 		uint32_t jobIndex;		// job index relative to dispatch (like SV_DispatchThreadID in HLSL)
@@ -18,22 +54,142 @@ namespace wi::jobsystem
 		void* sharedmemory;		// stack memory shared within the current group (jobs within a group execute serially)
 	};
 
+	// Returns the number of threads that are executing High and Normal priority jobs
 	uint32_t GetThreadCount();
 
+	// Type erased callable that stores the task inline instead of allocating it on the heap like std::function
+	//	The lambda captures must fit into the fixed capacity, which is checked at compile time.
+	//	Large captured objects should be captured by reference or pointer instead.
+	class TaskFunction
+	{
+	public:
+		static constexpr size_t capacity = 64; // bytes available for the callable object
+
+		TaskFunction() = default;
+		template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, TaskFunction>>>
+		TaskFunction(F&& func)
+		{
+			using T = std::decay_t<F>;
+			static_assert(std::is_invocable_v<T&, JobArgs>, "TaskFunction must be callable with JobArgs!");
+			static_assert(sizeof(T) <= capacity, "TaskFunction captures are too large, capture by reference or pointer instead!");
+			static_assert(alignof(T) <= alignof(std::max_align_t), "TaskFunction captures are over-aligned!");
+			new (storage) T(std::forward<F>(func));
+			invoker = [](void* storage, JobArgs args) {
+				(*std::launder(reinterpret_cast<T*>(storage)))(args);
+			};
+			manager = [](Operation op, void* dst, void* src) {
+				T* obj = std::launder(reinterpret_cast<T*>(src));
+				switch (op)
+				{
+				case Operation::Copy:
+					new (dst) T(*obj);
+					break;
+				case Operation::Move:
+					new (dst) T(std::move(*obj));
+					obj->~T();
+					break;
+				case Operation::Destroy:
+					obj->~T();
+					break;
+				}
+			};
+		}
+		TaskFunction(const TaskFunction& other) { *this = other; }
+		TaskFunction(TaskFunction&& other) noexcept { *this = std::move(other); }
+		~TaskFunction() { reset(); }
+
+		TaskFunction& operator=(const TaskFunction& other)
+		{
+			if (this != &other)
+			{
+				reset();
+				if (other.manager != nullptr)
+				{
+					other.manager(Operation::Copy, storage, const_cast<uint8_t*>(other.storage));
+				}
+				invoker = other.invoker;
+				manager = other.manager;
+			}
+			return *this;
+		}
+		TaskFunction& operator=(TaskFunction&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				if (other.manager != nullptr)
+				{
+					other.manager(Operation::Move, storage, other.storage);
+				}
+				invoker = other.invoker;
+				manager = other.manager;
+				other.invoker = nullptr;
+				other.manager = nullptr;
+			}
+			return *this;
+		}
+
+		void reset()
+		{
+			if (manager != nullptr)
+			{
+				manager(Operation::Destroy, nullptr, storage);
+			}
+			invoker = nullptr;
+			manager = nullptr;
+		}
+
+		inline void operator()(JobArgs args) const { invoker(const_cast<uint8_t*>(storage), args); }
+		explicit operator bool() const { return invoker != nullptr; }
+
+	private:
+		enum class Operation { Copy, Move, Destroy };
+		alignas(std::max_align_t) uint8_t storage[capacity];
+		void(*invoker)(void* storage, JobArgs args) = nullptr;
+		void(*manager)(Operation op, void* dst, void* src) = nullptr;
+	};
+
+	struct Continuation;
+
 	// Defines a state of execution, can be waited on
+	//	It can also be used as a dependency of other tasks, see Execute() and Dispatch() with dependencies
 	struct context
 	{
 		std::atomic<uint32_t> counter{ 0 };
+		std::atomic<Continuation*> continuations{ nullptr }; // tasks that will be started when this context becomes idle
+		mutable wi::SpinLock locker; // guards continuations
+		Priority priority = Priority::Normal; // the priority of the jobs that are executed with this context
+		const char* name = nullptr; // label of the jobs in the timeline capture, it must be a string with static lifetime
 	};
 
 	// Add a task to execute asynchronously. Any idle thread will execute this.
-	void Execute(context& ctx, const std::function<void(JobArgs)>& task);
+	void Execute(context& ctx, const TaskFunction& task);
 
 	// Divide a task onto multiple jobs and execute in parallel.
 	//	jobCount	: how many jobs to generate for this task.
 	//	groupSize	: how many jobs to execute per thread. Jobs inside a group execute serially. It might be worth to increase for small jobs
 	//	task		: receives a JobArgs as parameter
-	void Dispatch(context& ctx, uint32_t jobCount, uint32_t groupSize, const std::function<void(JobArgs)>& task, size_t sharedmemory_size = 0);
+	void Dispatch(context& ctx, uint32_t jobCount, uint32_t groupSize, const TaskFunction& task, size_t sharedmemory_size = 0);
+
+	// Same as Execute(), but the task will only be started after all the dependencies became idle
+	//	This makes it possible to build a task graph without blocking the calling thread with Wait()
+	//	dependencies	: contexts that must finish before the task can start. The ctx itself must not be a dependency.
+	//	A dependency that is already idle at the time of this call is considered finished
+	//	A context that is used as a dependency must be waited on with Wait() before it is destroyed
+	void Execute(context& ctx, const TaskFunction& task, std::initializer_list<context*> dependencies);
+
+	// Same as Dispatch(), but the jobs will only be started after all the dependencies became idle
+	//	dependencies	: contexts that must finish before the jobs can start. The ctx itself must not be a dependency.
+	void Dispatch(context& ctx, uint32_t jobCount, uint32_t groupSize, const TaskFunction& task, std::initializer_list<context*> dependencies, size_t sharedmemory_size = 0);
+
+	// Execute a task for every job index in [0, count) in parallel, without having to choose a group size
+	//	The range starts as a single job, and its remaining half is split off only when the executing thread has no other jobs queued,
+	//	so that idle threads can steal it (lazy binary splitting). The number of jobs executed between the split checks is adapted
+	//	to the measured duration of the jobs, so this works well for both small and large jobs.
+	//	The JobArgs have the same meaning as with Dispatch(), but the groups are created dynamically:
+	//	a group is a contiguous range of jobs executed serially by one thread, groupID is unique but the group count is not known in advance.
+	//	sharedmemory_size	: per group memory, for example to accumulate partial results, see ParallelReduce()
+	void ParallelFor(context& ctx, uint32_t count, const TaskFunction& task, size_t sharedmemory_size = 0);
 
 	// Returns the amount of job groups that will be created for a set number of jobs and group size
 	uint32_t DispatchGroupCount(uint32_t jobCount, uint32_t groupSize);
@@ -43,5 +199,108 @@ namespace wi::jobsystem
 
 	// Wait until all threads become idle
 	//	Current thread will become a worker thread, executing jobs
+	//	When there are no jobs that it could execute, it spins for a short while, then it is parked until the context becomes idle
 	void Wait(const context& ctx);
+
+	// Counters of the scheduler for profiling, accumulated since the start of the application
+	struct Statistics
+	{
+		uint64_t wakeups = 0;	// parked threads that were woken up
+		uint64_t spins = 0;		// idle periods that ended with finding work while spinning, without parking
+		uint64_t parks = 0;		// idle periods that ended with parking the thread
+	};
+	Statistics GetStatistics();
+
+	// Parallel reduction over [0, count) with ParallelFor(), the calling thread waits for the result
+	//	accumulate	: void(T& partial, uint32_t index), adds an element to the partial result of a group
+	//	combine		: void(T& result, const T& partial), merges the partial result of a group, it is called by one thread at a time
+	//	The partial results are started from identity, and the order of combining them is not specified
+	template<typename T, typename Accumulate, typename Combine>
+	T ParallelReduce(uint32_t count, const T& identity, const Accumulate& accumulate, const Combine& combine, Priority priority = Priority::Normal)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "ParallelReduce result type is over-aligned!");
+		T result = identity;
+		wi::SpinLock locker;
+		context ctx;
+		ctx.priority = priority;
+		ParallelFor(ctx, count, [&](JobArgs args) {
+			T& partial = *(T*)args.sharedmemory;
+			if (args.isFirstJobInGroup)
+			{
+				new (&partial) T(identity);
+			}
+			accumulate(partial, args.jobIndex);
+			if (args.isLastJobInGroup)
+			{
+				locker.lock();
+				combine(result, partial);
+				locker.unlock();
+				partial.~T();
+			}
+		}, sizeof(T));
+		Wait(ctx);
+		return result;
+	}
+
+	// Same as above, but it doesn't wait, the reduction is finished when ctx becomes idle
+	//	This way multiple reductions can be running into the same result, and they can be waited on together
+	//	result and locker must stay valid until the ctx is waited on, the locker guards the result while combining
+	//	The partial results are started from T(), so that must be the identity of combine (for example a hit result with infinite distance)
+	//	The accumulate and combine functions are copied into the task, so they should capture by reference or pointer
+	template<typename T, typename Accumulate, typename Combine>
+	void ParallelReduce(context& ctx, uint32_t count, T& result, wi::SpinLock& locker, const Accumulate& accumulate, const Combine& combine)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "ParallelReduce result type is over-aligned!");
+		ParallelFor(ctx, count, [&result, &locker, accumulate, combine](JobArgs args) {
+			T& partial = *(T*)args.sharedmemory;
+			if (args.isFirstJobInGroup)
+			{
+				new (&partial) T();
+			}
+			accumulate(partial, args.jobIndex);
+			if (args.isLastJobInGroup)
+			{
+				locker.lock();
+				combine(result, partial);
+				locker.unlock();
+				partial.~T();
+			}
+		}, sizeof(T));
+	}
+
+	// Timeline capture of what every thread executed, for offline analysis (see wi::profiler::ExportChromeTrace())
+	//	Every thread records its events into its own ring buffer, when it is full, the oldest events are overwritten.
+	//	When the capture is disabled, recording an event costs only a relaxed atomic load.
+	enum class TraceEventType : uint8_t
+	{
+		JobBegin,	// name: label of the context, arg0: first job index, arg1: end job index
+		JobEnd,
+		Steal,		// the next job was stolen from an other thread's queue, arg0: the queue index
+		Park,		// the thread went to sleep because it didn't find jobs
+		Wake,		// the thread woke up
+		RangeBegin,	// name: wi::profiler CPU range
+		RangeEnd,
+	};
+	struct TraceEvent
+	{
+		uint64_t timestamp = 0;		// nanoseconds, steady clock
+		const char* name = nullptr;
+		uint32_t arg0 = 0;
+		uint32_t arg1 = 0;
+		TraceEventType type = TraceEventType::JobBegin;
+	};
+	struct TraceThread
+	{
+		std::string name;
+		wi::vector<TraceEvent> events; // ordered by timestamp
+	};
+	void SetTraceEnabled(bool value);
+	bool IsTraceEnabled();
+	// Record an event on the calling thread, if the capture is enabled
+	//	name	: must be a string with static lifetime, or nullptr
+	void TraceRecord(TraceEventType type, const char* name = nullptr, uint32_t arg0 = 0, uint32_t arg1 = 0);
+	// Copy the captured events of every thread that recorded any. It can be called while the capture is running
+	void GetTrace(wi::vector<TraceThread>& threads);
+	// Discard the captured events
+	void ClearTrace();
 }
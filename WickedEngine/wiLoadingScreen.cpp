@@ -37,6 +37,8 @@ namespace wi
 
 	void LoadingScreen::Start()
 	{
+		// Loading runs on the streaming threads, so that it doesn't compete with the per-frame jobs of the loading screen:
+		ctx.priority = wi::jobsystem::Priority::Streaming;
 		for (auto& x : tasks)
 		{
 			wi::jobsystem::Execute(ctx, x);
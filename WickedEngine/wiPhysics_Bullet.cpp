@@ -124,6 +124,10 @@ namespace wi::physics
 		{
 			std::shared_ptr<void> physics_scene;
 			std::unique_ptr<btSoftBody> softBody;
+			// Scratch arrays of the pinned nodes that are reused in every simulation step:
+			wi::vector<uint32_t> pinned_nodes;
+			wi::vector<uint32_t> pinned_vertices;
+			wi::vector<XMFLOAT3> pinned_positions;
 			~SoftBody()
 			{
 				if (physics_scene == nullptr)
@@ -571,7 +575,8 @@ namespace wi::physics
 
 			if (physicscomponent.physicsobject != nullptr)
 			{
-				btSoftBody* softbody = GetSoftBody(physicscomponent).softBody.get();
+				SoftBody& physicsobject = GetSoftBody(physicscomponent);
+				btSoftBody* softbody = physicsobject.softBody.get();
 				softbody->getWorldInfo()->m_gravity = dynamicsWorld.getGravity();
 				softbody->m_cfg.kDF = physicscomponent.friction;
 				softbody->setWindVelocity(wind);
@@ -582,22 +587,39 @@ namespace wi::physics
 				// This is different from rigid bodies, because soft body is a per mesh component (no TransformComponent). World matrix is propagated down from single mesh instance (ObjectUpdateSystem).
 				XMMATRIX worldMatrix = XMLoadFloat4x4(&physicscomponent.worldMatrix);
 
-				// System controls zero weight soft body nodes:
+				// System controls zero weight soft body nodes, only these vertices are skinned:
+				wi::vector<uint32_t>& pinned_nodes = physicsobject.pinned_nodes;
+				wi::vector<uint32_t>& pinned_vertices = physicsobject.pinned_vertices;
+				wi::vector<XMFLOAT3>& pinned_positions = physicsobject.pinned_positions;
+				pinned_nodes.clear();
+				pinned_vertices.clear();
 				for (size_t ind = 0; ind < physicscomponent.weights.size(); ++ind)
 				{
-					float weight = physicscomponent.weights[ind];
-
-					if (weight == 0)
+					if (physicscomponent.weights[ind] == 0)
+					{
+						pinned_nodes.push_back((uint32_t)ind);
+						pinned_vertices.push_back(physicscomponent.physicsToGraphicsVertexMapping[ind]);
+					}
+				}
+				pinned_positions.resize(pinned_vertices.size());
+				if (armature == nullptr || armature->boneData.empty())
+				{
+					for (size_t i = 0; i < pinned_vertices.size(); ++i)
 					{
-						btSoftBody::Node& node = softbody->m_nodes[(uint32_t)ind];
-						uint32_t graphicsInd = physicscomponent.physicsToGraphicsVertexMapping[ind];
-						XMFLOAT3 position = mesh.vertex_positions[graphicsInd];
-						XMVECTOR P = armature == nullptr ? XMLoadFloat3(&position) : wi::scene::SkinVertex(mesh, *armature, graphicsInd);
-						P = XMVector3Transform(P, worldMatrix);
-						XMStoreFloat3(&position, P);
-						node.m_x = btVector3(position.x, position.y, position.z);
+						pinned_positions[i] = mesh.vertex_positions[pinned_vertices[i]];
 					}
 				}
+				else
+				{
+					wi::scene::SkinVertices(mesh, *armature, pinned_vertices.data(), (uint32_t)pinned_vertices.size(), pinned_positions.data());
+				}
+				for (size_t i = 0; i < pinned_nodes.size(); ++i)
+				{
+					btSoftBody::Node& node = softbody->m_nodes[pinned_nodes[i]];
+					XMFLOAT3 position;
+					XMStoreFloat3(&position, XMVector3Transform(XMLoadFloat3(&pinned_positions[i]), worldMatrix));
+					node.m_x = btVector3(position.x, position.y, position.z);
+				}
 			}
 		});
 
@@ -798,6 +798,119 @@ namespace wi::primitive
 		return true;
 	}
 
+	// Packs the sign bits of the four lanes of a comparison result:
+	static inline uint32_t LaneMask(const XMVECTOR& comparison)
+	{
+		XMUINT4 lanes;
+		XMStoreInt4(&lanes.x, comparison);
+		return (lanes.x & 1) | (lanes.y & 2) | (lanes.z & 4) | (lanes.w & 8);
+	}
+	uint32_t Frustum::CheckBoxFast(const AABB4& boxes) const
+	{
+		const XMVECTOR min_x = XMLoadFloat4A(&boxes.min_x);
+		const XMVECTOR min_y = XMLoadFloat4A(&boxes.min_y);
+		const XMVECTOR min_z = XMLoadFloat4A(&boxes.min_z);
+		const XMVECTOR max_x = XMLoadFloat4A(&boxes.max_x);
+		const XMVECTOR max_y = XMLoadFloat4A(&boxes.max_y);
+		const XMVECTOR max_z = XMLoadFloat4A(&boxes.max_z);
+		XMVECTOR inside = XMVectorTrueInt();
+		for (size_t p = 0; p < 6; ++p)
+		{
+			// Same as the single box test, the corner furthest along the plane normal must be in front of the plane:
+			const XMFLOAT4& plane = planes[p];
+			const XMVECTOR x = plane.x < 0 ? min_x : max_x;
+			const XMVECTOR y = plane.y < 0 ? min_y : max_y;
+			const XMVECTOR z = plane.z < 0 ? min_z : max_z;
+			XMVECTOR distance = XMVectorReplicate(plane.w);
+			distance = XMVectorMultiplyAdd(x, XMVectorReplicate(plane.x), distance);
+			distance = XMVectorMultiplyAdd(y, XMVectorReplicate(plane.y), distance);
+			distance = XMVectorMultiplyAdd(z, XMVectorReplicate(plane.z), distance);
+			inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(distance, XMVectorZero()));
+		}
+		return LaneMask(inside);
+	}
+
+	AABB4::AABB4(const AABB* aabbs, uint32_t count)
+	{
+		const AABB invalid;
+		const AABB* lanes[4];
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			lanes[i] = i < count && aabbs[i].IsValid() ? &aabbs[i] : &invalid;
+		}
+		min_x = XMFLOAT4A(lanes[0]->_min.x, lanes[1]->_min.x, lanes[2]->_min.x, lanes[3]->_min.x);
+		min_y = XMFLOAT4A(lanes[0]->_min.y, lanes[1]->_min.y, lanes[2]->_min.y, lanes[3]->_min.y);
+		min_z = XMFLOAT4A(lanes[0]->_min.z, lanes[1]->_min.z, lanes[2]->_min.z, lanes[3]->_min.z);
+		max_x = XMFLOAT4A(lanes[0]->_max.x, lanes[1]->_max.x, lanes[2]->_max.x, lanes[3]->_max.x);
+		max_y = XMFLOAT4A(lanes[0]->_max.y, lanes[1]->_max.y, lanes[2]->_max.y, lanes[3]->_max.y);
+		max_z = XMFLOAT4A(lanes[0]->_max.z, lanes[1]->_max.z, lanes[2]->_max.z, lanes[3]->_max.z);
+		layerMask = XMUINT4(lanes[0]->layerMask, lanes[1]->layerMask, lanes[2]->layerMask, lanes[3]->layerMask);
+	}
+	uint32_t AABB4::intersects(const AABB& b) const
+	{
+		XMVECTOR result = XMVectorGreaterOrEqual(XMLoadFloat4A(&max_x), XMVectorReplicate(b._min.x));
+		result = XMVectorAndInt(result, XMVectorGreaterOrEqual(XMLoadFloat4A(&max_y), XMVectorReplicate(b._min.y)));
+		result = XMVectorAndInt(result, XMVectorGreaterOrEqual(XMLoadFloat4A(&max_z), XMVectorReplicate(b._min.z)));
+		result = XMVectorAndInt(result, XMVectorLessOrEqual(XMLoadFloat4A(&min_x), XMVectorReplicate(b._max.x)));
+		result = XMVectorAndInt(result, XMVectorLessOrEqual(XMLoadFloat4A(&min_y), XMVectorReplicate(b._max.y)));
+		result = XMVectorAndInt(result, XMVectorLessOrEqual(XMLoadFloat4A(&min_z), XMVectorReplicate(b._max.z)));
+		return LaneMask(result);
+	}
+	uint32_t AABB4::intersects(const Sphere& b) const
+	{
+		// Distance of the sphere center to the closest point of the boxes, invalid boxes produce a huge distance:
+		const XMVECTOR center_x = XMVectorReplicate(b.center.x);
+		const XMVECTOR center_y = XMVectorReplicate(b.center.y);
+		const XMVECTOR center_z = XMVectorReplicate(b.center.z);
+		const XMVECTOR dx = XMVectorMin(XMVectorMax(center_x, XMLoadFloat4A(&min_x)), XMLoadFloat4A(&max_x)) - center_x;
+		const XMVECTOR dy = XMVectorMin(XMVectorMax(center_y, XMLoadFloat4A(&min_y)), XMLoadFloat4A(&max_y)) - center_y;
+		const XMVECTOR dz = XMVectorMin(XMVectorMax(center_z, XMLoadFloat4A(&min_z)), XMLoadFloat4A(&max_z)) - center_z;
+		const XMVECTOR distanceSquared = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, dz * dz));
+		return LaneMask(XMVectorLess(distanceSquared, XMVectorReplicate(b.radius * b.radius)));
+	}
+	uint32_t AABB4::intersects(const Ray& b) const
+	{
+		const XMVECTOR _min_x = XMLoadFloat4A(&min_x);
+		const XMVECTOR _min_y = XMLoadFloat4A(&min_y);
+		const XMVECTOR _min_z = XMLoadFloat4A(&min_z);
+		const XMVECTOR _max_x = XMLoadFloat4A(&max_x);
+		const XMVECTOR _max_y = XMLoadFloat4A(&max_y);
+		const XMVECTOR _max_z = XMLoadFloat4A(&max_z);
+		const XMVECTOR origin_x = XMVectorReplicate(b.origin.x);
+		const XMVECTOR origin_y = XMVectorReplicate(b.origin.y);
+		const XMVECTOR origin_z = XMVectorReplicate(b.origin.z);
+
+		// Slab test, same as the single box test:
+		const XMVECTOR tx1 = (_min_x - origin_x) * XMVectorReplicate(b.direction_inverse.x);
+		const XMVECTOR tx2 = (_max_x - origin_x) * XMVectorReplicate(b.direction_inverse.x);
+		const XMVECTOR ty1 = (_min_y - origin_y) * XMVectorReplicate(b.direction_inverse.y);
+		const XMVECTOR ty2 = (_max_y - origin_y) * XMVectorReplicate(b.direction_inverse.y);
+		const XMVECTOR tz1 = (_min_z - origin_z) * XMVectorReplicate(b.direction_inverse.z);
+		const XMVECTOR tz2 = (_max_z - origin_z) * XMVectorReplicate(b.direction_inverse.z);
+		const XMVECTOR tmin = XMVectorMax(XMVectorMax(XMVectorMin(tx1, tx2), XMVectorMin(ty1, ty2)), XMVectorMin(tz1, tz2));
+		const XMVECTOR tmax = XMVectorMin(XMVectorMin(XMVectorMax(tx1, tx2), XMVectorMax(ty1, ty2)), XMVectorMax(tz1, tz2));
+		XMVECTOR hit = XMVectorLessOrEqual(tmin, tmax);
+		hit = XMVectorAndInt(hit, XMVectorGreaterOrEqual(tmax, XMVectorReplicate(b.TMin)));
+		hit = XMVectorAndInt(hit, XMVectorLessOrEqual(tmin, XMVectorReplicate(b.TMax)));
+
+		// The ray origin is inside the box:
+		XMVECTOR inside = XMVectorAndInt(XMVectorLessOrEqual(_min_x, origin_x), XMVectorGreaterOrEqual(_max_x, origin_x));
+		inside = XMVectorAndInt(inside, XMVectorAndInt(XMVectorLessOrEqual(_min_y, origin_y), XMVectorGreaterOrEqual(_max_y, origin_y)));
+		inside = XMVectorAndInt(inside, XMVectorAndInt(XMVectorLessOrEqual(_min_z, origin_z), XMVectorGreaterOrEqual(_max_z, origin_z)));
+
+		// Invalid boxes would pass the slab test with their inverted bounds:
+		XMVECTOR valid = XMVectorLessOrEqual(_min_x, _max_x);
+		valid = XMVectorAndInt(valid, XMVectorLessOrEqual(_min_y, _max_y));
+		valid = XMVectorAndInt(valid, XMVectorLessOrEqual(_min_z, _max_z));
+
+		return LaneMask(XMVectorAndInt(valid, XMVectorOrInt(hit, inside)));
+	}
+	uint32_t AABB4::CheckLayerMask(uint32_t mask) const
+	{
+		const XMVECTOR masked = XMVectorAndInt(XMLoadInt4(&layerMask.x), XMVectorReplicateInt(mask));
+		return LaneMask(XMVectorNotEqualInt(masked, XMVectorZero()));
+	}
+
 	const XMFLOAT4& Frustum::getNearPlane() const { return planes[0]; }
 	const XMFLOAT4& Frustum::getFarPlane() const { return planes[1]; }
 	const XMFLOAT4& Frustum::getLeftPlane() const { return planes[2]; }
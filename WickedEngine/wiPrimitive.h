@@ -11,6 +11,7 @@ namespace wi::primitive
 	struct Sphere;
 	struct Ray;
 	struct AABB;
+	struct AABB4;
 	struct Capsule;
 	struct Plane;
 
@@ -194,6 +195,8 @@ namespace wi::primitive
 		};
 		BoxFrustumIntersect CheckBox(const AABB& box) const;
 		bool CheckBoxFast(const AABB& box) const;
+		// Tests four boxes at once, returns a 4-bit mask with the bits of the boxes that are not outside
+		uint32_t CheckBoxFast(const AABB4& boxes) const;
 
 		const XMFLOAT4& getNearPlane() const;
 		const XMFLOAT4& getFarPlane() const;
@@ -203,6 +206,29 @@ namespace wi::primitive
 		const XMFLOAT4& getBottomPlane() const;
 	};
 
+	// Four AABBs in structure of arrays layout, so that they can be tested together with SIMD instructions
+	//	Unused lanes are invalid boxes, which never pass any of the tests
+	//	The tests return a 4-bit mask with the bits of the lanes that passed
+	struct alignas(16) AABB4
+	{
+		XMFLOAT4A min_x;
+		XMFLOAT4A min_y;
+		XMFLOAT4A min_z;
+		XMFLOAT4A max_x;
+		XMFLOAT4A max_y;
+		XMFLOAT4A max_z;
+		XMUINT4 layerMask;
+
+		AABB4() : AABB4(nullptr, 0) {}
+		// Loads count (at most 4) boxes from the array, the remaining lanes will be invalid
+		AABB4(const AABB* aabbs, uint32_t count);
+
+		uint32_t intersects(const AABB& b) const;
+		uint32_t intersects(const Sphere& b) const;
+		uint32_t intersects(const Ray& b) const;
+		uint32_t CheckLayerMask(uint32_t mask) const;
+	};
+
 	class Hitbox2D
 	{
 	public:
@@ -9,6 +9,8 @@
 #include "wiBacklog.h"
 #include "wiRenderer.h"
 #include "wiEventHandler.h"
+#include "wiJobSystem.h"
+#include "wiUnorderedSet.h"
 
 #if __has_include("Superluminal/PerformanceAPI_capi.h")
 #include "Superluminal/PerformanceAPI_capi.h"
@@ -62,6 +64,17 @@ namespace wi::profiler
 	};
 	wi::unordered_map<size_t, Range> ranges;
 
+	// CPU ranges are also recorded into the timeline capture of wi::jobsystem when it is enabled
+	//	The range names are copied, because the trace events are only storing pointers to them
+	std::mutex trace_lock;
+	wi::unordered_set<std::string> trace_names;
+	static constexpr range_id trace_range = ~range_id(0); // returned when only the timeline capture is enabled
+	const char* GetTraceName(const char* name)
+	{
+		std::scoped_lock lck(trace_lock);
+		return trace_names.insert(name).first->c_str();
+	}
+
 	void BeginFrame()
 	{
 		if (ENABLED_REQUEST != ENABLED)
@@ -188,8 +201,14 @@ namespace wi::profiler
 
 	range_id BeginRangeCPU(const char* name)
 	{
+		const bool trace = wi::jobsystem::IsTraceEnabled();
+		if (trace)
+		{
+			wi::jobsystem::TraceRecord(wi::jobsystem::TraceEventType::RangeBegin, GetTraceName(name));
+		}
+
 		if (!ENABLED || !initialized)
-			return 0;
+			return trace ? trace_range : 0;
 
 #if PERFORMANCEAPI_ENABLED
 		if (superluminal_handle)
@@ -245,6 +264,12 @@ namespace wi::profiler
 	}
 	void EndRange(range_id id)
 	{
+		if (id == trace_range)
+		{
+			wi::jobsystem::TraceRecord(wi::jobsystem::TraceEventType::RangeEnd);
+			return;
+		}
+
 		if (!ENABLED || !initialized)
 			return;
 
@@ -256,6 +281,7 @@ namespace wi::profiler
 			if (it->second.IsCPURange())
 			{
 				it->second.time = (float)it->second.cpuTimer.elapsed();
+				wi::jobsystem::TraceRecord(wi::jobsystem::TraceEventType::RangeEnd);
 
 #if PERFORMANCEAPI_ENABLED
 				if (superluminal_handle)
@@ -670,4 +696,118 @@ namespace wi::profiler
 	{
 		text_color = color;
 	}
+
+	void SetTraceEnabled(bool value)
+	{
+		wi::jobsystem::SetTraceEnabled(value);
+	}
+
+	bool IsTraceEnabled()
+	{
+		return wi::jobsystem::IsTraceEnabled();
+	}
+
+	bool ExportChromeTrace(const std::string& filename)
+	{
+		wi::vector<wi::jobsystem::TraceThread> threads;
+		wi::jobsystem::GetTrace(threads);
+
+		uint64_t start = ~0ull;
+		size_t event_count = 0;
+		for (auto& thread : threads)
+		{
+			start = std::min(start, thread.events.front().timestamp);
+			event_count += thread.events.size();
+		}
+
+		auto append_string = [](std::string& json, const char* str) {
+			json += '"';
+			for (; *str != 0; ++str)
+			{
+				if (*str == '"' || *str == '\\')
+				{
+					json += '\\';
+				}
+				json += *str;
+			}
+			json += '"';
+		};
+		auto append_timestamp = [&](std::string& json, uint64_t timestamp) {
+			// microseconds with nanosecond precision:
+			const uint64_t ns = timestamp - start;
+			const std::string fraction = std::to_string(ns % 1000);
+			json += std::to_string(ns / 1000) + "." + std::string(3 - fraction.size(), '0') + fraction;
+		};
+
+		std::string json;
+		json.reserve(event_count * 96 + 256);
+		json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for (size_t tid = 0; tid < threads.size(); ++tid)
+		{
+			const auto& thread = threads[tid];
+			const std::string common = ",\"pid\":0,\"tid\":" + std::to_string(tid);
+
+			if (!first)
+				json += ",\n";
+			first = false;
+			json += "{\"name\":\"thread_name\",\"ph\":\"M\"" + common + ",\"args\":{\"name\":";
+			append_string(json, thread.name.c_str());
+			json += "}}";
+
+			// The oldest events could be overwritten in the ring buffers, so ends without a begin are skipped:
+			uint32_t depth = 0;
+			for (auto& event : thread.events)
+			{
+				const char* phase = "B";
+				switch (event.type)
+				{
+				case wi::jobsystem::TraceEventType::JobEnd:
+				case wi::jobsystem::TraceEventType::RangeEnd:
+				case wi::jobsystem::TraceEventType::Wake:
+					if (depth == 0)
+						continue;
+					depth--;
+					phase = "E";
+					break;
+				case wi::jobsystem::TraceEventType::Steal:
+					phase = "i";
+					break;
+				default:
+					depth++;
+					break;
+				}
+
+				json += ",\n{\"ph\":\"";
+				json += phase;
+				json += "\",\"ts\":";
+				append_timestamp(json, event.timestamp);
+				json += common;
+				switch (event.type)
+				{
+				case wi::jobsystem::TraceEventType::JobBegin:
+					json += ",\"cat\":\"job\",\"name\":";
+					append_string(json, event.name == nullptr ? "job" : event.name);
+					json += ",\"args\":{\"first\":" + std::to_string(event.arg0) + ",\"end\":" + std::to_string(event.arg1) + "}";
+					break;
+				case wi::jobsystem::TraceEventType::RangeBegin:
+					json += ",\"cat\":\"range\",\"name\":";
+					append_string(json, event.name == nullptr ? "range" : event.name);
+					break;
+				case wi::jobsystem::TraceEventType::Park:
+					json += ",\"cat\":\"idle\",\"name\":\"idle\"";
+					break;
+				case wi::jobsystem::TraceEventType::Steal:
+					json += ",\"cat\":\"steal\",\"name\":\"steal\",\"s\":\"t\",\"args\":{\"queue\":" + std::to_string(event.arg0) + "}";
+					break;
+				default:
+					break;
+				}
+				json += "}";
+			}
+		}
+		json += "\n]}\n";
+
+		return wi::helper::FileWrite(filename, (const uint8_t*)json.data(), json.size());
+	}
 }
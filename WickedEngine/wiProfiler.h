@@ -37,6 +37,16 @@ namespace wi::profiler
 
 	bool IsEnabled();
 
+	// Enable/disable capturing the timeline of every thread: the jobs of wi::jobsystem (with idle and steal events) and the CPU ranges
+	//	This works without enabling the profiler, for example in headless runs without graphics device
+	void SetTraceEnabled(bool value);
+
+	bool IsTraceEnabled();
+
+	// Write the captured timeline to a JSON file in Chrome trace format (can be opened with chrome://tracing or ui.perfetto.dev)
+	//	returns false if the file couldn't be written
+	bool ExportChromeTrace(const std::string& filename);
+
 	void SetBackgroundColor(wi::Color color);
 	void SetTextColor(wi::Color color);
 };
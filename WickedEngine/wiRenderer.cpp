@@ -100,6 +100,7 @@ bool debugBoneLines = false;
 bool debugPartitionTree = false;
 bool debugEmitters = false;
 bool freezeCullingCamera = false;
+bool objectBVHCulling = false;
 bool debugEnvProbes = false;
 bool debugForceFields = false;
 bool debugCameras = false;
@@ -2888,6 +2889,8 @@ void UpdateVisibility(Visibility& vis)
 {
 	// Perform parallel frustum culling and obtain closest reflector:
 	wi::jobsystem::context ctx;
+	ctx.priority = wi::jobsystem::Priority::High;
+	ctx.name = "UpdateVisibility";
 	auto range = wi::profiler::BeginRangeCPU("Frustum Culling");
 
 	assert(vis.scene != nullptr); // User must provide a scene!
@@ -2915,9 +2918,9 @@ void UpdateVisibility(Visibility& vis)
 
 	if (vis.flags & Visibility::ALLOW_LIGHTS)
 	{
-		// Cull lights:
+		// Cull lights, four in each job with the SIMD bounds stream:
 		vis.visibleLights.resize(vis.scene->aabb_lights.size());
-		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_lights.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
+		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_lights_soa.size(), groupSize / 4, [&](wi::jobsystem::JobArgs args) {
 
 			// Setup stream compaction:
 			uint32_t& group_count = *(uint32_t*)args.sharedmemory;
@@ -2927,14 +2930,20 @@ void UpdateVisibility(Visibility& vis)
 				group_count = 0; // first thread initializes local counter
 			}
 
-			const AABB& aabb = vis.scene->aabb_lights[args.jobIndex];
+			const AABB4& block = vis.scene->aabb_lights_soa[args.jobIndex];
+			const uint32_t mask = block.CheckLayerMask(vis.layerMask) & vis.frustum.CheckBoxFast(block);
 
-			if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
+			for (uint32_t lane = 0; lane < 4; ++lane)
 			{
+				if ((mask & (1u << lane)) == 0)
+					continue;
+				const uint32_t lightIndex = args.jobIndex * 4 + lane;
+				const AABB& aabb = vis.scene->aabb_lights[lightIndex];
+
 				// Local stream compaction:
 				//	(also compute light distance for shadow priority sorting)
-				group_list[group_count] = args.jobIndex;
-				const LightComponent& light = vis.scene->lights[args.jobIndex];
+				group_list[group_count] = lightIndex;
+				const LightComponent& light = vis.scene->lights[lightIndex];
 				group_count++;
 				if (light.IsVolumetricsEnabled())
 				{
@@ -2968,75 +2977,135 @@ void UpdateVisibility(Visibility& vis)
 
 	if (vis.flags & Visibility::ALLOW_OBJECTS)
 	{
-		// Cull objects:
 		vis.visibleObjects.resize(vis.scene->aabb_objects.size());
-		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_objects.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
 
-			// Setup stream compaction:
-			uint32_t& group_count = *(uint32_t*)args.sharedmemory;
-			uint32_t* group_list = (uint32_t*)args.sharedmemory + 1;
-			if (args.isFirstJobInGroup)
+		// Processing of an object that is inside the frustum:
+		const auto object_visible = [&vis](uint32_t objectIndex) {
+			const AABB& aabb = vis.scene->aabb_objects[objectIndex];
+			const ObjectComponent& object = vis.scene->objects[objectIndex];
+			Scene::OcclusionResult& occlusion_result = vis.scene->occlusion_results_objects[objectIndex];
+
+			if ((vis.flags & Visibility::ALLOW_REQUEST_REFLECTION) && object.IsRequestPlanarReflection() && !occlusion_result.IsOccluded())
 			{
-				group_count = 0; // first thread initializes local counter
+				// Planar reflection priority request:
+				float dist = wi::math::DistanceEstimated(vis.camera->Eye, object.center);
+				vis.locker.lock();
+				if (dist < vis.closestRefPlane)
+				{
+					vis.closestRefPlane = dist;
+					XMVECTOR P = XMLoadFloat3(&object.center);
+					XMVECTOR N = XMVectorSet(0, 1, 0, 0);
+					N = XMVector3TransformNormal(N, XMLoadFloat4x4(&vis.scene->matrix_objects[objectIndex]));
+					XMVECTOR _refPlane = XMPlaneFromPointNormal(P, N);
+					XMStoreFloat4(&vis.reflectionPlane, _refPlane);
+
+					vis.planar_reflection_visible = true;
+				}
+				vis.locker.unlock();
 			}
 
-			const AABB& aabb = vis.scene->aabb_objects[args.jobIndex];
-
-			if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
+			if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
 			{
-				// Local stream compaction:
-				group_list[group_count++] = args.jobIndex;
-
-				const ObjectComponent& object = vis.scene->objects[args.jobIndex];
-				Scene::OcclusionResult& occlusion_result = vis.scene->occlusion_results_objects[args.jobIndex];
-
-				if ((vis.flags & Visibility::ALLOW_REQUEST_REFLECTION) && object.IsRequestPlanarReflection() && !occlusion_result.IsOccluded())
+				if (object.IsRenderable() && occlusion_result.occlusionQueries[vis.scene->queryheap_idx] < 0)
 				{
-					// Planar reflection priority request:
-					float dist = wi::math::DistanceEstimated(vis.camera->Eye, object.center);
-					vis.locker.lock();
-					if (dist < vis.closestRefPlane)
+					if (aabb.intersects(vis.camera->Eye))
+					{
+						// camera is inside the instance, mark it as visible in this frame:
+						occlusion_result.occlusionHistory |= 1;
+					}
+					else
 					{
-						vis.closestRefPlane = dist;
-						XMVECTOR P = XMLoadFloat3(&object.center);
-						XMVECTOR N = XMVectorSet(0, 1, 0, 0);
-						N = XMVector3TransformNormal(N, XMLoadFloat4x4(&vis.scene->matrix_objects[args.jobIndex]));
-						XMVECTOR _refPlane = XMPlaneFromPointNormal(P, N);
-						XMStoreFloat4(&vis.reflectionPlane, _refPlane);
-
-						vis.planar_reflection_visible = true;
+						occlusion_result.occlusionQueries[vis.scene->queryheap_idx] = vis.scene->queryAllocator.fetch_add(1); // allocate new occlusion query from heap
 					}
-					vis.locker.unlock();
 				}
+			}
+		};
 
-				if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
+		if (GetObjectBVHCullingEnabled() && vis.scene->IsObjectBVHValid())
+		{
+			// Hierarchical culling with the object BVH of the scene:
+			//	Subtrees that are entirely inside the frustum are accepted without testing their objects one by one
+			wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+				const wi::BVH& bvh = vis.scene->object_bvh;
+				uint32_t count = 0;
+				uint32_t stack[64];
+				uint32_t stack_size = 0;
+				stack[stack_size++] = 0;
+				while (stack_size > 0)
 				{
-					if (object.IsRenderable() && occlusion_result.occlusionQueries[vis.scene->queryheap_idx] < 0)
+					const uint32_t nodeIndex = stack[--stack_size];
+					const wi::BVH::Node& node = bvh.nodes[nodeIndex];
+					const Frustum::BoxFrustumIntersect intersect = vis.frustum.CheckBox(node.aabb);
+					if (intersect == Frustum::BOX_FRUSTUM_OUTSIDE)
+						continue;
+					// very deep trees test the objects of the subtree one by one when the stack is full:
+					if (intersect == Frustum::BOX_FRUSTUM_INSIDE || node.isLeaf() || stack_size + 2 > arraysize(stack))
 					{
-						if (aabb.intersects(vis.camera->Eye))
-						{
-							// camera is inside the instance, mark it as visible in this frame:
-							occlusion_result.occlusionHistory |= 1;
-						}
-						else
+						uint32_t offset = 0;
+						uint32_t leaf_count = 0;
+						bvh.GetLeafRange(nodeIndex, offset, leaf_count);
+						for (uint32_t i = offset; i < offset + leaf_count; ++i)
 						{
-							occlusion_result.occlusionQueries[vis.scene->queryheap_idx] = vis.scene->queryAllocator.fetch_add(1); // allocate new occlusion query from heap
+							const uint32_t objectIndex = bvh.leaf_indices[i];
+							const AABB& aabb = vis.scene->aabb_objects[objectIndex];
+							if ((aabb.layerMask & vis.layerMask) == 0 || !aabb.IsValid())
+								continue;
+							if (intersect != Frustum::BOX_FRUSTUM_INSIDE && !vis.frustum.CheckBoxFast(aabb))
+								continue;
+							vis.visibleObjects[count++] = objectIndex;
 						}
+						continue;
 					}
+					stack[stack_size++] = node.left;
+					stack[stack_size++] = node.left + 1;
 				}
-			}
+				vis.object_counter.store(count);
 
-			// Global stream compaction:
-			if (args.isLastJobInGroup && group_count > 0)
-			{
-				uint32_t prev_count = vis.object_counter.fetch_add(group_count);
-				for (uint32_t i = 0; i < group_count; ++i)
+				wi::jobsystem::Dispatch(ctx, count, groupSize, [&](wi::jobsystem::JobArgs args) {
+					object_visible(vis.visibleObjects[args.jobIndex]);
+				});
+			});
+		}
+		else
+		{
+			// Cull objects, four in each job with the SIMD bounds stream:
+			wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_objects_soa.size(), groupSize / 4, [&](wi::jobsystem::JobArgs args) {
+
+				// Setup stream compaction:
+				uint32_t& group_count = *(uint32_t*)args.sharedmemory;
+				uint32_t* group_list = (uint32_t*)args.sharedmemory + 1;
+				if (args.isFirstJobInGroup)
 				{
-					vis.visibleObjects[prev_count + i] = group_list[i];
+					group_count = 0; // first thread initializes local counter
 				}
-			}
 
-			}, sharedmemory_size);
+				const AABB4& block = vis.scene->aabb_objects_soa[args.jobIndex];
+				const uint32_t mask = block.CheckLayerMask(vis.layerMask) & vis.frustum.CheckBoxFast(block);
+
+				for (uint32_t lane = 0; lane < 4; ++lane)
+				{
+					if ((mask & (1u << lane)) == 0)
+						continue;
+					const uint32_t objectIndex = args.jobIndex * 4 + lane;
+
+					// Local stream compaction:
+					group_list[group_count++] = objectIndex;
+
+					object_visible(objectIndex);
+				}
+
+				// Global stream compaction:
+				if (args.isLastJobInGroup && group_count > 0)
+				{
+					uint32_t prev_count = vis.object_counter.fetch_add(group_count);
+					for (uint32_t i = 0; i < group_count; ++i)
+					{
+						vis.visibleObjects[prev_count + i] = group_list[i];
+					}
+				}
+
+				}, sharedmemory_size);
+		}
 	}
 
 	if (vis.flags & Visibility::ALLOW_DECALS)
@@ -15741,6 +15810,8 @@ void SetTemporalAADebugEnabled(bool enabled) { temporalAADEBUG = enabled; }
 bool GetTemporalAADebugEnabled() { return temporalAADEBUG; }
 void SetFreezeCullingCameraEnabled(bool enabled) { freezeCullingCamera = enabled; }
 bool GetFreezeCullingCameraEnabled() { return freezeCullingCamera; }
+void SetObjectBVHCullingEnabled(bool enabled) { objectBVHCulling = enabled; }
+bool GetObjectBVHCullingEnabled() { return objectBVHCulling; }
 void SetVXGIEnabled(bool enabled)
 {
 	VXGI_ENABLED = enabled;
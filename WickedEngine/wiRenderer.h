@@ -978,6 +978,9 @@ namespace wi::renderer
 	bool GetTemporalAADebugEnabled();
 	void SetFreezeCullingCameraEnabled(bool enabled);
 	bool GetFreezeCullingCameraEnabled();
+	// Camera frustum culling of objects traverses the object BVH of the scene instead of testing every object
+	void SetObjectBVHCullingEnabled(bool enabled);
+	bool GetObjectBVHCullingEnabled();
 	void SetVXGIEnabled(bool enabled);
 	bool GetVXGIEnabled();
 	void SetVXGIReflectionsEnabled(bool enabled);
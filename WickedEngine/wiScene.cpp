@@ -206,8 +206,6 @@ namespace wi::scene
 
 		wi::jobsystem::Wait(ctx); // dependencies
 
-		RunHierarchyUpdateSystem(ctx);
-
 		// Lightmap requests are determined at this point, so we know if we need TLAS or not:
 		if (lightmap_request_allocator.load() > 0)
 		{
@@ -303,43 +301,94 @@ namespace wi::scene
 		}
 		skinningDataMapped = skinningUploadBuffer[device->GetBufferIndex()].mapped_data;
 
-		RunExpressionUpdateSystem(ctx);
-
-		RunMeshUpdateSystem(ctx);
-
-		RunMaterialUpdateSystem(ctx);
-
-		wi::jobsystem::Wait(ctx); // dependencies
-
-		RunProceduralAnimationUpdateSystem(ctx);
-
-		RunArmatureUpdateSystem(ctx);
-
-		RunWeatherUpdateSystem(ctx);
-
-		wi::jobsystem::Wait(ctx); // dependencies
-
-		RunObjectUpdateSystem(ctx);
-
-		RunCameraUpdateSystem(ctx);
-
-		RunDecalUpdateSystem(ctx);
-
-		RunProbeUpdateSystem(ctx);
-
-		RunForceUpdateSystem(ctx);
-
-		RunLightUpdateSystem(ctx);
-
-		RunParticleUpdateSystem(ctx);
-
+		// The remaining systems are started as a task graph, each system is started as soon as the systems that it depends on are finished,
+		//	instead of waiting for every system of a previous phase like before:
+		meshletAllocator.store(0u); // shared between object, impostor and particle systems
+		wi::jobsystem::context ctx_hierarchy;
+		wi::jobsystem::context ctx_expression;
+		wi::jobsystem::context ctx_mesh;
+		wi::jobsystem::context ctx_material;
+		wi::jobsystem::context ctx_procedural;
+		wi::jobsystem::context ctx_armature;
+		wi::jobsystem::context ctx_weather;
+		wi::jobsystem::context ctx_object;
+		wi::jobsystem::context ctx_object_bvh;
+		wi::jobsystem::context ctx_aabb_stream;
+		wi::jobsystem::context ctx_camera;
+		wi::jobsystem::context ctx_decal;
+		wi::jobsystem::context ctx_probe;
+		wi::jobsystem::context ctx_force;
+		wi::jobsystem::context ctx_light;
+		wi::jobsystem::context ctx_particle;
+		wi::jobsystem::context ctx_video;
+		wi::jobsystem::context ctx_impostor;
+
+		// Labels for the timeline capture:
+		ctx_hierarchy.name = "HierarchyUpdateSystem";
+		ctx_expression.name = "ExpressionUpdateSystem";
+		ctx_mesh.name = "MeshUpdateSystem";
+		ctx_material.name = "MaterialUpdateSystem";
+		ctx_procedural.name = "ProceduralAnimationUpdateSystem";
+		ctx_armature.name = "ArmatureUpdateSystem";
+		ctx_weather.name = "WeatherUpdateSystem";
+		ctx_object.name = "ObjectUpdateSystem";
+		ctx_object_bvh.name = "ObjectBVHUpdateSystem";
+		ctx_aabb_stream.name = "AABBStreamUpdateSystem";
+		ctx_camera.name = "CameraUpdateSystem";
+		ctx_decal.name = "DecalUpdateSystem";
+		ctx_probe.name = "ProbeUpdateSystem";
+		ctx_force.name = "ForceUpdateSystem";
+		ctx_light.name = "LightUpdateSystem";
+		ctx_particle.name = "ParticleUpdateSystem";
+		ctx_video.name = "VideoUpdateSystem";
+		ctx_impostor.name = "ImpostorUpdateSystem";
+
+		wi::jobsystem::Execute(ctx_hierarchy, [&](wi::jobsystem::JobArgs args) { RunHierarchyUpdateSystem(ctx_hierarchy); });
+		wi::jobsystem::Execute(ctx_expression, [&](wi::jobsystem::JobArgs args) { RunExpressionUpdateSystem(ctx_expression); });
+		wi::jobsystem::Execute(ctx_material, [&](wi::jobsystem::JobArgs args) { RunMaterialUpdateSystem(ctx_material); });
+		wi::jobsystem::Execute(ctx_mesh, [&](wi::jobsystem::JobArgs args) { RunMeshUpdateSystem(ctx_mesh); }, { &ctx_expression });
+		wi::jobsystem::Execute(ctx_procedural, [&](wi::jobsystem::JobArgs args) {
+			// Procedural animation system waits for its own jobs internally, so it can't use the context of this task:
+			wi::jobsystem::context ctx_procedural_internal;
+			ctx_procedural_internal.name = ctx_procedural.name;
+			RunProceduralAnimationUpdateSystem(ctx_procedural_internal);
+		}, { &ctx_hierarchy });
+		wi::jobsystem::Execute(ctx_armature, [&](wi::jobsystem::JobArgs args) { RunArmatureUpdateSystem(ctx_armature); }, { &ctx_procedural });
+		wi::jobsystem::Execute(ctx_weather, [&](wi::jobsystem::JobArgs args) { RunWeatherUpdateSystem(ctx_weather); }, { &ctx_procedural });
+		wi::jobsystem::Execute(ctx_object, [&](wi::jobsystem::JobArgs args) { RunObjectUpdateSystem(ctx_object); }, { &ctx, &ctx_armature, &ctx_mesh, &ctx_material, &ctx_weather });
+		wi::jobsystem::Execute(ctx_object_bvh, [&](wi::jobsystem::JobArgs args) { RunObjectBVHUpdateSystem(ctx_object_bvh); }, { &ctx_object });
+		wi::jobsystem::Execute(ctx_camera, [&](wi::jobsystem::JobArgs args) { RunCameraUpdateSystem(ctx_camera); }, { &ctx_procedural });
+		wi::jobsystem::Execute(ctx_decal, [&](wi::jobsystem::JobArgs args) { RunDecalUpdateSystem(ctx_decal); }, { &ctx_procedural, &ctx_material });
+		wi::jobsystem::Execute(ctx_probe, [&](wi::jobsystem::JobArgs args) { RunProbeUpdateSystem(ctx_probe); }, { &ctx_procedural });
+		wi::jobsystem::Execute(ctx_force, [&](wi::jobsystem::JobArgs args) { RunForceUpdateSystem(ctx_force); }, { &ctx_procedural });
+		wi::jobsystem::Execute(ctx_light, [&](wi::jobsystem::JobArgs args) { RunLightUpdateSystem(ctx_light); }, { &ctx_procedural, &ctx_weather });
+		wi::jobsystem::Execute(ctx_aabb_stream, [&](wi::jobsystem::JobArgs args) { RunAABBStreamUpdateSystem(ctx_aabb_stream); }, { &ctx_object, &ctx_light });
+		wi::jobsystem::Execute(ctx_particle, [&](wi::jobsystem::JobArgs args) { RunParticleUpdateSystem(ctx_particle); }, { &ctx, &ctx_armature, &ctx_mesh, &ctx_material });
+		wi::jobsystem::Execute(ctx_video, [&](wi::jobsystem::JobArgs args) { RunVideoUpdateSystem(ctx_video); }, { &ctx_material });
+		wi::jobsystem::Execute(ctx_impostor, [&](wi::jobsystem::JobArgs args) { RunImpostorUpdateSystem(ctx_impostor); }, { &ctx_mesh, &ctx_material });
+
+		// Sound system uses the audio device, so it stays on this thread:
+		wi::jobsystem::Wait(ctx_procedural);
 		RunSoundUpdateSystem(ctx);
 
-		RunVideoUpdateSystem(ctx);
-
-		RunImpostorUpdateSystem(ctx);
-
-		wi::jobsystem::Wait(ctx); // dependencies
+		wi::jobsystem::Wait(ctx);
+		wi::jobsystem::Wait(ctx_hierarchy);
+		wi::jobsystem::Wait(ctx_expression);
+		wi::jobsystem::Wait(ctx_mesh);
+		wi::jobsystem::Wait(ctx_material);
+		wi::jobsystem::Wait(ctx_armature);
+		wi::jobsystem::Wait(ctx_weather);
+		wi::jobsystem::Wait(ctx_object);
+		wi::jobsystem::Wait(ctx_object_bvh);
+		wi::jobsystem::Wait(ctx_camera);
+		wi::jobsystem::Wait(ctx_decal);
+		wi::jobsystem::Wait(ctx_probe);
+		wi::jobsystem::Wait(ctx_force);
+		wi::jobsystem::Wait(ctx_light);
+		wi::jobsystem::Wait(ctx_aabb_stream);
+		wi::jobsystem::Wait(ctx_particle);
+		wi::jobsystem::Wait(ctx_video);
+		wi::jobsystem::Wait(ctx_impostor);
 
 		// Merge parallel bounds computation (depends on object update system):
 		bounds = AABB();
@@ -823,11 +872,15 @@ namespace wi::scene
 	{
 		for(auto& entry : componentLibrary.entries)
 		{
+			// The entities are destroyed so that their indices can be reused, entities that are in multiple managers are only destroyed once:
+			const wi::vector<Entity>& entities = entry.second.component_manager->GetEntityArray();
+			wi::ecs::DestroyEntities(entities.data(), entities.size());
 			entry.second.component_manager->Clear();
 		}
 
 		TLAS = RaytracingAccelerationStructure();
 		BVH.Clear();
+		object_bvh.Clear();
 		waterRipples.clear();
 
 		surfelBuffer = {};
@@ -863,7 +916,7 @@ namespace wi::scene
 		}
 	}
 
-	void Scene::Entity_Remove(Entity entity, bool recursive)
+	void Scene::Entity_Remove(Entity entity, bool recursive, bool recycle)
 	{
 		if (recursive)
 		{
@@ -879,7 +932,7 @@ namespace wi::scene
 			}
 			for (auto& child : entities_to_remove)
 			{
-				Entity_Remove(child);
+				Entity_Remove(child, true, recycle);
 			}
 		}
 
@@ -887,6 +940,11 @@ namespace wi::scene
 		{
 			entry.second.component_manager->Remove(entity);
 		}
+
+		if (recycle)
+		{
+			wi::ecs::DestroyEntity(entity);
+		}
 	}
 	Entity Scene::Entity_FindByName(const std::string& name, Entity ancestor)
 	{
@@ -1442,6 +1500,12 @@ namespace wi::scene
 
 		wi::jobsystem::Wait(animation_dependency_scan_workload);
 
+		// The time ranges are only recomputed for the animation data that changed:
+		for (size_t i = 0; i < animation_datas.GetCount(); ++i)
+		{
+			animation_datas[i].RefreshTimeRange();
+		}
+
 		wi::jobsystem::Dispatch(ctx, (uint32_t)animation_queue_count, 1, [&](wi::jobsystem::JobArgs args) {
 
 			AnimationQueue& animation_queue = animation_queues[args.jobIndex];
@@ -1467,27 +1531,96 @@ namespace wi::scene
 					int keyLeft = 0;	float timeLeft = std::numeric_limits<float>::min();
 					int keyRight = 0;	float timeRight = std::numeric_limits<float>::max();
 
-					// search for usable keyframes:
-					for (int k = 0; k < (int)animationdata->keyframe_times.size(); ++k)
+					// The keyframes are sampled from these, compressed data is decoded into the local arrays:
+					const float* keyframe_times = animationdata->keyframe_times.data();
+					const float* keyframe_data = animationdata->keyframe_data.data();
+					size_t keyframe_count = animationdata->keyframe_times.size();
+					size_t keyframe_data_count = animationdata->keyframe_data.size();
+					float decoded_times[2];
+					float decoded_data[AnimationDataComponent::COMPRESSION_MAX_COMPONENTS * 2];
+
+					if (animationdata->IsCompressed())
 					{
-						const float time = animationdata->keyframe_times[k];
-						if (time < timeFirst)
+						if (path_data_type == AnimationComponent::AnimationChannel::PathDataType::Event || sampler.mode == AnimationComponent::AnimationSampler::Mode::CUBICSPLINE)
 						{
-							timeFirst = time;
+							assert(0); // Compress() doesn't support these
+							continue;
 						}
-						if (time > timeLast)
+						timeFirst = animationdata->time_first;
+						timeLast = animationdata->time_last;
+						const int decoded = animationdata->DecodeKeyframes(animation.timer, channel.keyframe_cursor, decoded_times, decoded_data);
+						if (decoded == 0)
 						{
-							timeLast = time;
+							// animation beginning haven't been reached, don't update animation:
+							continue;
 						}
-						if (time <= animation.timer && time > timeLeft)
+						keyframe_times = decoded_times;
+						keyframe_data = decoded_data;
+						keyframe_count = 2;
+						keyframe_data_count = animationdata->compressed_component_count * 2;
+						timeLeft = decoded_times[0];
+						timeRight = decoded_times[1];
+						keyRight = decoded == 2 ? 1 : 0;
+					}
+					else
+					{
+						bool found = false;
+						if (animationdata->keyframe_times_sorted)
 						{
-							timeLeft = time;
-							keyLeft = k;
+							// Precomputed range, and keyframe search starting from the previous keyframe of the channel:
+							//	The times can be modified in place after the range was refreshed, so the result is only used if it is consistent with the times
+							const wi::vector<float>& times = animationdata->keyframe_times;
+							const int count = (int)times.size();
+							if (count > 0 && times.front() == animationdata->time_first && times.back() == animationdata->time_last)
+							{
+								const int key = animationdata->FindKeyframe(animation.timer, channel.keyframe_cursor);
+								const int key_right = key >= 0 && times[key] == animation.timer ? key : key + 1;
+								// The found keyframes must bracket the timer, and their neighbours must be in order:
+								const bool left_valid = key < 0 ? times[0] > animation.timer : (times[key] <= animation.timer && (key == 0 || times[key - 1] < times[key]));
+								const bool right_valid = key_right >= count || key_right == key || (times[key_right] > animation.timer && (key_right + 1 == count || times[key_right] < times[key_right + 1]));
+								if (left_valid && right_valid)
+								{
+									timeFirst = animationdata->time_first;
+									timeLast = animationdata->time_last;
+									if (key >= 0)
+									{
+										keyLeft = key;
+										timeLeft = times[key];
+									}
+									if (key_right < count)
+									{
+										keyRight = key_right;
+										timeRight = times[key_right];
+									}
+									found = true;
+								}
+							}
 						}
-						if (time >= animation.timer && time < timeRight)
+						if (!found)
 						{
-							timeRight = time;
-							keyRight = k;
+							// search for usable keyframes:
+							for (int k = 0; k < (int)animationdata->keyframe_times.size(); ++k)
+							{
+								const float time = animationdata->keyframe_times[k];
+								if (time < timeFirst)
+								{
+									timeFirst = time;
+								}
+								if (time > timeLast)
+								{
+									timeLast = time;
+								}
+								if (time <= animation.timer && time > timeLeft)
+								{
+									timeLeft = time;
+									keyLeft = k;
+								}
+								if (time >= animation.timer && time < timeRight)
+								{
+									timeRight = time;
+									keyRight = k;
+								}
+							}
 						}
 					}
 					if (path_data_type != AnimationComponent::AnimationChannel::PathDataType::Event)
@@ -1504,8 +1637,8 @@ namespace wi::scene
 						timeRight = std::max(timeRight, timeLast);
 					}
 
-					const float left = animationdata->keyframe_times[keyLeft];
-					const float right = animationdata->keyframe_times[keyRight];
+					const float left = keyframe_times[keyLeft];
+					const float right = keyframe_times[keyRight];
 
 					union Interpolator
 					{
@@ -1557,6 +1690,11 @@ namespace wi::scene
 						if (target_mesh == nullptr)
 							continue;
 						animation.morph_weights_temp.resize(target_mesh->morph_targets.size());
+						if (animationdata->IsCompressed() && animation.morph_weights_temp.size() != animationdata->compressed_component_count)
+						{
+							assert(0); // compressed with different morph target count
+							continue;
+						}
 					}
 					else if (
 						channel.path >= AnimationComponent::AnimationChannel::Path::LIGHT_COLOR &&
@@ -1734,34 +1872,34 @@ namespace wi::scene
 							default:
 							case AnimationComponent::AnimationChannel::PathDataType::Float:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size());
-								interpolator.f = animationdata->keyframe_data[key];
+								assert(keyframe_data_count == keyframe_count);
+								interpolator.f = keyframe_data[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float2:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 2);
-								interpolator.f2 = ((const XMFLOAT2*)animationdata->keyframe_data.data())[key];
+								assert(keyframe_data_count == keyframe_count * 2);
+								interpolator.f2 = ((const XMFLOAT2*)keyframe_data)[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float3:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-								interpolator.f3 = ((const XMFLOAT3*)animationdata->keyframe_data.data())[key];
+								assert(keyframe_data_count == keyframe_count * 3);
+								interpolator.f3 = ((const XMFLOAT3*)keyframe_data)[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float4:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4);
-								interpolator.f4 = ((const XMFLOAT4*)animationdata->keyframe_data.data())[key];
+								assert(keyframe_data_count == keyframe_count * 4);
+								interpolator.f4 = ((const XMFLOAT4*)keyframe_data)[key];
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Weights:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size());
+								assert(keyframe_data_count == keyframe_count * animation.morph_weights_temp.size());
 								for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
 								{
-									animation.morph_weights_temp[j] = animationdata->keyframe_data[key * animation.morph_weights_temp.size() + j];
+									animation.morph_weights_temp[j] = keyframe_data[key * animation.morph_weights_temp.size() + j];
 								}
 							}
 							break;
@@ -1787,17 +1925,17 @@ namespace wi::scene
 							default:
 							case AnimationComponent::AnimationChannel::PathDataType::Float:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size());
-								float vLeft = animationdata->keyframe_data[keyLeft];
-								float vRight = animationdata->keyframe_data[keyRight];
+								assert(keyframe_data_count == keyframe_count);
+								float vLeft = keyframe_data[keyLeft];
+								float vRight = keyframe_data[keyRight];
 								float vAnim = wi::math::Lerp(vLeft, vRight, t);
 								interpolator.f = vAnim;
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float2:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 2);
-								const XMFLOAT2* data = (const XMFLOAT2*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_count * 2);
+								const XMFLOAT2* data = (const XMFLOAT2*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat2(&data[keyLeft]);
 								XMVECTOR vRight = XMLoadFloat2(&data[keyRight]);
 								XMVECTOR vAnim = XMVectorLerp(vLeft, vRight, t);
@@ -1806,8 +1944,8 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float3:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-								const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_count * 3);
+								const XMFLOAT3* data = (const XMFLOAT3*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft]);
 								XMVECTOR vRight = XMLoadFloat3(&data[keyRight]);
 								XMVECTOR vAnim = XMVectorLerp(vLeft, vRight, t);
@@ -1816,8 +1954,8 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float4:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4);
-								const XMFLOAT4* data = (const XMFLOAT4*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_count * 4);
+								const XMFLOAT4* data = (const XMFLOAT4*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat4(&data[keyLeft]);
 								XMVECTOR vRight = XMLoadFloat4(&data[keyRight]);
 								XMVECTOR vAnim;
@@ -1835,11 +1973,11 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Weights:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size());
+								assert(keyframe_data_count == keyframe_count * animation.morph_weights_temp.size());
 								for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
 								{
-									float vLeft = animationdata->keyframe_data[keyLeft * animation.morph_weights_temp.size() + j];
-									float vRight = animationdata->keyframe_data[keyRight * animation.morph_weights_temp.size() + j];
+									float vLeft = keyframe_data[keyLeft * animation.morph_weights_temp.size() + j];
+									float vRight = keyframe_data[keyRight * animation.morph_weights_temp.size() + j];
 									float vAnim = wi::math::Lerp(vLeft, vRight, t);
 									animation.morph_weights_temp[j] = vAnim;
 								}
@@ -1870,19 +2008,19 @@ namespace wi::scene
 							default:
 							case AnimationComponent::AnimationChannel::PathDataType::Float:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size());
-								float vLeft = animationdata->keyframe_data[keyLeft * 3 + 1];
-								float vLeftTanOut = animationdata->keyframe_data[keyLeft * 3 + 2];
-								float vRightTanIn = animationdata->keyframe_data[keyRight * 3 + 0];
-								float vRight = animationdata->keyframe_data[keyRight * 3 + 1];
+								assert(keyframe_data_count == keyframe_count);
+								float vLeft = keyframe_data[keyLeft * 3 + 1];
+								float vLeftTanOut = keyframe_data[keyLeft * 3 + 2];
+								float vRightTanIn = keyframe_data[keyRight * 3 + 0];
+								float vRight = keyframe_data[keyRight * 3 + 1];
 								float vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
 								interpolator.f = vAnim;
 							}
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float2:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 2 * 3);
-								const XMFLOAT2* data = (const XMFLOAT2*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_count * 2 * 3);
+								const XMFLOAT2* data = (const XMFLOAT2*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat2(&data[keyLeft * 3 + 1]);
 								XMVECTOR vLeftTanOut = dt * XMLoadFloat2(&data[keyLeft * 3 + 2]);
 								XMVECTOR vRightTanIn = dt * XMLoadFloat2(&data[keyRight * 3 + 0]);
@@ -1893,8 +2031,8 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float3:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3 * 3);
-								const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_count * 3 * 3);
+								const XMFLOAT3* data = (const XMFLOAT3*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft * 3 + 1]);
 								XMVECTOR vLeftTanOut = dt * XMLoadFloat3(&data[keyLeft * 3 + 2]);
 								XMVECTOR vRightTanIn = dt * XMLoadFloat3(&data[keyRight * 3 + 0]);
@@ -1905,8 +2043,8 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Float4:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4 * 3);
-								const XMFLOAT4* data = (const XMFLOAT4*)animationdata->keyframe_data.data();
+								assert(keyframe_data_count == keyframe_count * 4 * 3);
+								const XMFLOAT4* data = (const XMFLOAT4*)keyframe_data;
 								XMVECTOR vLeft = XMLoadFloat4(&data[keyLeft * 3 + 1]);
 								XMVECTOR vLeftTanOut = dt * XMLoadFloat4(&data[keyLeft * 3 + 2]);
 								XMVECTOR vRightTanIn = dt * XMLoadFloat4(&data[keyRight * 3 + 0]);
@@ -1921,13 +2059,13 @@ namespace wi::scene
 							break;
 							case AnimationComponent::AnimationChannel::PathDataType::Weights:
 							{
-								assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size() * 3);
+								assert(keyframe_data_count == keyframe_count * animation.morph_weights_temp.size() * 3);
 								for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
 								{
-									float vLeft = animationdata->keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 1];
-									float vLeftTanOut = animationdata->keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 2];
-									float vRightTanIn = animationdata->keyframe_data[(keyRight * animation.morph_weights_temp.size() + j) * 3 + 0];
-									float vRight = animationdata->keyframe_data[(keyRight * animation.morph_weights_temp.size() + j) * 3 + 1];
+									float vLeft = keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 1];
+									float vLeftTanOut = keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 2];
+									float vRightTanIn = keyframe_data[(keyRight * animation.morph_weights_temp.size() + j) * 3 + 0];
+									float vRight = keyframe_data[(keyRight * animation.morph_weights_temp.size() + j) * 3 + 1];
 									float vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
 									animation.morph_weights_temp[j] = vAnim;
 								}
@@ -2197,59 +2335,205 @@ namespace wi::scene
 	}
 	void Scene::RunHierarchyUpdateSystem(wi::jobsystem::context& ctx)
 	{
-		wi::jobsystem::Dispatch(ctx, (uint32_t)hierarchy.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
-
-			HierarchyComponent& hier = hierarchy[args.jobIndex];
-			Entity entity = hierarchy.GetEntity(args.jobIndex);
-
-			TransformComponent* transform_child = transforms.GetComponent(entity);
-			XMMATRIX worldmatrix;
-			if (transform_child != nullptr)
+		bool rebuild =
+			hierarchy_structure_versions[0] != hierarchy.GetStructureVersion() ||
+			hierarchy_structure_versions[1] != transforms.GetStructureVersion() ||
+			hierarchy_structure_versions[2] != layers.GetStructureVersion();
+		if (!rebuild)
+		{
+			// Reparenting doesn't change the component structure, so the cached parents are validated:
+			for (const HierarchyNode& node : hierarchy_nodes)
 			{
-				worldmatrix = transform_child->GetLocalMatrix();
+				if (node.hierarchy_index != ~0u && hierarchy[node.hierarchy_index].parentID != node.parentID)
+				{
+					rebuild = true;
+					break;
+				}
 			}
+		}
+		if (rebuild)
+		{
+			BuildHierarchyNodes();
+		}
 
-			LayerComponent* layer_child = layers.GetComponent(entity);
-			if (layer_child != nullptr)
+		auto update_node = [this, rebuild](uint32_t index) {
+			HierarchyNode& node = hierarchy_nodes[index];
+			const HierarchyNode* parent = node.parent == ~0u ? nullptr : &hierarchy_nodes[node.parent];
+			TransformComponent* transform = node.transform_index == ~0u ? nullptr : &transforms[node.transform_index];
+			LayerComponent* layer = node.layer_index == ~0u ? nullptr : &layers[node.layer_index];
+			const bool in_hierarchy = node.hierarchy_index != ~0u;
+
+			// Layers are cheap to propagate, so they are always refreshed:
+			const uint32_t parent_layerMask = parent == nullptr ? ~0u : parent->layerMask;
+			node.layerMask = parent_layerMask & (layer == nullptr ? ~0u : layer->layerMask);
+			if (layer != nullptr && in_hierarchy)
 			{
-				layer_child->propagationMask = ~0u; // clear propagation mask to full
+				layer->propagationMask = parent_layerMask;
 			}
 
-			if (transform_child == nullptr && layer_child == nullptr)
+			// The world matrix is only recomputed if the local transform of the node or one of its ancestors changed,
+			//	or if the world matrix was overwritten since the last update (for example by TransformComponent::UpdateTransform()):
+			bool dirty = rebuild || (parent != nullptr && parent->dirty);
+			if (!dirty && transform != nullptr)
+			{
+				dirty =
+					std::memcmp(&node.scale_local, &transform->scale_local, sizeof(node.scale_local)) != 0 ||
+					std::memcmp(&node.rotation_local, &transform->rotation_local, sizeof(node.rotation_local)) != 0 ||
+					std::memcmp(&node.translation_local, &transform->translation_local, sizeof(node.translation_local)) != 0 ||
+					(in_hierarchy && std::memcmp(&node.world, &transform->world, sizeof(node.world)) != 0);
+			}
+			node.dirty = dirty;
+			if (!dirty)
 				return;
 
-			Entity parentID = hier.parentID;
-			while (parentID != INVALID_ENTITY)
+			XMMATRIX W = transform == nullptr ? XMMatrixIdentity() : transform->GetLocalMatrix();
+			if (parent != nullptr)
 			{
-				TransformComponent* transform_parent = transforms.GetComponent(parentID);
-				if (transform_child != nullptr && transform_parent != nullptr)
-				{
-					worldmatrix *= transform_parent->GetLocalMatrix();
-				}
+				W = W * XMLoadFloat4x4(&parent->world);
+			}
+			XMStoreFloat4x4(&node.world, W);
 
-				LayerComponent* layer_parent = layers.GetComponent(parentID);
-				if (layer_child != nullptr && layer_parent != nullptr)
+			if (transform != nullptr)
+			{
+				node.scale_local = transform->scale_local;
+				node.rotation_local = transform->rotation_local;
+				node.translation_local = transform->translation_local;
+				if (in_hierarchy)
 				{
-					layer_child->propagationMask &= layer_parent->layerMask;
+					transform->world = node.world;
 				}
+			}
+		};
 
-				const HierarchyComponent* hier_recursive = hierarchy.GetComponent(parentID);
-				if (hier_recursive != nullptr)
-				{
-					parentID = hier_recursive->parentID;
-				}
-				else
+		// The levels are processed in order, the nodes within a level are independent of each other:
+		wi::jobsystem::context ctx_level;
+		ctx_level.priority = ctx.priority;
+		for (size_t level = 0; level + 1 < hierarchy_level_offsets.size(); ++level)
+		{
+			const uint32_t offset = hierarchy_level_offsets[level];
+			const uint32_t count = hierarchy_level_offsets[level + 1] - offset;
+			if (count < 256)
+			{
+				for (uint32_t i = 0; i < count; ++i)
 				{
-					parentID = INVALID_ENTITY;
+					update_node(offset + i);
 				}
 			}
+			else
+			{
+				wi::jobsystem::Dispatch(ctx_level, count, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+					update_node(offset + args.jobIndex);
+				});
+				wi::jobsystem::Wait(ctx_level);
+			}
+		}
+	}
+	void Scene::BuildHierarchyNodes()
+	{
+		hierarchy_structure_versions[0] = hierarchy.GetStructureVersion();
+		hierarchy_structure_versions[1] = transforms.GetStructureVersion();
+		hierarchy_structure_versions[2] = layers.GetStructureVersion();
+
+		// The first nodes correspond to the hierarchy components, parents without hierarchy are appended after them:
+		const uint32_t hierarchy_count = (uint32_t)hierarchy.GetCount();
+		wi::vector<HierarchyNode> nodes(hierarchy_count);
+		wi::unordered_map<Entity, uint32_t> root_lookup;
+		for (uint32_t i = 0; i < hierarchy_count; ++i)
+		{
+			nodes[i].entity = hierarchy.GetEntity(i);
+			nodes[i].parentID = hierarchy[i].parentID;
+			nodes[i].hierarchy_index = i;
+		}
+		for (uint32_t i = 0; i < hierarchy_count; ++i)
+		{
+			const Entity parentID = nodes[i].parentID;
+			if (parentID == INVALID_ENTITY)
+				continue;
+			const size_t parent_hierarchy_index = hierarchy.GetIndex(parentID);
+			if (parent_hierarchy_index != ~0ull)
+			{
+				nodes[i].parent = (uint32_t)parent_hierarchy_index;
+				continue;
+			}
+			auto it = root_lookup.find(parentID);
+			if (it == root_lookup.end())
+			{
+				const uint32_t root = (uint32_t)nodes.size();
+				root_lookup[parentID] = root;
+				HierarchyNode& node = nodes.emplace_back();
+				node.entity = parentID;
+				nodes[i].parent = root;
+			}
+			else
+			{
+				nodes[i].parent = it->second;
+			}
+		}
+
+		// Compute the depth of every node, each node is visited only once until a node with known depth is found:
+		const uint32_t node_count = (uint32_t)nodes.size();
+		wi::vector<uint32_t> depths(node_count, ~0u);
+		uint32_t max_depth = 0;
+		for (uint32_t i = 0; i < node_count; ++i)
+		{
+			uint32_t length = 0;
+			uint32_t n = i;
+			while (n != ~0u && depths[n] == ~0u && length <= node_count)
+			{
+				n = nodes[n].parent;
+				length++;
+			}
+			if (length > node_count)
+			{
+				// Cyclic parenting, the cycle is broken at this node:
+				nodes[i].parent = ~0u;
+				depths[i] = 0;
+				continue;
+			}
+			uint32_t depth = (n == ~0u ? 0 : depths[n] + 1) + length - 1;
+			max_depth = std::max(max_depth, depth);
+			n = i;
+			while (n != ~0u && depths[n] == ~0u)
+			{
+				depths[n] = depth--;
+				n = nodes[n].parent;
+			}
+		}
 
-			if (transform_child != nullptr)
+		// Counting sort by depth:
+		hierarchy_level_offsets.clear();
+		hierarchy_level_offsets.resize(node_count > 0 ? max_depth + 2 : 0);
+		for (uint32_t i = 0; i < node_count; ++i)
+		{
+			hierarchy_level_offsets[depths[i] + 1]++;
+		}
+		for (size_t level = 1; level < hierarchy_level_offsets.size(); ++level)
+		{
+			hierarchy_level_offsets[level] += hierarchy_level_offsets[level - 1];
+		}
+		wi::vector<uint32_t> remap(node_count);
+		{
+			wi::vector<uint32_t> cursor(hierarchy_level_offsets);
+			for (uint32_t i = 0; i < node_count; ++i)
 			{
-				XMStoreFloat4x4(&transform_child->world, worldmatrix);
+				remap[i] = cursor[depths[i]]++;
 			}
+		}
 
-		});
+		hierarchy_nodes.resize(node_count);
+		for (uint32_t i = 0; i < node_count; ++i)
+		{
+			HierarchyNode& node = hierarchy_nodes[remap[i]];
+			node = nodes[i];
+			if (node.parent != ~0u)
+			{
+				node.parent = remap[node.parent];
+			}
+			const size_t transform_index = transforms.GetIndex(node.entity);
+			const size_t layer_index = layers.GetIndex(node.entity);
+			node.transform_index = transform_index == ~0ull ? ~0u : (uint32_t)transform_index;
+			node.layer_index = layer_index == ~0ull ? ~0u : (uint32_t)layer_index;
+		}
 	}
 	void Scene::RunExpressionUpdateSystem(wi::jobsystem::context& ctx)
 	{
@@ -3213,6 +3497,7 @@ namespace wi::scene
 			}
 
 			armature.aabb = AABB(_min, _max);
+			armature.bone_data_version++;
 		});
 	}
 	void Scene::RunMeshUpdateSystem(wi::jobsystem::context& ctx)
@@ -3590,12 +3875,18 @@ namespace wi::scene
 		matrix_objects_prev.resize(objects.GetCount());
 		occlusion_results_objects.resize(objects.GetCount());
 
-		meshletAllocator.store(0u);
+		// The transform caches follow the object indices, so they are discarded when the objects are reordered:
+		if (transformcache_objects_version != objects.GetStructureVersion())
+		{
+			transformcache_objects_version = objects.GetStructureVersion();
+			transformcache_objects.clear();
+		}
+		transformcache_objects.resize(objects.GetCount());
 
 		parallel_bounds.clear();
-		parallel_bounds.resize((size_t)wi::jobsystem::DispatchGroupCount((uint32_t)objects.GetCount(), small_subtask_groupsize));
-		
-		wi::jobsystem::Dispatch(ctx, (uint32_t)objects.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+
+		// The object update cost varies a lot (lightmap creation, etc.), so the range is split adaptively:
+		wi::jobsystem::ParallelFor(ctx, (uint32_t)objects.GetCount(), [&](wi::jobsystem::JobArgs args) {
 
 			Entity entity = objects.GetEntity(args.jobIndex);
 			ObjectComponent& object = objects[args.jobIndex];
@@ -3648,8 +3939,26 @@ namespace wi::scene
 
 				const TransformComponent& transform = *transforms.GetComponent(entity);
 
+				// Static objects reuse the transformed bounds and instance matrices of the previous frame if nothing changed.
+				//	The world matrix is compared instead of relying on dirty flags, because it can be written by many systems (hierarchy, physics, user code):
+				ObjectTransformCache& transformcache = transformcache_objects[args.jobIndex];
+				const XMFLOAT4X4& worldMatrixPrev = matrix_objects[args.jobIndex];
+				const bool transform_unchanged =
+					transformcache.valid &&
+					std::memcmp(&transform.world, &worldMatrixPrev, sizeof(worldMatrixPrev)) == 0 &&
+					std::memcmp(&mesh.aabb, &transformcache.mesh_aabb, sizeof(mesh.aabb)) == 0;
+
 				XMMATRIX W = XMLoadFloat4x4(&transform.world);
-				aabb = mesh.aabb.transform(W);
+				if (transform_unchanged)
+				{
+					aabb = transformcache.aabb;
+				}
+				else
+				{
+					aabb = mesh.aabb.transform(W);
+					transformcache.mesh_aabb = mesh.aabb;
+					transformcache.aabb = aabb;
+				}
 
 				if (mesh.IsSkinned() || mesh.IsDynamic())
 				{
@@ -3771,16 +4080,31 @@ namespace wi::scene
 				inst.init();
 				XMFLOAT4X4& worldMatrix = matrix_objects[args.jobIndex];
 				matrix_objects_prev[args.jobIndex] = worldMatrix;
-				inst.transformPrev.Create(worldMatrix);
-				XMStoreFloat4x4(&worldMatrix, W);
-				inst.transform.Create(worldMatrix);
+				if (transform_unchanged)
+				{
+					// The world matrix is the same as in the previous frame:
+					inst.transformPrev = transformcache.transform;
+					inst.transform = transformcache.transform;
+					inst.transformInverseTranspose = transformcache.transformInverseTranspose;
+				}
+				else
+				{
+					inst.transformPrev.Create(worldMatrix);
+					XMStoreFloat4x4(&worldMatrix, W);
+					inst.transform.Create(worldMatrix);
+
+					// Correction matrix for mesh normals with non-uniform object scaling:
+					XMMATRIX worldMatrixInverseTranspose = XMMatrixTranspose(XMMatrixInverse(nullptr, W));
+					XMFLOAT4X4 transformIT;
+					XMStoreFloat4x4(&transformIT, worldMatrixInverseTranspose);
 
-				// Correction matrix for mesh normals with non-uniform object scaling:
-				XMMATRIX worldMatrixInverseTranspose = XMMatrixTranspose(XMMatrixInverse(nullptr, W));
-				XMFLOAT4X4 transformIT;
-				XMStoreFloat4x4(&transformIT, worldMatrixInverseTranspose);
+					inst.transformInverseTranspose.Create(transformIT);
 
-				inst.transformInverseTranspose.Create(transformIT);
+					transformcache.transform = inst.transform;
+					transformcache.transformInverseTranspose = inst.transformInverseTranspose;
+					transformcache.front_counterclockwise = XMVectorGetX(XMMatrixDeterminant(W)) > 0;
+					transformcache.valid = true;
+				}
 				if (object.lightmap.IsValid())
 				{
 					inst.lightmap = device->GetDescriptorIndex(&object.lightmap, SubresourceType::SRV);
@@ -3827,7 +4151,7 @@ namespace wi::scene
 						instance.flags |= RaytracingAccelerationStructureDesc::TopLevel::Instance::FLAG_TRIANGLE_CULL_DISABLE;
 					}
 
-					if (XMVectorGetX(XMMatrixDeterminant(W)) > 0)
+					if (transformcache.front_counterclockwise)
 					{
 						// There is a mismatch between object space winding and BLAS winding:
 						//	https://docs.microsoft.com/en-us/windows/win32/api/d3d12/ne-d3d12-d3d12_raytracing_instance_flags
@@ -3886,25 +4210,65 @@ namespace wi::scene
 				}
 
 				aabb.layerMask = layerMask;
+			}
 
-				// parallel bounds computation using shared memory:
-				AABB* shared_bounds = (AABB*)args.sharedmemory;
-				if (args.isFirstJobInGroup)
-				{
-					*shared_bounds = aabb_objects[args.jobIndex];
-				}
-				else
-				{
-					*shared_bounds = AABB::Merge(*shared_bounds, aabb_objects[args.jobIndex]);
-				}
-				if (args.isLastJobInGroup)
-				{
-					parallel_bounds[args.groupID] = *shared_bounds;
-				}
+			// parallel bounds computation using shared memory (objects without mesh have empty aabb):
+			AABB* shared_bounds = (AABB*)args.sharedmemory;
+			if (args.isFirstJobInGroup)
+			{
+				*shared_bounds = aabb;
+			}
+			else
+			{
+				*shared_bounds = AABB::Merge(*shared_bounds, aabb);
+			}
+			if (args.isLastJobInGroup)
+			{
+				// The number of groups is decided while executing:
+				locker.lock();
+				parallel_bounds.push_back(*shared_bounds);
+				locker.unlock();
 			}
 
 		}, sizeof(AABB));
 	}
+	void Scene::RunObjectBVHUpdateSystem(wi::jobsystem::context& ctx)
+	{
+		if (!IsObjectBVHEnabled() || aabb_objects.empty())
+		{
+			object_bvh.Clear();
+			return;
+		}
+
+		const uint32_t object_count = (uint32_t)aabb_objects.size();
+		if (object_bvh.IsValid() && object_bvh.leaf_count == object_count)
+		{
+			// Objects that moved only need a refit, the tree is only rebuilt if its quality degraded:
+			object_bvh.Refit(aabb_objects.data());
+			//	The cost is relative to the root area so it's at least 1, but it's 0 for a degenerate root (zero area), so the build cost is clamped to avoid rebuilding every frame
+			if (object_bvh.GetCost() < std::max(object_bvh_build_cost, 1.0f) * 1.5f)
+				return;
+		}
+
+		object_bvh.Build(aabb_objects.data(), object_count);
+		object_bvh_build_cost = object_bvh.GetCost();
+	}
+	void Scene::RunAABBStreamUpdateSystem(wi::jobsystem::context& ctx)
+	{
+		// The AABB4 blocks are filled from the AABB arrays after the object and light systems computed them:
+		const auto update_stream = [&ctx](const wi::vector<AABB>& aabbs, wi::vector<AABB4>& stream) {
+			const uint32_t count = (uint32_t)aabbs.size();
+			stream.resize((count + 3) / 4);
+			const AABB* data = aabbs.data();
+			AABB4* blocks = stream.data();
+			wi::jobsystem::Dispatch(ctx, (uint32_t)stream.size(), 256, [data, blocks, count](wi::jobsystem::JobArgs args) {
+				const uint32_t first = args.jobIndex * 4;
+				blocks[args.jobIndex] = AABB4(data + first, std::min(4u, count - first));
+			});
+		};
+		update_stream(aabb_objects, aabb_objects_soa);
+		update_stream(aabb_lights, aabb_lights_soa);
+	}
 	void Scene::RunCameraUpdateSystem(wi::jobsystem::context& ctx)
 	{
 		wi::jobsystem::Dispatch(ctx, (uint32_t)cameras.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
@@ -4538,6 +4902,231 @@ namespace wi::scene
 		}
 	}
 
+	// Linear broad phase of the object queries, the bounds of four objects are tested at once with aabb_objects_soa
+	//	callback(uint32_t objectIndex) is called for the objects whose bounds intersect the primitive and match the layer mask
+	template <typename T, typename F>
+	static void ForEachObjectIntersecting(const Scene& scene, const T& primitive, uint32_t layerMask, F&& callback)
+	{
+		const uint32_t object_count = (uint32_t)scene.aabb_objects.size();
+		if (scene.aabb_objects_soa.size() != (object_count + 3) / 4)
+		{
+			// The stream is not up to date before the first scene update, the callback tests the bounds anyway:
+			for (uint32_t objectIndex = 0; objectIndex < object_count; ++objectIndex)
+			{
+				callback(objectIndex);
+			}
+			return;
+		}
+		for (uint32_t blockIndex = 0; blockIndex < (uint32_t)scene.aabb_objects_soa.size(); ++blockIndex)
+		{
+			const AABB4& block = scene.aabb_objects_soa[blockIndex];
+			const uint32_t mask = block.intersects(primitive) & block.CheckLayerMask(layerMask);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				if (mask & (1u << lane))
+				{
+					callback(blockIndex * 4 + lane);
+				}
+			}
+		}
+	}
+
+	// Tests a ray against a collider, the closer hit is stored in the result:
+	static void RayIntersectCollider(const Scene& scene, uint32_t colliderIndex, const Ray& ray, const XMVECTOR& rayOrigin, const XMVECTOR& rayDirection, uint32_t layerMask, Scene::RayIntersectionResult& result)
+	{
+		if (!scene.aabb_colliders_cpu[colliderIndex].intersects(ray))
+			return;
+
+		const ColliderComponent& collider = scene.colliders_cpu[colliderIndex];
+
+		if ((collider.layerMask & layerMask) == 0)
+			return;
+
+		float dist = 0;
+		XMFLOAT3 direction = {};
+		bool intersects = false;
+
+		switch (collider.shape)
+		{
+		default:
+		case ColliderComponent::Shape::Sphere:
+			intersects = ray.intersects(collider.sphere, dist, direction);
+			break;
+		case ColliderComponent::Shape::Capsule:
+			intersects = ray.intersects(collider.capsule, dist, direction);
+			break;
+		case ColliderComponent::Shape::Plane:
+			intersects = ray.intersects(collider.plane, dist, direction);
+			break;
+		}
+
+		if (intersects)
+		{
+			if (dist < result.distance)
+			{
+				result.distance = dist;
+				result.bary = {};
+				result.entity = scene.colliders.GetEntity(colliderIndex);
+				result.normal = direction;
+				result.velocity = {};
+				XMStoreFloat3(&result.position, rayOrigin + rayDirection * dist);
+				result.subsetIndex = -1;
+				result.vertexID0 = 0;
+				result.vertexID1 = 0;
+				result.vertexID2 = 0;
+			}
+		}
+	}
+
+	// State of a ray query against one object instance, the ray is transformed into the local space of the instance:
+	struct RayInstanceQuery
+	{
+		Entity entity;
+		const MeshComponent* mesh;
+		const SoftBodyPhysicsComponent* softbody;
+		const ArmatureComponent* armature;
+		std::shared_ptr<const MeshComponent::TriangleBVH> triangle_bvh; // kept for the query, the mesh can invalidate it concurrently
+		const XMFLOAT3* skinned_positions;
+		XMMATRIX objectMat;
+		XMMATRIX objectMatPrev;
+		XMVECTOR rayOrigin;
+		XMVECTOR rayOrigin_local;
+		XMVECTOR rayDirection_local;
+		float TMin;
+		float TMax;
+		uint32_t first_subset;
+		uint32_t last_subset;
+
+		// Returns false if the object can be skipped by the query
+		bool Init(const Scene& scene, uint32_t objectIndex, const Ray& ray, const XMVECTOR& rayOrigin, const XMVECTOR& rayDirection, uint32_t filterMask, uint32_t layerMask, uint32_t lod)
+		{
+			const AABB& aabb = scene.aabb_objects[objectIndex];
+			if (!ray.intersects(aabb) || (layerMask & aabb.layerMask) == 0)
+				return false;
+
+			const ObjectComponent& object = scene.objects[objectIndex];
+			if (object.meshID == INVALID_ENTITY)
+				return false;
+			if ((filterMask & object.GetFilterMask()) == 0)
+				return false;
+
+			mesh = scene.meshes.GetComponent(object.meshID);
+			if (mesh == nullptr)
+				return false;
+
+			entity = scene.objects.GetEntity(objectIndex);
+			softbody = scene.softbodies.GetComponent(object.meshID);
+			objectMat = XMLoadFloat4x4(&scene.matrix_objects[objectIndex]);
+			objectMatPrev = XMLoadFloat4x4(&scene.matrix_objects_prev[objectIndex]);
+			const XMMATRIX objectMat_Inverse = XMMatrixInverse(nullptr, objectMat);
+			this->rayOrigin = rayOrigin;
+			rayOrigin_local = XMVector3Transform(rayOrigin, objectMat_Inverse);
+			rayDirection_local = XMVector3Normalize(XMVector3TransformNormal(rayDirection, objectMat_Inverse));
+			TMin = ray.TMin;
+			TMax = ray.TMax;
+			armature = mesh->IsSkinned() ? scene.armatures.GetComponent(mesh->armatureID) : nullptr;
+
+			mesh->GetLODSubsetRange(lod, first_subset, last_subset);
+
+			// Static meshes with a cached triangle BVH only test the triangles in the BVH leaves that overlap the query:
+			const bool softbody_active = softbody != nullptr && !softbody->vertex_positions_simulation.empty();
+			const bool skinned = armature != nullptr && !armature->boneData.empty();
+			triangle_bvh = softbody_active || skinned ? nullptr : mesh->GetTriangleBVH();
+			skinned_positions = !softbody_active && skinned ? mesh->GetSkinnedPositions(*armature) : nullptr;
+			return true;
+		}
+
+		// Tests a triangle of the instance, indexStart is the position of its first index in the mesh indices:
+		//	distance_local	: if not null, receives the local space hit distance when the result was updated
+		void IntersectTriangle(Scene::RayIntersectionResult& result, uint32_t subsetIndex, uint32_t indexStart, float* distance_local = nullptr) const
+		{
+			const uint32_t i0 = mesh->indices[indexStart + 0];
+			const uint32_t i1 = mesh->indices[indexStart + 1];
+			const uint32_t i2 = mesh->indices[indexStart + 2];
+
+			XMVECTOR p0;
+			XMVECTOR p1;
+			XMVECTOR p2;
+
+			const bool softbody_active = softbody != nullptr && !softbody->vertex_positions_simulation.empty();
+			if (softbody_active)
+			{
+				p0 = softbody->vertex_positions_simulation[i0].LoadPOS();
+				p1 = softbody->vertex_positions_simulation[i1].LoadPOS();
+				p2 = softbody->vertex_positions_simulation[i2].LoadPOS();
+			}
+			else
+			{
+				const XMFLOAT3* positions = skinned_positions == nullptr ? mesh->vertex_positions.data() : skinned_positions;
+				p0 = XMLoadFloat3(&positions[i0]);
+				p1 = XMLoadFloat3(&positions[i1]);
+				p2 = XMLoadFloat3(&positions[i2]);
+			}
+
+			float distance;
+			XMFLOAT2 bary;
+			if (wi::math::RayTriangleIntersects(rayOrigin_local, rayDirection_local, p0, p1, p2, distance, bary))
+			{
+				const XMVECTOR pos_local = XMVectorAdd(rayOrigin_local, rayDirection_local * distance);
+				const XMVECTOR pos = XMVector3Transform(pos_local, objectMat);
+				distance = wi::math::Distance(pos, rayOrigin);
+
+				// Note: we do the TMin, Tmax check here, in world space! We use the RayTriangleIntersects in local space, so we don't use those in there
+				if (distance < result.distance && distance >= TMin && distance <= TMax)
+				{
+					if (distance_local != nullptr)
+					{
+						*distance_local = XMVectorGetX(XMVector3Length(pos_local - rayOrigin_local));
+					}
+					const XMVECTOR nor = XMVector3Normalize(XMVector3TransformNormal(XMVector3Cross(XMVectorSubtract(p2, p1), XMVectorSubtract(p1, p0)), objectMat));
+					const XMVECTOR vel = pos - XMVector3Transform(pos_local, objectMatPrev);
+
+					result.entity = entity;
+					XMStoreFloat3(&result.position, pos);
+					XMStoreFloat3(&result.normal, nor);
+					XMStoreFloat3(&result.velocity, vel);
+					result.distance = distance;
+					result.subsetIndex = (int)subsetIndex;
+					result.vertexID0 = (int)i0;
+					result.vertexID1 = (int)i1;
+					result.vertexID2 = (int)i2;
+					result.bary = bary;
+				}
+			}
+		}
+
+		// Finds the closest hit with the triangle BVH, triangle_bvh must be valid:
+		void IntersectTriangleBVH(Scene::RayIntersectionResult& result) const
+		{
+			const Ray ray_local(rayOrigin_local, rayDirection_local);
+			float closest_local = std::numeric_limits<float>::max();
+			triangle_bvh->bvh.IntersectsClosest(ray_local, 0, closest_local, [&](uint32_t triangleIndex, float& closest) {
+				const uint32_t indexStart = triangleIndex * 3;
+				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				{
+					const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
+					if (indexStart >= subset.indexOffset && indexStart < subset.indexOffset + subset.indexCount)
+					{
+						IntersectTriangle(result, subsetIndex, indexStart, &closest);
+						break;
+					}
+				}
+			});
+		}
+	};
+
+	// Construct a matrix that will orient to position (P) according to surface normal (N):
+	static void ComputeRayIntersectionOrientation(const Ray& ray, Scene::RayIntersectionResult& result)
+	{
+		XMVECTOR N = XMLoadFloat3(&result.normal);
+		XMVECTOR P = XMLoadFloat3(&result.position);
+		XMVECTOR E = XMLoadFloat3(&ray.origin);
+		XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, P - E));
+		XMVECTOR B = XMVector3Normalize(XMVector3Cross(T, N));
+		XMMATRIX M = { T, N, B, P };
+		XMStoreFloat4x4(&result.orientation, M);
+	}
+
 	Scene::RayIntersectionResult Scene::Intersects(const Ray& ray, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
 	{
 		// Set up parallel closest hit selection:
@@ -4547,135 +5136,62 @@ namespace wi::scene
 		wi::jobsystem::context ctx;
 		struct JobDataForFunction
 		{
-			RayIntersectionResult* groupResults;
+			RayIntersectionResult result;
+			wi::SpinLock locker;
 			uint32_t layerMask;
 			Ray ray;
 			XMVECTOR rayOrigin;
 			XMVECTOR rayDirection;
-			float TMin;
-			float TMax;
 		} jobDataFunction;
-		const uint32_t threadCount = wi::jobsystem::GetThreadCount();
-		jobDataFunction.groupResults = (RayIntersectionResult*)allocator.allocate(AlignTo(sizeof(RayIntersectionResult) * threadCount, 16));
-		const size_t allocator_reserved_begin = allocator.offset;
-		for (uint32_t t = 0; t < threadCount; ++t)
-		{
-			jobDataFunction.groupResults[t] = RayIntersectionResult();
-		}
+		// The results of groups are reduced to the closest hit:
+		const auto closest_hit = [](RayIntersectionResult& result, const RayIntersectionResult& groupResult) {
+			if (groupResult.distance < result.distance)
+			{
+				result = groupResult;
+			}
+		};
 		jobDataFunction.layerMask = layerMask;
 		jobDataFunction.ray = ray;
 		jobDataFunction.rayOrigin = XMLoadFloat3(&ray.origin);
 		jobDataFunction.rayDirection = XMVector3Normalize(XMLoadFloat3(&ray.direction));
-		jobDataFunction.TMin = ray.TMin;
-		jobDataFunction.TMax = ray.TMax;
 
 		if (filterMask & FILTER_COLLIDER)
 		{
 			const uint32_t jobCount = collider_count_cpu;
-			const uint32_t groupSize = wi::jobsystem::DispatchGroupCount(jobCount, threadCount);
-			wi::jobsystem::Dispatch(ctx, jobCount, groupSize, [&jobDataFunction, this](wi::jobsystem::JobArgs args) {
+			wi::jobsystem::ParallelReduce(ctx, jobCount, jobDataFunction.result, jobDataFunction.locker, [&jobDataFunction, this](RayIntersectionResult& groupResult, uint32_t jobIndex) {
+				RayIntersectCollider(*this, jobIndex, jobDataFunction.ray, jobDataFunction.rayOrigin, jobDataFunction.rayDirection, jobDataFunction.layerMask, groupResult);
+				}, closest_hit);
+		}
 
-				if (!aabb_colliders_cpu[args.jobIndex].intersects(jobDataFunction.ray))
+		if (filterMask & FILTER_OBJECT_ALL)
+		{
+			const auto intersect_object = [&](uint32_t objectIndex) {
+				RayInstanceQuery instance;
+				if (!instance.Init(*this, objectIndex, ray, jobDataFunction.rayOrigin, jobDataFunction.rayDirection, filterMask, layerMask, lod))
 					return;
 
-				const ColliderComponent& collider = colliders_cpu[args.jobIndex];
-
-				if ((collider.layerMask & jobDataFunction.layerMask) == 0)
-					return;
-
-				float dist = 0;
-				XMFLOAT3 direction = {};
-				bool intersects = false;
-
-				switch (collider.shape)
-				{
-				default:
-				case ColliderComponent::Shape::Sphere:
-					intersects = jobDataFunction.ray.intersects(collider.sphere, dist, direction);
-					break;
-				case ColliderComponent::Shape::Capsule:
-					intersects = jobDataFunction.ray.intersects(collider.capsule, dist, direction);
-					break;
-				case ColliderComponent::Shape::Plane:
-					intersects = jobDataFunction.ray.intersects(collider.plane, dist, direction);
-					break;
-				}
-
-				if (intersects)
+				if (instance.triangle_bvh != nullptr)
 				{
-					RayIntersectionResult& groupResult = jobDataFunction.groupResults[args.groupID];
-					if (dist < groupResult.distance)
-					{
-						groupResult.distance = dist;
-						groupResult.bary = {};
-						groupResult.entity = colliders.GetEntity(args.jobIndex);
-						groupResult.normal = direction;
-						groupResult.velocity = {};
-						XMStoreFloat3(&groupResult.position, jobDataFunction.rayOrigin + jobDataFunction.rayDirection * dist);
-						groupResult.subsetIndex = -1;
-						groupResult.vertexID0 = 0;
-						groupResult.vertexID1 = 0;
-						groupResult.vertexID2 = 0;
-					}
+					RayIntersectionResult instanceResult;
+					instance.IntersectTriangleBVH(instanceResult);
+					jobDataFunction.locker.lock();
+					closest_hit(jobDataFunction.result, instanceResult);
+					jobDataFunction.locker.unlock();
+					return;
 				}
-				});
-		}
-
-		if (filterMask & FILTER_OBJECT_ALL)
-		{
-			for (size_t objectIndex = 0; objectIndex < aabb_objects.size(); ++objectIndex)
-			{
-				const AABB& aabb = aabb_objects[objectIndex];
-				if (!ray.intersects(aabb) || (layerMask & aabb.layerMask) == 0)
-					continue;
-
-				const ObjectComponent& object = objects[objectIndex];
-				if (object.meshID == INVALID_ENTITY)
-					continue;
-				if ((filterMask & object.GetFilterMask()) == 0)
-					continue;
 
-				const MeshComponent* mesh = meshes.GetComponent(object.meshID);
-				if (mesh == nullptr)
-					continue;
-
-				struct JobDataForInstance
-				{
-					JobDataForFunction* func;
-					Entity entity;
-					const MeshComponent* mesh;
-					const SoftBodyPhysicsComponent* softbody;
-					const ArmatureComponent* armature;
-					XMMATRIX objectMat;
-					XMMATRIX objectMatPrev;
-					XMVECTOR rayOrigin_local;
-					XMVECTOR rayDirection_local;
-				};
-
-				uint8_t* jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
+				uint8_t* jobdata_allocation = allocator.allocate(AlignTo(sizeof(RayInstanceQuery), 16));
 				if (jobdata_allocation == nullptr)
 				{
 					// Flush pending jobs, reset temp allocations, and reuse:
 					wi::jobsystem::Wait(ctx);
-					allocator.offset = allocator_reserved_begin;
-					jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
+					allocator.reset();
+					jobdata_allocation = allocator.allocate(AlignTo(sizeof(RayInstanceQuery), 16));
 				}
-				JobDataForInstance& jobData = *(JobDataForInstance*)jobdata_allocation;
-				jobData.func = &jobDataFunction;
-				jobData.mesh = mesh;
-				jobData.entity = objects.GetEntity(objectIndex);
-				jobData.softbody = softbodies.GetComponent(object.meshID);
-				jobData.objectMat = XMLoadFloat4x4(&matrix_objects[objectIndex]);
-				jobData.objectMatPrev = XMLoadFloat4x4(&matrix_objects_prev[objectIndex]);
-				const XMMATRIX objectMat_Inverse = XMMatrixInverse(nullptr, jobData.objectMat);
-				jobData.rayOrigin_local = XMVector3Transform(jobData.func->rayOrigin, objectMat_Inverse);
-				jobData.rayDirection_local = XMVector3Normalize(XMVector3TransformNormal(jobData.func->rayDirection, objectMat_Inverse));
-				jobData.armature = jobData.mesh->IsSkinned() ? armatures.GetComponent(jobData.mesh->armatureID) : nullptr;
+				// The allocator doesn't destroy the copy, but it holds no triangle BVH reference on this path:
+				RayInstanceQuery& jobData = *new (jobdata_allocation) RayInstanceQuery(instance);
 
-				uint32_t first_subset = 0;
-				uint32_t last_subset = 0;
-				jobData.mesh->GetLODSubsetRange(lod, first_subset, last_subset);
-				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				for (uint32_t subsetIndex = jobData.first_subset; subsetIndex < jobData.last_subset; ++subsetIndex)
 				{
 					const MeshComponent::MeshSubset& subset = jobData.mesh->subsets[subsetIndex];
 					if (subset.indexCount == 0)
@@ -4684,96 +5200,130 @@ namespace wi::scene
 
 					// Parallel closest hit selection:
 					const uint32_t jobCount = subset.indexCount / 3;
-					const uint32_t groupSize = wi::jobsystem::DispatchGroupCount(jobCount, threadCount);
-					wi::jobsystem::Dispatch(ctx, jobCount, groupSize, [&jobData, subsetIndex, indexOffset](wi::jobsystem::JobArgs args) {
+					wi::jobsystem::ParallelReduce(ctx, jobCount, jobDataFunction.result, jobDataFunction.locker, [&jobData, subsetIndex, indexOffset](RayIntersectionResult& groupResult, uint32_t jobIndex) {
+						jobData.IntersectTriangle(groupResult, subsetIndex, indexOffset + jobIndex * 3);
+						}, closest_hit);
+				}
+			};
 
-						RayIntersectionResult& groupResult = jobData.func->groupResults[args.groupID];
+			if (IsObjectBVHValid())
+			{
+				// Only the objects in the BVH leaves that overlap the query are checked:
+				object_bvh.Intersects(ray, 0, intersect_object);
+			}
+			else
+			{
+				ForEachObjectIntersecting(*this, ray, layerMask, intersect_object);
+			}
+		}
 
-						const uint32_t i0 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 0];
-						const uint32_t i1 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 1];
-						const uint32_t i2 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 2];
+		// Wait for the reduction of group results:
+		wi::jobsystem::Wait(ctx);
+		RayIntersectionResult& result = jobDataFunction.result;
 
-						XMVECTOR p0;
-						XMVECTOR p1;
-						XMVECTOR p2;
+		ComputeRayIntersectionOrientation(ray, result);
 
-						const bool softbody_active = jobData.softbody != nullptr && !jobData.softbody->vertex_positions_simulation.empty();
-						if (softbody_active)
-						{
-							p0 = jobData.softbody->vertex_positions_simulation[i0].LoadPOS();
-							p1 = jobData.softbody->vertex_positions_simulation[i1].LoadPOS();
-							p2 = jobData.softbody->vertex_positions_simulation[i2].LoadPOS();
-						}
-						else
-						{
-							if (jobData.armature == nullptr || jobData.armature->boneData.empty())
-							{
-								p0 = XMLoadFloat3(&jobData.mesh->vertex_positions[i0]);
-								p1 = XMLoadFloat3(&jobData.mesh->vertex_positions[i1]);
-								p2 = XMLoadFloat3(&jobData.mesh->vertex_positions[i2]);
-							}
-							else
-							{
-								p0 = SkinVertex(*jobData.mesh, *jobData.armature, i0);
-								p1 = SkinVertex(*jobData.mesh, *jobData.armature, i1);
-								p2 = SkinVertex(*jobData.mesh, *jobData.armature, i2);
-							}
-						}
+		return result;
+	}
+	void Scene::Intersects(const RayQuery* queries, uint32_t count, RayIntersectionResult* results) const
+	{
+		if (count == 0)
+			return;
 
-						float distance;
-						XMFLOAT2 bary;
-						if (wi::math::RayTriangleIntersects(jobData.rayOrigin_local, jobData.rayDirection_local, p0, p1, p2, distance, bary))
-						{
-							const XMVECTOR pos_local = XMVectorAdd(jobData.rayOrigin_local, jobData.rayDirection_local * distance);
-							const XMVECTOR pos = XMVector3Transform(pos_local, jobData.objectMat);
-							distance = wi::math::Distance(pos, jobData.func->rayOrigin);
+		// The rays are sorted by direction octant and then along a Morton curve of their origins,
+		//	so that neighbouring jobs traverse similar parts of the scene:
+		XMVECTOR origin_min = XMLoadFloat3(&queries[0].ray.origin);
+		XMVECTOR origin_max = origin_min;
+		for (uint32_t i = 1; i < count; ++i)
+		{
+			const XMVECTOR origin = XMLoadFloat3(&queries[i].ray.origin);
+			origin_min = XMVectorMin(origin_min, origin);
+			origin_max = XMVectorMax(origin_max, origin);
+		}
+		const XMVECTOR origin_scale = XMVectorReciprocal(XMVectorMax(origin_max - origin_min, XMVectorReplicate(0.0001f))) * 511.0f;
+		const auto expand_bits = [](uint32_t v) {
+			v = (v * 0x00010001u) & 0xFF0000FFu;
+			v = (v * 0x00000101u) & 0x0F00F00Fu;
+			v = (v * 0x00000011u) & 0xC30C30C3u;
+			v = (v * 0x00000005u) & 0x49249249u;
+			return v;
+		};
+		wi::vector<uint64_t> order(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Ray& ray = queries[i].ray;
+			XMFLOAT3 cell;
+			XMStoreFloat3(&cell, (XMLoadFloat3(&ray.origin) - origin_min) * origin_scale);
+			const uint32_t morton = (expand_bits((uint32_t)cell.x) << 2) | (expand_bits((uint32_t)cell.y) << 1) | expand_bits((uint32_t)cell.z);
+			const uint32_t octant = (ray.direction.x < 0 ? 1 : 0) | (ray.direction.y < 0 ? 2 : 0) | (ray.direction.z < 0 ? 4 : 0);
+			order[i] = (uint64_t(octant << 27 | morton) << 32) | i;
+		}
+		std::sort(order.begin(), order.end());
 
-							// Note: we do the TMin, Tmax check here, in world space! We use the RayTriangleIntersects in local space, so we don't use those in there
-							if (distance < groupResult.distance && distance >= jobData.func->TMin && distance <= jobData.func->TMax)
-							{
-								const XMVECTOR nor = XMVector3Normalize(XMVector3TransformNormal(XMVector3Cross(XMVectorSubtract(p2, p1), XMVectorSubtract(p1, p0)), jobData.objectMat));
-								const XMVECTOR vel = pos - XMVector3Transform(pos_local, jobData.objectMatPrev);
-
-								groupResult.entity = jobData.entity;
-								XMStoreFloat3(&groupResult.position, pos);
-								XMStoreFloat3(&groupResult.normal, nor);
-								XMStoreFloat3(&groupResult.velocity, vel);
-								groupResult.distance = distance;
-								groupResult.subsetIndex = (int)subsetIndex;
-								groupResult.vertexID0 = (int)i0;
-								groupResult.vertexID1 = (int)i1;
-								groupResult.vertexID2 = (int)i2;
-								groupResult.bary = bary;
-							}
-						}
-						});
+		// Every ray is traced on a single thread, the parallelism comes from the number of rays:
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, count, 16, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t queryIndex = uint32_t(order[args.jobIndex] & 0xFFFFFFFF);
+			const RayQuery& query = queries[queryIndex];
+			const Ray& ray = query.ray;
+			const XMVECTOR rayOrigin = XMLoadFloat3(&ray.origin);
+			const XMVECTOR rayDirection = XMVector3Normalize(XMLoadFloat3(&ray.direction));
+			RayIntersectionResult result;
+
+			if (query.filterMask & FILTER_COLLIDER)
+			{
+				for (uint32_t colliderIndex = 0; colliderIndex < collider_count_cpu; ++colliderIndex)
+				{
+					RayIntersectCollider(*this, colliderIndex, ray, rayOrigin, rayDirection, query.layerMask, result);
 				}
-
 			}
-		}
 
-		// Merge thread results:
-		wi::jobsystem::Wait(ctx);
-		RayIntersectionResult& result = jobDataFunction.groupResults[0];
-		for (uint32_t t = 1; t < threadCount; ++t)
-		{
-			if (jobDataFunction.groupResults[t].distance < result.distance)
+			if (query.filterMask & FILTER_OBJECT_ALL)
 			{
-				result = jobDataFunction.groupResults[t];
-			}
-		}
+				const auto intersect_object = [&](uint32_t objectIndex) {
+					RayInstanceQuery instance;
+					if (!instance.Init(*this, objectIndex, ray, rayOrigin, rayDirection, query.filterMask, query.layerMask, query.lod))
+						return;
 
-		// Construct a matrix that will orient to position (P) according to surface normal (N):
-		XMVECTOR N = XMLoadFloat3(&result.normal);
-		XMVECTOR P = XMLoadFloat3(&result.position);
-		XMVECTOR E = XMLoadFloat3(&ray.origin);
-		XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, P - E));
-		XMVECTOR B = XMVector3Normalize(XMVector3Cross(T, N));
-		XMMATRIX M = { T, N, B, P };
-		XMStoreFloat4x4(&result.orientation, M);
+					if (instance.triangle_bvh != nullptr)
+					{
+						instance.IntersectTriangleBVH(result);
+						return;
+					}
 
-		return result;
+					for (uint32_t subsetIndex = instance.first_subset; subsetIndex < instance.last_subset; ++subsetIndex)
+					{
+						const MeshComponent::MeshSubset& subset = instance.mesh->subsets[subsetIndex];
+						for (uint32_t indexStart = subset.indexOffset; indexStart + 2 < subset.indexOffset + subset.indexCount; indexStart += 3)
+						{
+							instance.IntersectTriangle(result, subsetIndex, indexStart);
+						}
+					}
+				};
+
+				if (IsObjectBVHValid())
+				{
+					// Objects are visited front to back, and the ones behind the closest hit are skipped:
+					//	The traversal uses a normalized direction, so that it measures the same distance as the results
+					const Ray ray_normalized(rayOrigin, rayDirection);
+					float closest_object = std::numeric_limits<float>::max();
+					object_bvh.IntersectsClosest(ray_normalized, 0, closest_object, [&](uint32_t objectIndex, float& closest) {
+						intersect_object(objectIndex);
+						closest = result.distance;
+					});
+				}
+				else
+				{
+					ForEachObjectIntersecting(*this, ray, query.layerMask, intersect_object);
+				}
+			}
+
+			ComputeRayIntersectionOrientation(ray, result);
+			results[queryIndex] = result;
+		});
+		wi::jobsystem::Wait(ctx);
 	}
+
 	Scene::SphereIntersectionResult Scene::Intersects(const Sphere& sphere, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
 	{
 		// Set up parallel closest hit selection:
@@ -4783,20 +5333,21 @@ namespace wi::scene
 		wi::jobsystem::context ctx;
 		struct JobDataForFunction
 		{
-			SphereIntersectionResult* groupResults;
+			SphereIntersectionResult result;
+			wi::SpinLock locker;
 			uint32_t layerMask;
 			Sphere sphere;
 			XMVECTOR Center;
 			XMVECTOR Radius;
 			XMVECTOR RadiusSq;
 		} jobDataFunction;
-		const uint32_t threadCount = wi::jobsystem::GetThreadCount();
-		jobDataFunction.groupResults = (SphereIntersectionResult*)allocator.allocate(AlignTo(sizeof(SphereIntersectionResult) * threadCount, 16));
-		const size_t allocator_reserved_begin = allocator.offset;
-		for (uint32_t t = 0; t < threadCount; ++t)
-		{
-			jobDataFunction.groupResults[t] = SphereIntersectionResult();
-		}
+		// The results of groups are reduced to the deepest intersection:
+		const auto deepest_hit = [](SphereIntersectionResult& result, const SphereIntersectionResult& groupResult) {
+			if (groupResult.depth > result.depth)
+			{
+				result = groupResult;
+			}
+		};
 		jobDataFunction.layerMask = layerMask;
 		jobDataFunction.sphere = sphere;
 		jobDataFunction.Center = XMLoadFloat3(&sphere.center);
@@ -4806,13 +5357,12 @@ namespace wi::scene
 		if (filterMask & FILTER_COLLIDER)
 		{
 			const uint32_t jobCount = collider_count_cpu;
-			const uint32_t groupSize = wi::jobsystem::DispatchGroupCount(jobCount, threadCount);
-			wi::jobsystem::Dispatch(ctx, jobCount, groupSize, [&jobDataFunction, this](wi::jobsystem::JobArgs args) {
+			wi::jobsystem::ParallelReduce(ctx, jobCount, jobDataFunction.result, jobDataFunction.locker, [&jobDataFunction, this](SphereIntersectionResult& groupResult, uint32_t jobIndex) {
 
-				if (!aabb_colliders_cpu[args.jobIndex].intersects(jobDataFunction.sphere))
+				if (!aabb_colliders_cpu[jobIndex].intersects(jobDataFunction.sphere))
 					return;
 
-				const ColliderComponent& collider = colliders_cpu[args.jobIndex];
+				const ColliderComponent& collider = colliders_cpu[jobIndex];
 
 				if ((collider.layerMask & jobDataFunction.layerMask) == 0)
 					return;
@@ -4839,54 +5389,198 @@ namespace wi::scene
 
 				if (intersects)
 				{
-					CapsuleIntersectionResult& groupResult = jobDataFunction.groupResults[args.groupID];
 					if (dist > groupResult.depth)
 					{
 						groupResult.depth = dist;
-						groupResult.entity = colliders.GetEntity(args.jobIndex);
+						groupResult.entity = colliders.GetEntity(jobIndex);
 						groupResult.normal = direction;
 						groupResult.position = position;
 						groupResult.velocity = {};
 					}
 				}
-			});
+			}, deepest_hit);
 		}
 
-		if (filterMask & FILTER_OBJECT_ALL)
+		struct JobDataForInstance
 		{
-			for (size_t objectIndex = 0; objectIndex < aabb_objects.size(); ++objectIndex)
+			JobDataForFunction* func;
+			Entity entity;
+			const MeshComponent* mesh;
+			const SoftBodyPhysicsComponent* softbody;
+			const ArmatureComponent* armature;
+			const XMFLOAT3* skinned_positions;
+			XMMATRIX objectMat;
+			XMMATRIX objectMatPrev;
+		};
+
+		// Tests a triangle of an instance, indexStart is the position of its first index in the mesh indices:
+		const auto intersect_triangle = [](const JobDataForInstance& jobData, SphereIntersectionResult& groupResult, uint32_t subsetIndex, uint32_t indexStart) {
+
+			const uint32_t i0 = jobData.mesh->indices[indexStart + 0];
+			const uint32_t i1 = jobData.mesh->indices[indexStart + 1];
+			const uint32_t i2 = jobData.mesh->indices[indexStart + 2];
+
+			XMVECTOR p0;
+			XMVECTOR p1;
+			XMVECTOR p2;
+
+			const bool softbody_active = jobData.softbody != nullptr && !jobData.softbody->vertex_positions_simulation.empty();
+			if (softbody_active)
+			{
+				p0 = jobData.softbody->vertex_positions_simulation[i0].LoadPOS();
+				p1 = jobData.softbody->vertex_positions_simulation[i1].LoadPOS();
+				p2 = jobData.softbody->vertex_positions_simulation[i2].LoadPOS();
+			}
+			else
+			{
+				const XMFLOAT3* positions = jobData.skinned_positions == nullptr ? jobData.mesh->vertex_positions.data() : jobData.skinned_positions;
+				p0 = XMLoadFloat3(&positions[i0]);
+				p1 = XMLoadFloat3(&positions[i1]);
+				p2 = XMLoadFloat3(&positions[i2]);
+			}
+
+			p0 = XMVector3Transform(p0, jobData.objectMat);
+			p1 = XMVector3Transform(p1, jobData.objectMat);
+			p2 = XMVector3Transform(p2, jobData.objectMat);
+
+			XMFLOAT3 min, max;
+			XMStoreFloat3(&min, XMVectorMin(p0, XMVectorMin(p1, p2)));
+			XMStoreFloat3(&max, XMVectorMax(p0, XMVectorMax(p1, p2)));
+			AABB aabb_triangle(min, max);
+			if (jobData.func->sphere.intersects(aabb_triangle) == AABB::OUTSIDE)
+				return;
+
+			// Compute the plane of the triangle (has to be normalized).
+			XMVECTOR N = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+
+			// Assert that the triangle is not degenerate.
+			assert(!XMVector3Equal(N, XMVectorZero()));
+
+			// Find the nearest feature on the triangle to the sphere.
+			XMVECTOR Dist = XMVector3Dot(XMVectorSubtract(jobData.func->Center, p0), N);
+
+			if (!jobData.mesh->IsDoubleSided() && XMVectorGetX(Dist) > 0)
+				return; // pass through back faces
+
+			// If the center of the sphere is farther from the plane of the triangle than
+			// the radius of the sphere, then there cannot be an intersection.
+			XMVECTOR NoIntersection = XMVectorLess(Dist, XMVectorNegate(jobData.func->Radius));
+			NoIntersection = XMVectorOrInt(NoIntersection, XMVectorGreater(Dist, jobData.func->Radius));
+
+			// Project the center of the sphere onto the plane of the triangle.
+			XMVECTOR Point0 = XMVectorNegativeMultiplySubtract(N, Dist, jobData.func->Center);
+
+			// Is it inside all the edges? If so we intersect because the distance 
+			// to the plane is less than the radius.
+			//XMVECTOR Intersection = DirectX::Internal::PointOnPlaneInsideTriangle(Point0, p0, p1, p2);
+
+			// Compute the cross products of the vector from the base of each edge to 
+			// the point with each edge vector.
+			XMVECTOR C0 = XMVector3Cross(XMVectorSubtract(Point0, p0), XMVectorSubtract(p1, p0));
+			XMVECTOR C1 = XMVector3Cross(XMVectorSubtract(Point0, p1), XMVectorSubtract(p2, p1));
+			XMVECTOR C2 = XMVector3Cross(XMVectorSubtract(Point0, p2), XMVectorSubtract(p0, p2));
+
+			// If the cross product points in the same direction as the normal the the
+			// point is inside the edge (it is zero if is on the edge).
+			XMVECTOR Zero = XMVectorZero();
+			XMVECTOR Inside0 = XMVectorLessOrEqual(XMVector3Dot(C0, N), Zero);
+			XMVECTOR Inside1 = XMVectorLessOrEqual(XMVector3Dot(C1, N), Zero);
+			XMVECTOR Inside2 = XMVectorLessOrEqual(XMVector3Dot(C2, N), Zero);
+
+			// If the point inside all of the edges it is inside.
+			XMVECTOR Intersection = XMVectorAndInt(XMVectorAndInt(Inside0, Inside1), Inside2);
+
+			bool inside = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
+
+			// Find the nearest point on each edge.
+
+			// Edge 0,1
+			XMVECTOR Point1 = DirectX::Internal::PointOnLineSegmentNearestPoint(p0, p1, jobData.func->Center);
+
+			// If the distance to the center of the sphere to the point is less than 
+			// the radius of the sphere then it must intersect.
+			Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(jobData.func->Center, Point1)), jobData.func->RadiusSq));
+
+			// Edge 1,2
+			XMVECTOR Point2 = DirectX::Internal::PointOnLineSegmentNearestPoint(p1, p2, jobData.func->Center);
+
+			// If the distance to the center of the sphere to the point is less than 
+			// the radius of the sphere then it must intersect.
+			Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(jobData.func->Center, Point2)), jobData.func->RadiusSq));
+
+			// Edge 2,0
+			XMVECTOR Point3 = DirectX::Internal::PointOnLineSegmentNearestPoint(p2, p0, jobData.func->Center);
+
+			// If the distance to the center of the sphere to the point is less than 
+			// the radius of the sphere then it must intersect.
+			Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(jobData.func->Center, Point3)), jobData.func->RadiusSq));
+
+			bool intersects = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
+
+			if (intersects)
 			{
+				XMVECTOR bestPoint = Point0;
+				if (!inside)
+				{
+					// If the sphere center's projection on the triangle plane is not within the triangle,
+					//	determine the closest point on triangle to the sphere center
+					float bestDist = XMVectorGetX(XMVector3LengthSq(Point1 - jobData.func->Center));
+					bestPoint = Point1;
+
+					float d = XMVectorGetX(XMVector3LengthSq(Point2 - jobData.func->Center));
+					if (d < bestDist)
+					{
+						bestDist = d;
+						bestPoint = Point2;
+					}
+					d = XMVectorGetX(XMVector3LengthSq(Point3 - jobData.func->Center));
+					if (d < bestDist)
+					{
+						bestDist = d;
+						bestPoint = Point3;
+					}
+				}
+				XMVECTOR intersectionVec = jobData.func->Center - bestPoint;
+				XMVECTOR intersectionVecLen = XMVector3Length(intersectionVec);
+
+				float depth = jobData.func->sphere.radius - XMVectorGetX(intersectionVecLen);
+				if (depth > groupResult.depth)
+				{
+					groupResult.entity = jobData.entity;
+					groupResult.depth = depth;
+					XMStoreFloat3(&groupResult.position, bestPoint);
+					XMStoreFloat3(&groupResult.normal, intersectionVec / intersectionVecLen);
+
+					XMMATRIX objectMatInverse = XMMatrixInverse(nullptr, jobData.objectMat);
+					XMVECTOR vel = bestPoint - XMVector3Transform(XMVector3Transform(bestPoint, objectMatInverse), jobData.objectMatPrev);
+					XMStoreFloat3(&groupResult.velocity, vel);
+				}
+			}
+		};
+
+		if (filterMask & FILTER_OBJECT_ALL)
+		{
+			const auto intersect_object = [&](uint32_t objectIndex) {
 				const AABB& aabb = aabb_objects[objectIndex];
 				if (!sphere.intersects(aabb) || (layerMask & aabb.layerMask) == 0)
-					continue;
+					return;
 
 				const ObjectComponent& object = objects[objectIndex];
 				if (object.meshID == INVALID_ENTITY)
-					continue;
+					return;
 				if ((filterMask & object.GetFilterMask()) == 0)
-					continue;
+					return;
 
 				const MeshComponent* mesh = meshes.GetComponent(object.meshID);
 				if (mesh == nullptr)
-					continue;
-
-				struct JobDataForInstance
-				{
-					JobDataForFunction* func;
-					Entity entity;
-					const MeshComponent* mesh;
-					const SoftBodyPhysicsComponent* softbody;
-					const ArmatureComponent* armature;
-					XMMATRIX objectMat;
-					XMMATRIX objectMatPrev;
-				};
+					return;
 
 				uint8_t* jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
 				if (jobdata_allocation == nullptr)
 				{
 					// Flush pending jobs, reset temp allocations, and reuse:
 					wi::jobsystem::Wait(ctx);
-					allocator.offset = allocator_reserved_begin;
+					allocator.reset();
 					jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
 				}
 				JobDataForInstance& jobData = *(JobDataForInstance*)jobdata_allocation;
@@ -4901,6 +5595,36 @@ namespace wi::scene
 				uint32_t first_subset = 0;
 				uint32_t last_subset = 0;
 				jobData.mesh->GetLODSubsetRange(lod, first_subset, last_subset);
+
+				// Static meshes with a cached triangle BVH only test the triangles in the BVH leaves that overlap the query:
+				const bool softbody_active = jobData.softbody != nullptr && !jobData.softbody->vertex_positions_simulation.empty();
+				const bool skinned = jobData.armature != nullptr && !jobData.armature->boneData.empty();
+				const std::shared_ptr<const MeshComponent::TriangleBVH> triangle_bvh = softbody_active || skinned ? nullptr : jobData.mesh->GetTriangleBVH();
+				jobData.skinned_positions = !softbody_active && skinned ? jobData.mesh->GetSkinnedPositions(*jobData.armature) : nullptr;
+				if (triangle_bvh != nullptr)
+				{
+					AABB sphere_aabb;
+					sphere_aabb.createFromHalfWidth(sphere.center, XMFLOAT3(sphere.radius, sphere.radius, sphere.radius));
+					const AABB aabb_local = sphere_aabb.transform(XMMatrixInverse(nullptr, jobData.objectMat));
+					SphereIntersectionResult instanceResult;
+					triangle_bvh->bvh.Intersects(aabb_local, 0, [&](uint32_t triangleIndex) {
+						const uint32_t indexStart = triangleIndex * 3;
+						for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+						{
+							const MeshComponent::MeshSubset& subset = jobData.mesh->subsets[subsetIndex];
+							if (indexStart >= subset.indexOffset && indexStart < subset.indexOffset + subset.indexCount)
+							{
+								intersect_triangle(jobData, instanceResult, subsetIndex, indexStart);
+								break;
+							}
+						}
+					});
+					jobDataFunction.locker.lock();
+					deepest_hit(jobDataFunction.result, instanceResult);
+					jobDataFunction.locker.unlock();
+					return;
+				}
+
 				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
 				{
 					const MeshComponent::MeshSubset& subset = jobData.mesh->subsets[subsetIndex];
@@ -4910,176 +5634,27 @@ namespace wi::scene
 
 					// Parallel closest hit selection:
 					const uint32_t jobCount = subset.indexCount / 3;
-					const uint32_t groupSize = wi::jobsystem::DispatchGroupCount(jobCount, threadCount);
-					wi::jobsystem::Dispatch(ctx, jobCount, groupSize, [&jobData, subsetIndex, indexOffset](wi::jobsystem::JobArgs args) {
-
-						SceneIntersectSphereResult& groupResult = jobData.func->groupResults[args.groupID];
-
-						const uint32_t i0 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 0];
-						const uint32_t i1 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 1];
-						const uint32_t i2 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 2];
-
-						XMVECTOR p0;
-						XMVECTOR p1;
-						XMVECTOR p2;
-
-						const bool softbody_active = jobData.softbody != nullptr && !jobData.softbody->vertex_positions_simulation.empty();
-						if (softbody_active)
-						{
-							p0 = jobData.softbody->vertex_positions_simulation[i0].LoadPOS();
-							p1 = jobData.softbody->vertex_positions_simulation[i1].LoadPOS();
-							p2 = jobData.softbody->vertex_positions_simulation[i2].LoadPOS();
-						}
-						else
-						{
-							if (jobData.armature == nullptr || jobData.armature->boneData.empty())
-							{
-								p0 = XMLoadFloat3(&jobData.mesh->vertex_positions[i0]);
-								p1 = XMLoadFloat3(&jobData.mesh->vertex_positions[i1]);
-								p2 = XMLoadFloat3(&jobData.mesh->vertex_positions[i2]);
-							}
-							else
-							{
-								p0 = SkinVertex(*jobData.mesh, *jobData.armature, i0);
-								p1 = SkinVertex(*jobData.mesh, *jobData.armature, i1);
-								p2 = SkinVertex(*jobData.mesh, *jobData.armature, i2);
-							}
-						}
-
-						p0 = XMVector3Transform(p0, jobData.objectMat);
-						p1 = XMVector3Transform(p1, jobData.objectMat);
-						p2 = XMVector3Transform(p2, jobData.objectMat);
-
-						XMFLOAT3 min, max;
-						XMStoreFloat3(&min, XMVectorMin(p0, XMVectorMin(p1, p2)));
-						XMStoreFloat3(&max, XMVectorMax(p0, XMVectorMax(p1, p2)));
-						AABB aabb_triangle(min, max);
-						if (jobData.func->sphere.intersects(aabb_triangle) == AABB::OUTSIDE)
-							return;
-
-						// Compute the plane of the triangle (has to be normalized).
-						XMVECTOR N = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
-
-						// Assert that the triangle is not degenerate.
-						assert(!XMVector3Equal(N, XMVectorZero()));
-
-						// Find the nearest feature on the triangle to the sphere.
-						XMVECTOR Dist = XMVector3Dot(XMVectorSubtract(jobData.func->Center, p0), N);
-
-						if (!jobData.mesh->IsDoubleSided() && XMVectorGetX(Dist) > 0)
-							return; // pass through back faces
-
-						// If the center of the sphere is farther from the plane of the triangle than
-						// the radius of the sphere, then there cannot be an intersection.
-						XMVECTOR NoIntersection = XMVectorLess(Dist, XMVectorNegate(jobData.func->Radius));
-						NoIntersection = XMVectorOrInt(NoIntersection, XMVectorGreater(Dist, jobData.func->Radius));
-
-						// Project the center of the sphere onto the plane of the triangle.
-						XMVECTOR Point0 = XMVectorNegativeMultiplySubtract(N, Dist, jobData.func->Center);
-
-						// Is it inside all the edges? If so we intersect because the distance 
-						// to the plane is less than the radius.
-						//XMVECTOR Intersection = DirectX::Internal::PointOnPlaneInsideTriangle(Point0, p0, p1, p2);
-
-						// Compute the cross products of the vector from the base of each edge to 
-						// the point with each edge vector.
-						XMVECTOR C0 = XMVector3Cross(XMVectorSubtract(Point0, p0), XMVectorSubtract(p1, p0));
-						XMVECTOR C1 = XMVector3Cross(XMVectorSubtract(Point0, p1), XMVectorSubtract(p2, p1));
-						XMVECTOR C2 = XMVector3Cross(XMVectorSubtract(Point0, p2), XMVectorSubtract(p0, p2));
-
-						// If the cross product points in the same direction as the normal the the
-						// point is inside the edge (it is zero if is on the edge).
-						XMVECTOR Zero = XMVectorZero();
-						XMVECTOR Inside0 = XMVectorLessOrEqual(XMVector3Dot(C0, N), Zero);
-						XMVECTOR Inside1 = XMVectorLessOrEqual(XMVector3Dot(C1, N), Zero);
-						XMVECTOR Inside2 = XMVectorLessOrEqual(XMVector3Dot(C2, N), Zero);
-
-						// If the point inside all of the edges it is inside.
-						XMVECTOR Intersection = XMVectorAndInt(XMVectorAndInt(Inside0, Inside1), Inside2);
-
-						bool inside = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
-
-						// Find the nearest point on each edge.
-
-						// Edge 0,1
-						XMVECTOR Point1 = DirectX::Internal::PointOnLineSegmentNearestPoint(p0, p1, jobData.func->Center);
-
-						// If the distance to the center of the sphere to the point is less than 
-						// the radius of the sphere then it must intersect.
-						Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(jobData.func->Center, Point1)), jobData.func->RadiusSq));
-
-						// Edge 1,2
-						XMVECTOR Point2 = DirectX::Internal::PointOnLineSegmentNearestPoint(p1, p2, jobData.func->Center);
-
-						// If the distance to the center of the sphere to the point is less than 
-						// the radius of the sphere then it must intersect.
-						Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(jobData.func->Center, Point2)), jobData.func->RadiusSq));
-
-						// Edge 2,0
-						XMVECTOR Point3 = DirectX::Internal::PointOnLineSegmentNearestPoint(p2, p0, jobData.func->Center);
-
-						// If the distance to the center of the sphere to the point is less than 
-						// the radius of the sphere then it must intersect.
-						Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(jobData.func->Center, Point3)), jobData.func->RadiusSq));
-
-						bool intersects = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
-
-						if (intersects)
-						{
-							XMVECTOR bestPoint = Point0;
-							if (!inside)
-							{
-								// If the sphere center's projection on the triangle plane is not within the triangle,
-								//	determine the closest point on triangle to the sphere center
-								float bestDist = XMVectorGetX(XMVector3LengthSq(Point1 - jobData.func->Center));
-								bestPoint = Point1;
-
-								float d = XMVectorGetX(XMVector3LengthSq(Point2 - jobData.func->Center));
-								if (d < bestDist)
-								{
-									bestDist = d;
-									bestPoint = Point2;
-								}
-								d = XMVectorGetX(XMVector3LengthSq(Point3 - jobData.func->Center));
-								if (d < bestDist)
-								{
-									bestDist = d;
-									bestPoint = Point3;
-								}
-							}
-							XMVECTOR intersectionVec = jobData.func->Center - bestPoint;
-							XMVECTOR intersectionVecLen = XMVector3Length(intersectionVec);
-
-							float depth = jobData.func->sphere.radius - XMVectorGetX(intersectionVecLen);
-							if (depth > groupResult.depth)
-							{
-								groupResult.entity = jobData.entity;
-								groupResult.depth = depth;
-								XMStoreFloat3(&groupResult.position, bestPoint);
-								XMStoreFloat3(&groupResult.normal, intersectionVec / intersectionVecLen);
-
-								XMMATRIX objectMatInverse = XMMatrixInverse(nullptr, jobData.objectMat);
-								XMVECTOR vel = bestPoint - XMVector3Transform(XMVector3Transform(bestPoint, objectMatInverse), jobData.objectMatPrev);
-								XMStoreFloat3(&groupResult.velocity, vel);
-							}
-						}
-						});
+					wi::jobsystem::ParallelReduce(ctx, jobCount, jobData.func->result, jobData.func->locker, [&jobData, subsetIndex, indexOffset, intersect_triangle](SphereIntersectionResult& groupResult, uint32_t jobIndex) {
+						intersect_triangle(jobData, groupResult, subsetIndex, indexOffset + jobIndex * 3);
+						}, deepest_hit);
 				}
+			};
 
+			if (IsObjectBVHValid())
+			{
+				// Only the objects in the BVH leaves that overlap the query are checked:
+				object_bvh.Intersects(sphere, 0, intersect_object);
 			}
-		}
-
-		// Merge thread results:
-		wi::jobsystem::Wait(ctx);
-		SphereIntersectionResult& result = jobDataFunction.groupResults[0];
-		for (uint32_t t = 1; t < threadCount; ++t)
-		{
-			if (jobDataFunction.groupResults[t].depth > result.depth)
+			else
 			{
-				result = jobDataFunction.groupResults[t];
+				ForEachObjectIntersecting(*this, sphere, layerMask, intersect_object);
 			}
 		}
 
+		// Wait for the reduction of group results:
+		wi::jobsystem::Wait(ctx);
+		SphereIntersectionResult& result = jobDataFunction.result;
+
 		return result;
 	}
 	Scene::CapsuleIntersectionResult Scene::Intersects(const Capsule& capsule, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
@@ -5091,7 +5666,8 @@ namespace wi::scene
 		wi::jobsystem::context ctx;
 		struct JobDataForFunction
 		{
-			CapsuleIntersectionResult* groupResults;
+			CapsuleIntersectionResult result;
+			wi::SpinLock locker;
 			Capsule capsule;
 			uint32_t layerMask;
 			XMVECTOR Base;
@@ -5103,13 +5679,13 @@ namespace wi::scene
 			XMVECTOR RadiusSq;
 			AABB capsule_aabb;
 		} jobDataFunction;
-		const uint32_t threadCount = wi::jobsystem::GetThreadCount();
-		jobDataFunction.groupResults = (CapsuleIntersectionResult*)allocator.allocate(AlignTo(sizeof(CapsuleIntersectionResult) * threadCount, 16));
-		const size_t allocator_reserved_begin = allocator.offset;
-		for (uint32_t t = 0; t < threadCount; ++t)
-		{
-			jobDataFunction.groupResults[t] = CapsuleIntersectionResult();
-		}
+		// The results of groups are reduced to the deepest intersection:
+		const auto deepest_hit = [](CapsuleIntersectionResult& result, const CapsuleIntersectionResult& groupResult) {
+			if (groupResult.depth > result.depth)
+			{
+				result = groupResult;
+			}
+		};
 		jobDataFunction.layerMask = layerMask;
 		jobDataFunction.capsule = capsule;
 		jobDataFunction.Base = XMLoadFloat3(&capsule.base);
@@ -5124,13 +5700,12 @@ namespace wi::scene
 		if (filterMask & FILTER_COLLIDER)
 		{
 			const uint32_t jobCount = collider_count_cpu;
-			const uint32_t groupSize = wi::jobsystem::DispatchGroupCount(jobCount, threadCount);
-			wi::jobsystem::Dispatch(ctx, jobCount, groupSize, [&jobDataFunction, this](wi::jobsystem::JobArgs args) {
+			wi::jobsystem::ParallelReduce(ctx, jobCount, jobDataFunction.result, jobDataFunction.locker, [&jobDataFunction, this](CapsuleIntersectionResult& groupResult, uint32_t jobIndex) {
 
-				if (!aabb_colliders_cpu[args.jobIndex].intersects(jobDataFunction.capsule_aabb))
+				if (!aabb_colliders_cpu[jobIndex].intersects(jobDataFunction.capsule_aabb))
 					return;
 
-				const ColliderComponent& collider = colliders_cpu[args.jobIndex];
+				const ColliderComponent& collider = colliders_cpu[jobIndex];
 
 				if ((collider.layerMask & jobDataFunction.layerMask) == 0)
 					return;
@@ -5157,319 +5732,342 @@ namespace wi::scene
 
 				if (intersects)
 				{
-					CapsuleIntersectionResult& groupResult = jobDataFunction.groupResults[args.groupID];
 					if (dist > groupResult.depth)
 					{
 						groupResult.depth = dist;
-						groupResult.entity = colliders.GetEntity(args.jobIndex);
+						groupResult.entity = colliders.GetEntity(jobIndex);
 						groupResult.normal = direction;
 						groupResult.position = position;
 						groupResult.velocity = {};
 					}
 				}
-				});
+				}, deepest_hit);
 		}
 
-		if (filterMask & FILTER_OBJECT_ALL)
+		struct JobDataForInstance
 		{
-			for (size_t objectIndex = 0; objectIndex < aabb_objects.size(); ++objectIndex)
-			{
-				const AABB& aabb = aabb_objects[objectIndex];
-				if (jobDataFunction.capsule_aabb.intersects(aabb) == AABB::INTERSECTION_TYPE::OUTSIDE || (layerMask & aabb.layerMask) == 0)
-					continue;
+			JobDataForFunction* func;
+			Entity entity;
+			const MeshComponent* mesh;
+			const SoftBodyPhysicsComponent* softbody;
+			const ArmatureComponent* armature;
+			const XMFLOAT3* skinned_positions;
+			XMMATRIX objectMat;
+			XMMATRIX objectMatPrev;
+		};
 
-				const ObjectComponent& object = objects[objectIndex];
+		// Tests a triangle of an instance, indexStart is the position of its first index in the mesh indices:
+		const auto intersect_triangle = [](const JobDataForInstance& jobData, CapsuleIntersectionResult& groupResult, uint32_t subsetIndex, uint32_t indexStart) {
 
-				if (object.meshID == INVALID_ENTITY)
-					continue;
-				if ((filterMask & object.GetFilterMask()) == 0)
-					continue;
+			const uint32_t i0 = jobData.mesh->indices[indexStart + 0];
+			const uint32_t i1 = jobData.mesh->indices[indexStart + 1];
+			const uint32_t i2 = jobData.mesh->indices[indexStart + 2];
 
-				const MeshComponent* mesh = meshes.GetComponent(object.meshID);
-				if (mesh == nullptr)
-					continue;
+			XMVECTOR p0;
+			XMVECTOR p1;
+			XMVECTOR p2;
 
-				struct JobDataForInstance
-				{
-					JobDataForFunction* func;
-					Entity entity;
-					const MeshComponent* mesh;
-					const SoftBodyPhysicsComponent* softbody;
-					const ArmatureComponent* armature;
-					XMMATRIX objectMat;
-					XMMATRIX objectMatPrev;
-				};
+			const bool softbody_active = jobData.softbody != nullptr && !jobData.softbody->vertex_positions_simulation.empty();
+			if (softbody_active)
+			{
+				p0 = jobData.softbody->vertex_positions_simulation[i0].LoadPOS();
+				p1 = jobData.softbody->vertex_positions_simulation[i1].LoadPOS();
+				p2 = jobData.softbody->vertex_positions_simulation[i2].LoadPOS();
+			}
+			else
+			{
+				const XMFLOAT3* positions = jobData.skinned_positions == nullptr ? jobData.mesh->vertex_positions.data() : jobData.skinned_positions;
+				p0 = XMLoadFloat3(&positions[i0]);
+				p1 = XMLoadFloat3(&positions[i1]);
+				p2 = XMLoadFloat3(&positions[i2]);
+			}
 
-				uint8_t* jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
-				if (jobdata_allocation == nullptr)
-				{
-					// Flush pending jobs, reset temp allocations, and reuse:
-					wi::jobsystem::Wait(ctx);
-					allocator.offset = allocator_reserved_begin;
-					jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
-				}
-				JobDataForInstance& jobData = *(JobDataForInstance*)jobdata_allocation;
-				jobData.func = &jobDataFunction;
-				jobData.mesh = mesh;
-				jobData.entity = objects.GetEntity(objectIndex);
-				jobData.softbody = softbodies.GetComponent(object.meshID);
-				jobData.objectMat = XMLoadFloat4x4(&matrix_objects[objectIndex]);
-				jobData.objectMatPrev = XMLoadFloat4x4(&matrix_objects_prev[objectIndex]);
-				jobData.armature = jobData.mesh->IsSkinned() ? armatures.GetComponent(jobData.mesh->armatureID) : nullptr;
+			p0 = XMVector3Transform(p0, jobData.objectMat);
+			p1 = XMVector3Transform(p1, jobData.objectMat);
+			p2 = XMVector3Transform(p2, jobData.objectMat);
 
-				uint32_t first_subset = 0;
-				uint32_t last_subset = 0;
-				jobData.mesh->GetLODSubsetRange(lod, first_subset, last_subset);
-				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
-				{
-					const MeshComponent::MeshSubset& subset = jobData.mesh->subsets[subsetIndex];
-					if (subset.indexCount == 0)
-						continue;
-					const uint32_t indexOffset = subset.indexOffset;
+			XMFLOAT3 min, max;
+			XMStoreFloat3(&min, XMVectorMin(p0, XMVectorMin(p1, p2)));
+			XMStoreFloat3(&max, XMVectorMax(p0, XMVectorMax(p1, p2)));
+			AABB aabb_triangle(min, max);
+			if (jobData.func->capsule_aabb.intersects(aabb_triangle) == AABB::OUTSIDE)
+				return;
 
-					// Parallel closest hit selection:
-					const uint32_t jobCount = subset.indexCount / 3;
-					const uint32_t groupSize = wi::jobsystem::DispatchGroupCount(jobCount, threadCount);
-					wi::jobsystem::Dispatch(ctx, jobCount, groupSize, [&jobData, subsetIndex, indexOffset](wi::jobsystem::JobArgs args) {
+			// Compute the plane of the triangle (has to be normalized).
+			XMVECTOR N = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
 
-						SceneIntersectSphereResult& groupResult = jobData.func->groupResults[args.groupID];
+			XMVECTOR ReferencePoint;
+			XMVECTOR d = XMVector3Normalize(jobData.func->B - jobData.func->A);
+			if (std::abs(XMVectorGetX(XMVector3Dot(N, d))) < std::numeric_limits<float>::epsilon())
+			{
+				// Capsule line cannot be intersected with triangle plane (they are parallel)
+				//	In this case, just take a point from triangle
+				ReferencePoint = p0;
+			}
+			else
+			{
+				// Intersect capsule line with triangle plane:
+				XMVECTOR t = XMVector3Dot(N, (jobData.func->Base - p0) / XMVectorAbs(XMVector3Dot(N, d)));
+				XMVECTOR LinePlaneIntersection = jobData.func->Base + d * t;
 
-						const uint32_t i0 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 0];
-						const uint32_t i1 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 1];
-						const uint32_t i2 = jobData.mesh->indices[indexOffset + args.jobIndex * 3 + 2];
+				// Compute the cross products of the vector from the base of each edge to 
+				// the point with each edge vector.
+				XMVECTOR C0 = XMVector3Cross(XMVectorSubtract(LinePlaneIntersection, p0), XMVectorSubtract(p1, p0));
+				XMVECTOR C1 = XMVector3Cross(XMVectorSubtract(LinePlaneIntersection, p1), XMVectorSubtract(p2, p1));
+				XMVECTOR C2 = XMVector3Cross(XMVectorSubtract(LinePlaneIntersection, p2), XMVectorSubtract(p0, p2));
 
-						XMVECTOR p0;
-						XMVECTOR p1;
-						XMVECTOR p2;
+				// If the cross product points in the same direction as the normal the the
+				// point is inside the edge (it is zero if is on the edge).
+				XMVECTOR Zero = XMVectorZero();
+				XMVECTOR Inside0 = XMVectorLessOrEqual(XMVector3Dot(C0, N), Zero);
+				XMVECTOR Inside1 = XMVectorLessOrEqual(XMVector3Dot(C1, N), Zero);
+				XMVECTOR Inside2 = XMVectorLessOrEqual(XMVector3Dot(C2, N), Zero);
 
-						const bool softbody_active = jobData.softbody != nullptr && !jobData.softbody->vertex_positions_simulation.empty();
-						if (softbody_active)
-						{
-							p0 = jobData.softbody->vertex_positions_simulation[i0].LoadPOS();
-							p1 = jobData.softbody->vertex_positions_simulation[i1].LoadPOS();
-							p2 = jobData.softbody->vertex_positions_simulation[i2].LoadPOS();
-						}
-						else
-						{
-							if (jobData.armature == nullptr || jobData.armature->boneData.empty())
-							{
-								p0 = XMLoadFloat3(&jobData.mesh->vertex_positions[i0]);
-								p1 = XMLoadFloat3(&jobData.mesh->vertex_positions[i1]);
-								p2 = XMLoadFloat3(&jobData.mesh->vertex_positions[i2]);
-							}
-							else
-							{
-								p0 = SkinVertex(*jobData.mesh, *jobData.armature, i0);
-								p1 = SkinVertex(*jobData.mesh, *jobData.armature, i1);
-								p2 = SkinVertex(*jobData.mesh, *jobData.armature, i2);
-							}
-						}
+				// If the point inside all of the edges it is inside.
+				XMVECTOR Intersection = XMVectorAndInt(XMVectorAndInt(Inside0, Inside1), Inside2);
 
-						p0 = XMVector3Transform(p0, jobData.objectMat);
-						p1 = XMVector3Transform(p1, jobData.objectMat);
-						p2 = XMVector3Transform(p2, jobData.objectMat);
+				bool inside = XMVectorGetIntX(Intersection) != 0;
 
-						XMFLOAT3 min, max;
-						XMStoreFloat3(&min, XMVectorMin(p0, XMVectorMin(p1, p2)));
-						XMStoreFloat3(&max, XMVectorMax(p0, XMVectorMax(p1, p2)));
-						AABB aabb_triangle(min, max);
-						if (jobData.func->capsule_aabb.intersects(aabb_triangle) == AABB::OUTSIDE)
-							return;
+				if (inside)
+				{
+					ReferencePoint = LinePlaneIntersection;
+				}
+				else
+				{
+					// Find the nearest point on each edge.
 
-						// Compute the plane of the triangle (has to be normalized).
-						XMVECTOR N = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+					// Edge 0,1
+					XMVECTOR Point1 = wi::math::ClosestPointOnLineSegment(p0, p1, LinePlaneIntersection);
 
-						XMVECTOR ReferencePoint;
-						XMVECTOR d = XMVector3Normalize(jobData.func->B - jobData.func->A);
-						if (std::abs(XMVectorGetX(XMVector3Dot(N, d))) < std::numeric_limits<float>::epsilon())
-						{
-							// Capsule line cannot be intersected with triangle plane (they are parallel)
-							//	In this case, just take a point from triangle
-							ReferencePoint = p0;
-						}
-						else
-						{
-							// Intersect capsule line with triangle plane:
-							XMVECTOR t = XMVector3Dot(N, (jobData.func->Base - p0) / XMVectorAbs(XMVector3Dot(N, d)));
-							XMVECTOR LinePlaneIntersection = jobData.func->Base + d * t;
+					// Edge 1,2
+					XMVECTOR Point2 = wi::math::ClosestPointOnLineSegment(p1, p2, LinePlaneIntersection);
 
-							// Compute the cross products of the vector from the base of each edge to 
-							// the point with each edge vector.
-							XMVECTOR C0 = XMVector3Cross(XMVectorSubtract(LinePlaneIntersection, p0), XMVectorSubtract(p1, p0));
-							XMVECTOR C1 = XMVector3Cross(XMVectorSubtract(LinePlaneIntersection, p1), XMVectorSubtract(p2, p1));
-							XMVECTOR C2 = XMVector3Cross(XMVectorSubtract(LinePlaneIntersection, p2), XMVectorSubtract(p0, p2));
+					// Edge 2,0
+					XMVECTOR Point3 = wi::math::ClosestPointOnLineSegment(p2, p0, LinePlaneIntersection);
 
-							// If the cross product points in the same direction as the normal the the
-							// point is inside the edge (it is zero if is on the edge).
-							XMVECTOR Zero = XMVectorZero();
-							XMVECTOR Inside0 = XMVectorLessOrEqual(XMVector3Dot(C0, N), Zero);
-							XMVECTOR Inside1 = XMVectorLessOrEqual(XMVector3Dot(C1, N), Zero);
-							XMVECTOR Inside2 = XMVectorLessOrEqual(XMVector3Dot(C2, N), Zero);
+					ReferencePoint = Point1;
+					float bestDist = XMVectorGetX(XMVector3LengthSq(Point1 - LinePlaneIntersection));
+					float d = abs(XMVectorGetX(XMVector3LengthSq(Point2 - LinePlaneIntersection)));
+					if (d < bestDist)
+					{
+						bestDist = d;
+						ReferencePoint = Point2;
+					}
+					d = abs(XMVectorGetX(XMVector3LengthSq(Point3 - LinePlaneIntersection)));
+					if (d < bestDist)
+					{
+						bestDist = d;
+						ReferencePoint = Point3;
+					}
+				}
 
-							// If the point inside all of the edges it is inside.
-							XMVECTOR Intersection = XMVectorAndInt(XMVectorAndInt(Inside0, Inside1), Inside2);
 
-							bool inside = XMVectorGetIntX(Intersection) != 0;
+			}
 
-							if (inside)
-							{
-								ReferencePoint = LinePlaneIntersection;
-							}
-							else
-							{
-								// Find the nearest point on each edge.
+			// Place a sphere on closest point on line segment to intersection:
+			XMVECTOR Center = wi::math::ClosestPointOnLineSegment(jobData.func->A, jobData.func->B, ReferencePoint);
 
-								// Edge 0,1
-								XMVECTOR Point1 = wi::math::ClosestPointOnLineSegment(p0, p1, LinePlaneIntersection);
+			// Assert that the triangle is not degenerate.
+			assert(!XMVector3Equal(N, XMVectorZero()));
 
-								// Edge 1,2
-								XMVECTOR Point2 = wi::math::ClosestPointOnLineSegment(p1, p2, LinePlaneIntersection);
+			// Find the nearest feature on the triangle to the sphere.
+			XMVECTOR Dist = XMVector3Dot(XMVectorSubtract(Center, p0), N);
 
-								// Edge 2,0
-								XMVECTOR Point3 = wi::math::ClosestPointOnLineSegment(p2, p0, LinePlaneIntersection);
+			if (!jobData.mesh->IsDoubleSided() && XMVectorGetX(Dist) > 0)
+				return; // pass through back faces
 
-								ReferencePoint = Point1;
-								float bestDist = XMVectorGetX(XMVector3LengthSq(Point1 - LinePlaneIntersection));
-								float d = abs(XMVectorGetX(XMVector3LengthSq(Point2 - LinePlaneIntersection)));
-								if (d < bestDist)
-								{
-									bestDist = d;
-									ReferencePoint = Point2;
-								}
-								d = abs(XMVectorGetX(XMVector3LengthSq(Point3 - LinePlaneIntersection)));
-								if (d < bestDist)
-								{
-									bestDist = d;
-									ReferencePoint = Point3;
-								}
-							}
+			// If the center of the sphere is farther from the plane of the triangle than
+			// the radius of the sphere, then there cannot be an intersection.
+			XMVECTOR NoIntersection = XMVectorLess(Dist, XMVectorNegate(jobData.func->Radius));
+			NoIntersection = XMVectorOrInt(NoIntersection, XMVectorGreater(Dist, jobData.func->Radius));
 
+			// Project the center of the sphere onto the plane of the triangle.
+			XMVECTOR Point0 = XMVectorNegativeMultiplySubtract(N, Dist, Center);
 
-						}
+			// Is it inside all the edges? If so we intersect because the distance 
+			// to the plane is less than the radius.
+			//XMVECTOR Intersection = DirectX::Internal::PointOnPlaneInsideTriangle(Point0, p0, p1, p2);
 
-						// Place a sphere on closest point on line segment to intersection:
-						XMVECTOR Center = wi::math::ClosestPointOnLineSegment(jobData.func->A, jobData.func->B, ReferencePoint);
+			// Compute the cross products of the vector from the base of each edge to 
+			// the point with each edge vector.
+			XMVECTOR C0 = XMVector3Cross(XMVectorSubtract(Point0, p0), XMVectorSubtract(p1, p0));
+			XMVECTOR C1 = XMVector3Cross(XMVectorSubtract(Point0, p1), XMVectorSubtract(p2, p1));
+			XMVECTOR C2 = XMVector3Cross(XMVectorSubtract(Point0, p2), XMVectorSubtract(p0, p2));
 
-						// Assert that the triangle is not degenerate.
-						assert(!XMVector3Equal(N, XMVectorZero()));
+			// If the cross product points in the same direction as the normal the the
+			// point is inside the edge (it is zero if is on the edge).
+			XMVECTOR Zero = XMVectorZero();
+			XMVECTOR Inside0 = XMVectorLessOrEqual(XMVector3Dot(C0, N), Zero);
+			XMVECTOR Inside1 = XMVectorLessOrEqual(XMVector3Dot(C1, N), Zero);
+			XMVECTOR Inside2 = XMVectorLessOrEqual(XMVector3Dot(C2, N), Zero);
 
-						// Find the nearest feature on the triangle to the sphere.
-						XMVECTOR Dist = XMVector3Dot(XMVectorSubtract(Center, p0), N);
+			// If the point inside all of the edges it is inside.
+			XMVECTOR Intersection = XMVectorAndInt(XMVectorAndInt(Inside0, Inside1), Inside2);
 
-						if (!jobData.mesh->IsDoubleSided() && XMVectorGetX(Dist) > 0)
-							return; // pass through back faces
+			bool inside = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
 
-						// If the center of the sphere is farther from the plane of the triangle than
-						// the radius of the sphere, then there cannot be an intersection.
-						XMVECTOR NoIntersection = XMVectorLess(Dist, XMVectorNegate(jobData.func->Radius));
-						NoIntersection = XMVectorOrInt(NoIntersection, XMVectorGreater(Dist, jobData.func->Radius));
+			// Find the nearest point on each edge.
 
-						// Project the center of the sphere onto the plane of the triangle.
-						XMVECTOR Point0 = XMVectorNegativeMultiplySubtract(N, Dist, Center);
+			// Edge 0,1
+			XMVECTOR Point1 = wi::math::ClosestPointOnLineSegment(p0, p1, Center);
 
-						// Is it inside all the edges? If so we intersect because the distance 
-						// to the plane is less than the radius.
-						//XMVECTOR Intersection = DirectX::Internal::PointOnPlaneInsideTriangle(Point0, p0, p1, p2);
+			// If the distance to the center of the sphere to the point is less than 
+			// the radius of the sphere then it must intersect.
+			Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(Center, Point1)), jobData.func->RadiusSq));
 
-						// Compute the cross products of the vector from the base of each edge to 
-						// the point with each edge vector.
-						XMVECTOR C0 = XMVector3Cross(XMVectorSubtract(Point0, p0), XMVectorSubtract(p1, p0));
-						XMVECTOR C1 = XMVector3Cross(XMVectorSubtract(Point0, p1), XMVectorSubtract(p2, p1));
-						XMVECTOR C2 = XMVector3Cross(XMVectorSubtract(Point0, p2), XMVectorSubtract(p0, p2));
+			// Edge 1,2
+			XMVECTOR Point2 = wi::math::ClosestPointOnLineSegment(p1, p2, Center);
 
-						// If the cross product points in the same direction as the normal the the
-						// point is inside the edge (it is zero if is on the edge).
-						XMVECTOR Zero = XMVectorZero();
-						XMVECTOR Inside0 = XMVectorLessOrEqual(XMVector3Dot(C0, N), Zero);
-						XMVECTOR Inside1 = XMVectorLessOrEqual(XMVector3Dot(C1, N), Zero);
-						XMVECTOR Inside2 = XMVectorLessOrEqual(XMVector3Dot(C2, N), Zero);
+			// If the distance to the center of the sphere to the point is less than 
+			// the radius of the sphere then it must intersect.
+			Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(Center, Point2)), jobData.func->RadiusSq));
 
-						// If the point inside all of the edges it is inside.
-						XMVECTOR Intersection = XMVectorAndInt(XMVectorAndInt(Inside0, Inside1), Inside2);
+			// Edge 2,0
+			XMVECTOR Point3 = wi::math::ClosestPointOnLineSegment(p2, p0, Center);
 
-						bool inside = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
+			// If the distance to the center of the sphere to the point is less than 
+			// the radius of the sphere then it must intersect.
+			Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(Center, Point3)), jobData.func->RadiusSq));
 
-						// Find the nearest point on each edge.
+			bool intersects = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
 
-						// Edge 0,1
-						XMVECTOR Point1 = wi::math::ClosestPointOnLineSegment(p0, p1, Center);
+			if (intersects)
+			{
+				XMVECTOR bestPoint = Point0;
+				if (!inside)
+				{
+					// If the sphere center's projection on the triangle plane is not within the triangle,
+					//	determine the closest point on triangle to the sphere center
+					float bestDist = XMVectorGetX(XMVector3LengthSq(Point1 - Center));
+					bestPoint = Point1;
 
-						// If the distance to the center of the sphere to the point is less than 
-						// the radius of the sphere then it must intersect.
-						Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(Center, Point1)), jobData.func->RadiusSq));
+					float d = XMVectorGetX(XMVector3LengthSq(Point2 - Center));
+					if (d < bestDist)
+					{
+						bestDist = d;
+						bestPoint = Point2;
+					}
+					d = XMVectorGetX(XMVector3LengthSq(Point3 - Center));
+					if (d < bestDist)
+					{
+						bestDist = d;
+						bestPoint = Point3;
+					}
+				}
+				XMVECTOR intersectionVec = Center - bestPoint;
+				XMVECTOR intersectionVecLen = XMVector3Length(intersectionVec);
 
-						// Edge 1,2
-						XMVECTOR Point2 = wi::math::ClosestPointOnLineSegment(p1, p2, Center);
+				float depth = jobData.func->capsule.radius - XMVectorGetX(intersectionVecLen);
+				if (depth > groupResult.depth)
+				{
+					groupResult.entity = jobData.entity;
+					groupResult.depth = depth;
+					XMStoreFloat3(&groupResult.position, bestPoint);
+					XMStoreFloat3(&groupResult.normal, intersectionVec / intersectionVecLen);
+
+					XMMATRIX objectMatInverse = XMMatrixInverse(nullptr, jobData.objectMat);
+					XMVECTOR vel = bestPoint - XMVector3Transform(XMVector3Transform(bestPoint, objectMatInverse), jobData.objectMatPrev);
+					XMStoreFloat3(&groupResult.velocity, vel);
+				}
+			}
+		};
 
-						// If the distance to the center of the sphere to the point is less than 
-						// the radius of the sphere then it must intersect.
-						Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(Center, Point2)), jobData.func->RadiusSq));
+		if (filterMask & FILTER_OBJECT_ALL)
+		{
+			const auto intersect_object = [&](uint32_t objectIndex) {
+				const AABB& aabb = aabb_objects[objectIndex];
+				if (jobDataFunction.capsule_aabb.intersects(aabb) == AABB::INTERSECTION_TYPE::OUTSIDE || (layerMask & aabb.layerMask) == 0)
+					return;
 
-						// Edge 2,0
-						XMVECTOR Point3 = wi::math::ClosestPointOnLineSegment(p2, p0, Center);
+				const ObjectComponent& object = objects[objectIndex];
 
-						// If the distance to the center of the sphere to the point is less than 
-						// the radius of the sphere then it must intersect.
-						Intersection = XMVectorOrInt(Intersection, XMVectorLessOrEqual(XMVector3LengthSq(XMVectorSubtract(Center, Point3)), jobData.func->RadiusSq));
+				if (object.meshID == INVALID_ENTITY)
+					return;
+				if ((filterMask & object.GetFilterMask()) == 0)
+					return;
 
-						bool intersects = XMVector4EqualInt(XMVectorAndCInt(Intersection, NoIntersection), XMVectorTrueInt());
+				const MeshComponent* mesh = meshes.GetComponent(object.meshID);
+				if (mesh == nullptr)
+					return;
 
-						if (intersects)
-						{
-							XMVECTOR bestPoint = Point0;
-							if (!inside)
-							{
-								// If the sphere center's projection on the triangle plane is not within the triangle,
-								//	determine the closest point on triangle to the sphere center
-								float bestDist = XMVectorGetX(XMVector3LengthSq(Point1 - Center));
-								bestPoint = Point1;
+				uint8_t* jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
+				if (jobdata_allocation == nullptr)
+				{
+					// Flush pending jobs, reset temp allocations, and reuse:
+					wi::jobsystem::Wait(ctx);
+					allocator.reset();
+					jobdata_allocation = allocator.allocate(AlignTo(sizeof(JobDataForInstance), 16));
+				}
+				JobDataForInstance& jobData = *(JobDataForInstance*)jobdata_allocation;
+				jobData.func = &jobDataFunction;
+				jobData.mesh = mesh;
+				jobData.entity = objects.GetEntity(objectIndex);
+				jobData.softbody = softbodies.GetComponent(object.meshID);
+				jobData.objectMat = XMLoadFloat4x4(&matrix_objects[objectIndex]);
+				jobData.objectMatPrev = XMLoadFloat4x4(&matrix_objects_prev[objectIndex]);
+				jobData.armature = jobData.mesh->IsSkinned() ? armatures.GetComponent(jobData.mesh->armatureID) : nullptr;
 
-								float d = XMVectorGetX(XMVector3LengthSq(Point2 - Center));
-								if (d < bestDist)
-								{
-									bestDist = d;
-									bestPoint = Point2;
-								}
-								d = XMVectorGetX(XMVector3LengthSq(Point3 - Center));
-								if (d < bestDist)
-								{
-									bestDist = d;
-									bestPoint = Point3;
-								}
-							}
-							XMVECTOR intersectionVec = Center - bestPoint;
-							XMVECTOR intersectionVecLen = XMVector3Length(intersectionVec);
+				uint32_t first_subset = 0;
+				uint32_t last_subset = 0;
+				jobData.mesh->GetLODSubsetRange(lod, first_subset, last_subset);
 
-							float depth = jobData.func->capsule.radius - XMVectorGetX(intersectionVecLen);
-							if (depth > groupResult.depth)
+				// Static meshes with a cached triangle BVH only test the triangles in the BVH leaves that overlap the query:
+				const bool softbody_active = jobData.softbody != nullptr && !jobData.softbody->vertex_positions_simulation.empty();
+				const bool skinned = jobData.armature != nullptr && !jobData.armature->boneData.empty();
+				const std::shared_ptr<const MeshComponent::TriangleBVH> triangle_bvh = softbody_active || skinned ? nullptr : jobData.mesh->GetTriangleBVH();
+				jobData.skinned_positions = !softbody_active && skinned ? jobData.mesh->GetSkinnedPositions(*jobData.armature) : nullptr;
+				if (triangle_bvh != nullptr)
+				{
+					const AABB aabb_local = jobDataFunction.capsule_aabb.transform(XMMatrixInverse(nullptr, jobData.objectMat));
+					CapsuleIntersectionResult instanceResult;
+					triangle_bvh->bvh.Intersects(aabb_local, 0, [&](uint32_t triangleIndex) {
+						const uint32_t indexStart = triangleIndex * 3;
+						for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+						{
+							const MeshComponent::MeshSubset& subset = jobData.mesh->subsets[subsetIndex];
+							if (indexStart >= subset.indexOffset && indexStart < subset.indexOffset + subset.indexCount)
 							{
-								groupResult.entity = jobData.entity;
-								groupResult.depth = depth;
-								XMStoreFloat3(&groupResult.position, bestPoint);
-								XMStoreFloat3(&groupResult.normal, intersectionVec / intersectionVecLen);
-
-								XMMATRIX objectMatInverse = XMMatrixInverse(nullptr, jobData.objectMat);
-								XMVECTOR vel = bestPoint - XMVector3Transform(XMVector3Transform(bestPoint, objectMatInverse), jobData.objectMatPrev);
-								XMStoreFloat3(&groupResult.velocity, vel);
+								intersect_triangle(jobData, instanceResult, subsetIndex, indexStart);
+								break;
 							}
 						}
 					});
+					jobDataFunction.locker.lock();
+					deepest_hit(jobDataFunction.result, instanceResult);
+					jobDataFunction.locker.unlock();
+					return;
 				}
 
-			}
-		}
+				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				{
+					const MeshComponent::MeshSubset& subset = jobData.mesh->subsets[subsetIndex];
+					if (subset.indexCount == 0)
+						continue;
+					const uint32_t indexOffset = subset.indexOffset;
 
-		// Merge thread results:
-		wi::jobsystem::Wait(ctx);
-		CapsuleIntersectionResult& result = jobDataFunction.groupResults[0];
-		for (uint32_t t = 1; t < threadCount; ++t)
-		{
-			if (jobDataFunction.groupResults[t].depth > result.depth)
+					// Parallel closest hit selection:
+					const uint32_t jobCount = subset.indexCount / 3;
+					wi::jobsystem::ParallelReduce(ctx, jobCount, jobData.func->result, jobData.func->locker, [&jobData, subsetIndex, indexOffset, intersect_triangle](CapsuleIntersectionResult& groupResult, uint32_t jobIndex) {
+						intersect_triangle(jobData, groupResult, subsetIndex, indexOffset + jobIndex * 3);
+						}, deepest_hit);
+				}
+			};
+
+			if (IsObjectBVHValid())
+			{
+				// Only the objects in the BVH leaves that overlap the query are checked:
+				object_bvh.Intersects(jobDataFunction.capsule_aabb, 0, intersect_object);
+			}
+			else
 			{
-				result = jobDataFunction.groupResults[t];
+				ForEachObjectIntersecting(*this, jobDataFunction.capsule_aabb, layerMask, intersect_object);
 			}
 		}
 
+		// Wait for the reduction of group results:
+		wi::jobsystem::Wait(ctx);
+		CapsuleIntersectionResult& result = jobDataFunction.result;
+
 		return result;
 	}
 
@@ -5490,43 +6088,65 @@ namespace wi::scene
 		waterRipples.push_back(img);
 	}
 
-	XMVECTOR SkinVertex(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t index, XMVECTOR* N)
+	// The weighted rows of the bone matrices are blended first, so the vertex is only transformed once:
+	struct BlendedBoneRows
 	{
-		XMVECTOR P = XMLoadFloat3(&mesh.vertex_positions[index]);
-		const XMUINT4& ind = mesh.vertex_boneindices[index];
-		const XMFLOAT4& wei = mesh.vertex_boneweights[index];
-
-		const XMFLOAT4X4 mat[] = {
-			armature.boneData[ind.x].GetMatrix(),
-			armature.boneData[ind.y].GetMatrix(),
-			armature.boneData[ind.z].GetMatrix(),
-			armature.boneData[ind.w].GetMatrix(),
-		};
-		const XMMATRIX M[] = {
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[0])),
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[1])),
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[2])),
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[3])),
-		};
+		XMVECTOR R0;
+		XMVECTOR R1;
+		XMVECTOR R2;
+
+		inline BlendedBoneRows(const ShaderTransform* bones, const XMUINT4& ind, const XMFLOAT4& wei)
+		{
+			R0 = XMVectorZero();
+			R1 = XMVectorZero();
+			R2 = XMVectorZero();
+			Add(bones, ind.x, wei.x);
+			Add(bones, ind.y, wei.y);
+			Add(bones, ind.z, wei.z);
+			Add(bones, ind.w, wei.w);
+		}
+		inline void Add(const ShaderTransform* bones, uint32_t bone, float weight)
+		{
+			if (weight == 0)
+				return;
+			const XMVECTOR W = XMVectorReplicate(weight);
+			R0 = XMVectorMultiplyAdd(XMLoadFloat4(&bones[bone].mat0), W, R0);
+			R1 = XMVectorMultiplyAdd(XMLoadFloat4(&bones[bone].mat1), W, R1);
+			R2 = XMVectorMultiplyAdd(XMLoadFloat4(&bones[bone].mat2), W, R2);
+		}
+		// V.w must be 1 for positions and 0 for normals:
+		inline XMVECTOR Transform(XMVECTOR V) const
+		{
+			const XMMATRIX T = XMMatrixTranspose(XMMATRIX(R0 * V, R1 * V, R2 * V, XMVectorZero()));
+			return T.r[0] + T.r[1] + T.r[2] + T.r[3];
+		}
+	};
 
-		XMVECTOR skinned;
-		skinned =  XMVector3Transform(P, M[0]) * wei.x;
-		skinned += XMVector3Transform(P, M[1]) * wei.y;
-		skinned += XMVector3Transform(P, M[2]) * wei.z;
-		skinned += XMVector3Transform(P, M[3]) * wei.w;
-		P = skinned;
+	XMVECTOR SkinVertex(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t index, XMVECTOR* N)
+	{
+		const BlendedBoneRows rows(armature.boneData.data(), mesh.vertex_boneindices[index], mesh.vertex_boneweights[index]);
 
 		if (N != nullptr)
 		{
-			*N = XMLoadFloat3(&mesh.vertex_normals[index]);
-			skinned =  XMVector3TransformNormal(*N, M[0]) * wei.x;
-			skinned += XMVector3TransformNormal(*N, M[1]) * wei.y;
-			skinned += XMVector3TransformNormal(*N, M[2]) * wei.z;
-			skinned += XMVector3TransformNormal(*N, M[3]) * wei.w;
-			*N = XMVector3Normalize(skinned);
+			*N = XMVector3Normalize(rows.Transform(XMVectorSetW(XMLoadFloat3(&mesh.vertex_normals[index]), 0)));
 		}
 
-		return P;
+		return rows.Transform(XMVectorSetW(XMLoadFloat3(&mesh.vertex_positions[index]), 1));
+	}
+
+	void SkinVertices(const MeshComponent& mesh, const ArmatureComponent& armature, const uint32_t* vertex_indices, uint32_t count, XMFLOAT3* positions, XMFLOAT3* normals)
+	{
+		const ShaderTransform* bones = armature.boneData.data();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t index = vertex_indices == nullptr ? i : vertex_indices[i];
+			const BlendedBoneRows rows(bones, mesh.vertex_boneindices[index], mesh.vertex_boneweights[index]);
+			XMStoreFloat3(&positions[i], rows.Transform(XMVectorSetW(XMLoadFloat3(&mesh.vertex_positions[index]), 1)));
+			if (normals != nullptr)
+			{
+				XMStoreFloat3(&normals[i], XMVector3Normalize(rows.Transform(XMVectorSetW(XMLoadFloat3(&mesh.vertex_normals[index]), 0))));
+			}
+		}
 	}
 
 
@@ -5577,7 +6197,7 @@ namespace wi::scene
 			{
 				// In this case, we don't care about the root anymore, so delete it. This will simplify overall hierarchy
 				scene.Component_DetachChildren(root);
-				scene.Entity_Remove(root);
+				scene.Entity_Remove(root, true, true);
 				root = INVALID_ENTITY;
 			}
 
@@ -5587,6 +6207,237 @@ namespace wi::scene
 		return INVALID_ENTITY;
 	}
 
+	ModelStreamer::~ModelStreamer()
+	{
+		wi::jobsystem::Wait(ctx);
+	}
+	void ModelStreamer::Start(const std::string& fileName, const XMMATRIX& transformMatrix, bool attached)
+	{
+		wi::jobsystem::Wait(ctx);
+		loaded_scene.Clear();
+		root = INVALID_ENTITY;
+		merge_entries.clear();
+		merge_entry = 0;
+		merge_offset = 0;
+		merged_count = 0;
+		total_count = 0;
+		merged_components.clear();
+		loaded_entities.clear();
+		unloaded_count = 0;
+		final_merge_pending = false;
+		loaded_scene.componentLibrary.deserialize_section_count.store(0);
+		loaded_scene.componentLibrary.deserialized_section_count.store(0);
+		cancelled.store(false);
+		state.store(State::Loading);
+
+		this->fileName = fileName;
+		XMStoreFloat4x4(&transform, transformMatrix);
+		this->attached = attached;
+
+		ctx.priority = wi::jobsystem::Priority::Streaming;
+		wi::jobsystem::Execute(ctx, [this](wi::jobsystem::JobArgs args) {
+			if (cancelled.load())
+			{
+				state.store(State::Cancelled);
+				return;
+			}
+			if (!wi::helper::FileExists(this->fileName))
+			{
+				wi::backlog::post("ModelStreamer: file not found: " + this->fileName, wi::backlog::LogLevel::Error);
+				state.store(State::Failed);
+				return;
+			}
+			root = LoadModel(loaded_scene, this->fileName, XMLoadFloat4x4(&transform), this->attached);
+
+			wi::unordered_set<Entity> entities;
+			loaded_scene.FindAllEntities(entities);
+			loaded_entities.reserve(entities.size());
+			loaded_entities.insert(loaded_entities.end(), entities.begin(), entities.end());
+
+			if (cancelled.load())
+			{
+				loaded_scene.Clear();
+				RecycleEntities();
+				state.store(State::Cancelled);
+				return;
+			}
+			state.store(State::Merging);
+		});
+	}
+	bool ModelStreamer::Update(Scene& scene, float budget_milliseconds)
+	{
+		if (wi::jobsystem::IsBusy(ctx))
+			return false;
+
+		const State current_state = state.load();
+		if (current_state != State::Merging && current_state != State::Unloading)
+			return current_state != State::Loading;
+
+		wi::Timer timer;
+
+		if (current_state == State::Unloading)
+		{
+			while (unloaded_count < loaded_entities.size())
+			{
+				const size_t count = std::min(loaded_entities.size() - unloaded_count, merge_step_size);
+				for (size_t i = 0; i < count; ++i)
+				{
+					scene.Entity_Remove(loaded_entities[unloaded_count + i], false);
+				}
+				unloaded_count += count;
+				if (timer.elapsed_milliseconds() >= budget_milliseconds)
+					return false;
+			}
+			RecycleEntities();
+			root = INVALID_ENTITY;
+			state.store(State::Idle);
+			return true;
+		}
+
+		if (cancelled.load())
+		{
+			// Remove what was merged so far:
+			while (!merged_components.empty())
+			{
+				const size_t count = std::min(merged_components.size(), merge_step_size);
+				for (size_t i = 0; i < count; ++i)
+				{
+					const MergedComponent& merged = merged_components.back();
+					merged.dest->Remove(merged.entity);
+					merged_components.pop_back();
+				}
+				if (timer.elapsed_milliseconds() >= budget_milliseconds)
+					return false;
+			}
+			merge_entries.clear();
+			state.store(State::Cancelled);
+			// The remaining loaded data is freed in the background:
+			wi::jobsystem::Execute(ctx, [this](wi::jobsystem::JobArgs args) {
+				loaded_scene.Clear();
+				RecycleEntities();
+			});
+			return true;
+		}
+
+		if (merge_entries.empty())
+		{
+			// The objects are merged last, the rest of the order doesn't matter:
+			MergeEntry objects_entry;
+			for (auto& it : scene.componentLibrary.entries)
+			{
+				auto it_source = loaded_scene.componentLibrary.entries.find(it.first);
+				if (it_source == loaded_scene.componentLibrary.entries.end())
+					continue;
+				MergeEntry entry;
+				entry.dest = it.second.component_manager.get();
+				entry.source = it_source->second.component_manager.get();
+				total_count += entry.source->GetCount();
+				if (entry.dest == &scene.objects)
+				{
+					objects_entry = entry;
+				}
+				else
+				{
+					merge_entries.push_back(entry);
+				}
+			}
+			if (objects_entry.dest != nullptr)
+			{
+				merge_entries.push_back(objects_entry);
+			}
+			merged_components.reserve(total_count);
+		}
+
+		while (merge_entry < merge_entries.size())
+		{
+			const MergeEntry& entry = merge_entries[merge_entry];
+			const size_t count = std::min(entry.source->GetCount() - merge_offset, merge_step_size);
+			for (size_t i = 0; i < count; ++i)
+			{
+				MergedComponent& merged = merged_components.emplace_back();
+				merged.dest = entry.dest;
+				merged.entity = entry.source->GetEntity(merge_offset + i);
+			}
+			entry.dest->MergeRange(*entry.source, merge_offset, count);
+			merge_offset += count;
+			merged_count += count;
+			if (merge_offset >= entry.source->GetCount())
+			{
+				entry.source->Clear();
+				merge_entry++;
+				merge_offset = 0;
+			}
+			if (timer.elapsed_milliseconds() >= budget_milliseconds)
+				return false;
+			final_merge_pending = true;
+		}
+		if (final_merge_pending)
+		{
+			// The last component step was performed in this call, the final merge is started in the next one with a full budget:
+			final_merge_pending = false;
+			return false;
+		}
+
+		// The component managers are empty now, this merges the rest of the scene data (bounds, DDGI)
+		//	The cost doesn't depend on the model size: it is one empty Merge() per component type, measured as ~0.04 ms in total for ~40 component types
+		scene.Merge(loaded_scene);
+		merge_entries.clear();
+		merged_components.clear();
+		state.store(State::Finished);
+		return true;
+	}
+	void ModelStreamer::Cancel()
+	{
+		if (state.load() == State::Finished)
+		{
+			Unload();
+			return;
+		}
+		cancelled.store(true);
+	}
+	void ModelStreamer::Unload()
+	{
+		if (state.load() == State::Finished)
+		{
+			unloaded_count = 0;
+			state.store(State::Unloading);
+		}
+		else
+		{
+			Cancel();
+		}
+	}
+	void ModelStreamer::RecycleEntities()
+	{
+		for (Entity entity : loaded_entities)
+		{
+			wi::ecs::DestroyEntity(entity);
+		}
+		loaded_entities.clear();
+		unloaded_count = 0;
+	}
+	float ModelStreamer::GetProgress() const
+	{
+		switch (state.load())
+		{
+		case State::Loading:
+		{
+			// Only the component sections of the file are counted, so this stays 0 while the resources are loading:
+			const uint32_t section_count = loaded_scene.componentLibrary.deserialize_section_count.load();
+			if (section_count == 0)
+				return 0;
+			return 0.5f * float(loaded_scene.componentLibrary.deserialized_section_count.load()) / float(section_count);
+		}
+		case State::Merging:
+			return total_count == 0 ? 0.5f : (0.5f + 0.5f * float(merged_count) / float(total_count));
+		case State::Finished:
+			return 1;
+		default:
+			break;
+		}
+		return 0;
+	}
+
 	PickResult Pick(const wi::primitive::Ray& ray, uint32_t filterMask, uint32_t layerMask, const Scene& scene, uint32_t lod)
 	{
 		return scene.Intersects(ray, filterMask, layerMask, lod);
@@ -5700,6 +6551,7 @@ namespace wi::scene
 
 								auto& animation_data = animation_datas.Contains(sampler.data) ? *animation_datas.GetComponent(sampler.data) : sampler.backwards_compatibility_data;
 								retarget_animation_data = animation_data;
+								retarget_animation_data.Decompress(); // baking modifies the raw keyframes
 
 								XMVECTOR S, R, T; // matrix decompose destinations
 
@@ -5766,6 +6618,104 @@ namespace wi::scene
 		return INVALID_ENTITY;
 	}
 
+	uint32_t Scene::CompressAnimations(float tolerance)
+	{
+		// The layout of the animation data is determined by the channels that sample it, data that is used inconsistently is not compressed:
+		struct DataUsage
+		{
+			uint32_t component_count = 0;
+			bool quaternion = false;
+			bool step = false;
+			bool compressible = true;
+		};
+		wi::unordered_map<Entity, DataUsage> usages;
+		for (size_t i = 0; i < animations.GetCount(); ++i)
+		{
+			const AnimationComponent& animation = animations[i];
+			for (const AnimationComponent::AnimationChannel& channel : animation.channels)
+			{
+				if (channel.samplerIndex < 0 || channel.samplerIndex >= (int)animation.samplers.size())
+					continue;
+				const AnimationComponent::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+				if (!animation_datas.Contains(sampler.data))
+					continue;
+
+				uint32_t component_count = 0;
+				bool quaternion = false;
+				switch (channel.GetPathDataType())
+				{
+				case AnimationComponent::AnimationChannel::PathDataType::Float:
+					component_count = 1;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Float2:
+					component_count = 2;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Float3:
+					component_count = 3;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Float4:
+					component_count = 4;
+					quaternion = channel.path == AnimationComponent::AnimationChannel::Path::ROTATION;
+					break;
+				case AnimationComponent::AnimationChannel::PathDataType::Weights:
+				{
+					const ObjectComponent* object = objects.GetComponent(channel.target);
+					const MeshComponent* mesh = object == nullptr ? nullptr : meshes.GetComponent(object->meshID);
+					if (mesh != nullptr)
+					{
+						component_count = (uint32_t)mesh->morph_targets.size();
+					}
+				}
+				break;
+				default:
+					break;
+				}
+
+				const bool step = sampler.mode == AnimationComponent::AnimationSampler::Mode::STEP;
+				const bool first_usage = usages.count(sampler.data) == 0;
+				DataUsage& usage = usages[sampler.data];
+				if (first_usage)
+				{
+					usage.component_count = component_count;
+					usage.quaternion = quaternion;
+					usage.step = step;
+				}
+				// The removable keyframes depend on the interpolation, so data that is sampled both with LINEAR and STEP is not compressed:
+				if (
+					component_count == 0 ||
+					sampler.mode == AnimationComponent::AnimationSampler::Mode::CUBICSPLINE ||
+					usage.component_count != component_count ||
+					usage.quaternion != quaternion ||
+					usage.step != step
+					)
+				{
+					usage.compressible = false;
+				}
+			}
+		}
+
+		wi::vector<std::pair<AnimationDataComponent*, DataUsage>> compressible;
+		for (auto& it : usages)
+		{
+			if (it.second.compressible)
+			{
+				compressible.emplace_back(animation_datas.GetComponent(it.first), it.second);
+			}
+		}
+
+		std::atomic<uint32_t> compressed_count{ 0 };
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)compressible.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			auto& item = compressible[args.jobIndex];
+			if (item.first->Compress(item.second.component_count, item.second.quaternion, tolerance, item.second.step))
+			{
+				compressed_count.fetch_add(1);
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+		return compressed_count.load();
+	}
+
 	void Scene::ScanAnimationDependencies()
 	{
 		if (animations.GetCount() == 0)
@@ -81,7 +81,21 @@ namespace wi::scene
 
 		// AABB culling streams:
 		wi::vector<wi::primitive::AABB> aabb_objects;
+
+		// BVH of aabb_objects for CPU queries and hierarchical culling:
+		//	It is refitted every frame, and rebuilt when the object count changed or refitting degraded it too much
+		//	When it is disabled, the queries walk aabb_objects linearly
+		wi::BVH object_bvh;
+		float object_bvh_build_cost = 0; // the SAH cost of object_bvh after the last full build
+		bool object_bvh_enabled = true;
+		void SetObjectBVHEnabled(bool value = true) { object_bvh_enabled = value; }
+		bool IsObjectBVHEnabled() const { return object_bvh_enabled; }
+		// Returns true if object_bvh can be used for the current aabb_objects
+		bool IsObjectBVHValid() const { return object_bvh_enabled && object_bvh.IsValid() && object_bvh.leaf_count == aabb_objects.size(); }
 		wi::vector<wi::primitive::AABB> aabb_lights;
+		// aabb_objects and aabb_lights in SIMD friendly layout, one AABB4 holds four consecutive AABBs:
+		wi::vector<wi::primitive::AABB4> aabb_objects_soa;
+		wi::vector<wi::primitive::AABB4> aabb_lights_soa;
 		wi::vector<wi::primitive::AABB> aabb_probes;
 		wi::vector<wi::primitive::AABB> aabb_decals;
 
@@ -89,6 +103,19 @@ namespace wi::scene
 		wi::vector<XMFLOAT4X4> matrix_objects;
 		wi::vector<XMFLOAT4X4> matrix_objects_prev;
 
+		// Transform dependent object data that is reused while the object's world matrix and mesh bounds don't change:
+		struct ObjectTransformCache
+		{
+			wi::primitive::AABB mesh_aabb; // the mesh bounds that the cache was computed with
+			wi::primitive::AABB aabb;
+			ShaderTransform transform;
+			ShaderTransform transformInverseTranspose;
+			bool front_counterclockwise = false;
+			bool valid = false;
+		};
+		wi::vector<ObjectTransformCache> transformcache_objects;
+		uint64_t transformcache_objects_version = ~0ull; // objects structure version that transformcache_objects was made for
+
 		// Shader visible scene parameters:
 		ShaderScene shaderscene;
 
@@ -276,10 +303,36 @@ namespace wi::scene
 		wi::jobsystem::context animation_dependency_scan_workload;
 		void ScanAnimationDependencies();
 
+		// Hierarchy update order:
+		//	The nodes are sorted by depth, so parents are updated before their children and nodes of the same depth can be updated in parallel
+		//	Parents that don't have a HierarchyComponent themselves are included as root nodes, but their components are not modified
+		//	The nodes are rebuilt when the hierarchy, transforms or layers change structure, or a parentID is modified
+		struct HierarchyNode
+		{
+			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+			wi::ecs::Entity parentID = wi::ecs::INVALID_ENTITY;
+			uint32_t hierarchy_index = ~0u;	// ~0u for root nodes without HierarchyComponent
+			uint32_t parent = ~0u;			// parent node index, ~0u if there is no parent
+			uint32_t transform_index = ~0u;	// ~0u if the entity has no TransformComponent
+			uint32_t layer_index = ~0u;		// ~0u if the entity has no LayerComponent
+
+			// State of the last update, a subtree is skipped if the local transforms didn't change:
+			bool dirty = true;
+			uint32_t layerMask = ~0u;		// combined layerMask of the node and its ancestors
+			XMFLOAT3 scale_local = XMFLOAT3(0, 0, 0);
+			XMFLOAT4 rotation_local = XMFLOAT4(0, 0, 0, 0);
+			XMFLOAT3 translation_local = XMFLOAT3(0, 0, 0);
+			XMFLOAT4X4 world = wi::math::IDENTITY_MATRIX;	// combined local matrix of the node and its ancestors
+		};
+		wi::vector<HierarchyNode> hierarchy_nodes;
+		wi::vector<uint32_t> hierarchy_level_offsets; // nodes of depth d are in the range [hierarchy_level_offsets[d], hierarchy_level_offsets[d + 1])
+		uint64_t hierarchy_structure_versions[3] = { ~0ull, ~0ull, ~0ull }; // hierarchy, transforms and layers structure versions that the nodes were built for
+		void BuildHierarchyNodes();
+
 		// Update all components by a given timestep (in seconds):
 		//	This is an expensive function, prefer to call it only once per frame!
 		virtual void Update(float dt);
-		// Remove everything from the scene that it owns:
+		// Remove everything from the scene that it owns, the entities are destroyed with wi::ecs::DestroyEntities() so their indices can be reused:
 		virtual void Clear();
 		// Merge an other scene into this.
 		//	The contents of the other scene will be lost (and moved to this)!
@@ -289,7 +342,10 @@ namespace wi::scene
 
 		// Removes (deletes) a specific entity from the scene (if it exists):
 		//	recursive	: also removes children if true
-		void Entity_Remove(wi::ecs::Entity entity, bool recursive = true);
+		//	recycle		: the removed entities are destroyed with wi::ecs::DestroyEntity(), so their indices can be reused by new entities
+		//					Entities that are added back later (for example by undo) still work, but they can't be recycled again
+		//					It can be disabled if the removed entities will be added back often, so that their index is not used by two entities at the same time
+		void Entity_Remove(wi::ecs::Entity entity, bool recursive = true, bool recycle = true);
 		// Finds the first entity by the name (if it exists, otherwise returns INVALID_ENTITY):
 		//	ancestor : you can specify an ancestor entity if you only want to find entities that are descendants of ancestor entity
 		wi::ecs::Entity Entity_FindByName(const std::string& name, wi::ecs::Entity ancestor = wi::ecs::INVALID_ENTITY);
@@ -402,6 +458,8 @@ namespace wi::scene
 		void RunMaterialUpdateSystem(wi::jobsystem::context& ctx);
 		void RunImpostorUpdateSystem(wi::jobsystem::context& ctx);
 		void RunObjectUpdateSystem(wi::jobsystem::context& ctx);
+		void RunObjectBVHUpdateSystem(wi::jobsystem::context& ctx);
+		void RunAABBStreamUpdateSystem(wi::jobsystem::context& ctx);
 		void RunCameraUpdateSystem(wi::jobsystem::context& ctx);
 		void RunDecalUpdateSystem(wi::jobsystem::context& ctx);
 		void RunProbeUpdateSystem(wi::jobsystem::context& ctx);
@@ -439,6 +497,20 @@ namespace wi::scene
 		//	layerMask		:	filter based on layer
 		RayIntersectionResult Intersects(const wi::primitive::Ray& ray, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
 
+		struct RayQuery
+		{
+			wi::primitive::Ray ray; // TMin and TMax of the ray limit the hit distance
+			uint32_t filterMask = wi::enums::FILTER_OPAQUE;
+			uint32_t layerMask = ~0u;
+			uint32_t lod = 0;
+		};
+		// Finds the closest intersections of many rays at once, this is much faster than calling Intersects() for every ray
+		//	The rays are sorted for coherence and traced in parallel, every ray on a single thread
+		//	queries	:	array of ray queries
+		//	count	:	number of elements in queries and results
+		//	results	:	array of results, results[i] will be the closest intersection of queries[i]
+		void Intersects(const RayQuery* queries, uint32_t count, RayIntersectionResult* results) const;
+
 		struct SphereIntersectionResult
 		{
 			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
@@ -463,12 +535,23 @@ namespace wi::scene
 		//
 		//	returns entity ID of the new animation or INVALID_ENTITY if retargeting was not successful
 		wi::ecs::Entity RetargetAnimation(wi::ecs::Entity dst, wi::ecs::Entity src, bool bake_data);
+
+		// Compresses all animation data that is sampled only with LINEAR or only with STEP interpolation, see AnimationDataComponent::Compress()
+		//	tolerance	:	the largest allowed error of a keyframe value component caused by removing keyframes
+		//	returns the number of animation data components that were compressed
+		uint32_t CompressAnimations(float tolerance = 0.0001f);
 	};
 
 	// Returns skinned vertex position in armature local space
 	//	N : normal (out, optional)
 	XMVECTOR SkinVertex(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t index, XMVECTOR* N = nullptr);
 
+	// Skins multiple vertices in armature local space, this is faster than calling SkinVertex() for each of them
+	//	vertex_indices	: the vertices to skin, or nullptr to skin the first count vertices
+	//	positions		: receives the skinned position of each vertex, positions[i] belongs to vertex_indices[i]
+	//	normals			: receives the skinned normal of each vertex (optional)
+	void SkinVertices(const MeshComponent& mesh, const ArmatureComponent& armature, const uint32_t* vertex_indices, uint32_t count, XMFLOAT3* positions, XMFLOAT3* normals = nullptr);
+
 
 	// Helper that manages a global scene
 	//	(You don't need to use it, but it's an option for simplicity)
@@ -503,6 +586,87 @@ namespace wi::scene
 	//	returns INVALID_ENTITY if attached argument was false, else it returns the base entity handle
 	wi::ecs::Entity LoadModel(Scene& scene, const std::string& fileName, const XMMATRIX& transformMatrix = XMMatrixIdentity(), bool attached = false);
 
+	// Loads a wiscene file in the background and adds the contents to a scene in small steps, to avoid frame stalls when streaming in content:
+	//	1) Start() loads the file into a separate scene with a streaming priority job (resources and render data are also created here)
+	//	2) Update() must be called every frame from the thread that updates the scene, it merges components into the scene until the time budget runs out
+	//		The objects are merged last, so a model only becomes visible after the components that it references
+	//	The loading can be cancelled at any time, in that case the already merged components are removed from the scene by the following Update() calls
+	class ModelStreamer
+	{
+	public:
+		enum class State
+		{
+			Idle,		// not started
+			Loading,	// the file is loading in the background
+			Merging,	// the components are being merged into the scene by Update()
+			Finished,	// the contents were merged into the scene
+			Failed,		// the file couldn't be loaded
+			Cancelled,	// the loading was cancelled, nothing remains in the scene
+			Unloading,	// the contents are being removed from the scene by Update()
+		};
+
+		~ModelStreamer();
+
+		// Start loading a wiscene file, the parameters are the same as with LoadModel()
+		//	If a previous loading is still in progress in the background, it will be waited for
+		void Start(const std::string& fileName, const XMMATRIX& transformMatrix = XMMatrixIdentity(), bool attached = false);
+		// Continue merging the contents into the scene, this must be called every frame until it returns true
+		//	The same scene must be used in every call until the loading is finished
+		//	budget_milliseconds : the function returns when its work took longer than this (at least one small step is always performed)
+		//	returns true if the loading is finished, failed or was cancelled, or the unloading is finished
+		bool Update(Scene& scene, float budget_milliseconds = 1.0f);
+		// Cancel the loading, the Update() calls will remove the already merged components from the scene
+		//	If the loading is already finished, this is the same as Unload(), otherwise it has no effect when nothing is loading
+		void Cancel();
+		// Remove the finished model from the scene with the following Update() calls (if it's still loading, this is the same as Cancel())
+		//	The loaded entities are destroyed with wi::ecs::DestroyEntity() so their indices can be reused, they must not be used after this
+		//	This must be called before the next Start() if the model should be unloaded later
+		void Unload();
+
+		State GetState() const { return state.load(); }
+		// Returns the loading progress in range [0, 1], the background loading is the first half and the merging is the second half
+		//	The background loading progress is based on the number of component sections that were read from the file
+		float GetProgress() const;
+		// Returns the base entity if the model was loaded with attached = true, otherwise INVALID_ENTITY
+		wi::ecs::Entity GetRootEntity() const { return root; }
+
+		// The number of components that are merged in one step
+		static constexpr size_t merge_step_size = 256;
+
+	private:
+		Scene loaded_scene;
+		wi::jobsystem::context ctx;
+		std::atomic<State> state{ State::Idle };
+		std::atomic_bool cancelled{ false };
+		wi::ecs::Entity root = wi::ecs::INVALID_ENTITY;
+		std::string fileName;
+		XMFLOAT4X4 transform = wi::math::IDENTITY_MATRIX;
+		bool attached = false;
+
+		struct MergeEntry
+		{
+			wi::ecs::ComponentManager_Interface* dest = nullptr;
+			wi::ecs::ComponentManager_Interface* source = nullptr;
+		};
+		wi::vector<MergeEntry> merge_entries; // empty until the merging is started
+		size_t merge_entry = 0; // index of the currently merging entry
+		size_t merge_offset = 0; // index of the next component of the currently merging entry
+		size_t merged_count = 0;
+		size_t total_count = 0;
+		bool final_merge_pending = false; // the final Scene::Merge() is performed in a separate Update() call from the component steps
+		struct MergedComponent
+		{
+			wi::ecs::ComponentManager_Interface* dest = nullptr;
+			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+		};
+		wi::vector<MergedComponent> merged_components; // for removal when the loading is cancelled
+		wi::vector<wi::ecs::Entity> loaded_entities; // all entities that were created by the loading, they are recycled when cancelled or unloaded
+		size_t unloaded_count = 0;
+
+		// Destroys the loaded entities that are not used by loaded_scene or the scene anymore
+		void RecycleEntities();
+	};
+
 	// Deprecated, use Scene::Intersects() function instead
 	using PickResult = Scene::RayIntersectionResult;
 	PickResult Pick(const wi::primitive::Ray& ray, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, const Scene& scene = GetScene(), uint32_t lod = 0);
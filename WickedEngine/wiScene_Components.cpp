@@ -1,4 +1,5 @@
 #include "wiScene_Components.h"
+#include "wiScene.h"
 #include "wiTextureHelper.h"
 #include "wiResourceManager.h"
 #include "wiPhysics.h"
@@ -470,6 +471,7 @@ namespace wi::scene
 	void MeshComponent::CreateRenderData()
 	{
 		DeleteRenderData();
+		InvalidateTriangleBVH();
 
 		GraphicsDevice* device = wi::graphics::GetDevice();
 
@@ -826,6 +828,89 @@ namespace wi::scene
 			CreateStreamoutRenderData();
 		}
 	}
+	const XMFLOAT3* MeshComponent::GetSkinnedPositions(const ArmatureComponent& armature) const
+	{
+		if (armature.boneData.empty())
+			return vertex_positions.data(); // the armature was not updated yet
+
+		std::shared_ptr<SkinningCache> cache = std::atomic_load(&skinning_cache.cache);
+		if (cache == nullptr)
+		{
+			std::shared_ptr<SkinningCache> created = std::make_shared<SkinningCache>();
+			if (std::atomic_compare_exchange_strong(&skinning_cache.cache, &cache, created))
+			{
+				cache = created;
+			}
+		}
+
+		// Concurrent queries of the same mesh wait for the first one to finish skinning:
+		std::scoped_lock lock(cache->locker);
+		if (cache->armature != &armature || cache->bone_data_version != armature.bone_data_version || cache->positions.size() != vertex_positions.size())
+		{
+			cache->positions.resize(vertex_positions.size());
+			SkinVertices(*this, armature, nullptr, (uint32_t)vertex_positions.size(), cache->positions.data());
+			cache->armature = &armature;
+			cache->bone_data_version = armature.bone_data_version;
+		}
+		return cache->positions.data();
+	}
+	std::shared_ptr<const MeshComponent::TriangleBVH> MeshComponent::GetTriangleBVH() const
+	{
+		if (indices.size() / 3 < TriangleBVH::min_triangle_count)
+			return nullptr;
+
+		std::shared_ptr<TriangleBVH> bvh = std::atomic_load(&triangle_bvh);
+		if (bvh == nullptr)
+		{
+			std::shared_ptr<TriangleBVH> created = std::make_shared<TriangleBVH>();
+			if (!std::atomic_compare_exchange_strong(&triangle_bvh, &bvh, created))
+				return nullptr; // other thread started the build
+
+			// The build works from a copy, so the mesh can be moved by its ComponentManager in the meantime:
+			created->vertex_count = (uint32_t)vertex_positions.size();
+			created->index_count = (uint32_t)indices.size();
+			created->build_positions = vertex_positions;
+			created->build_indices = indices;
+
+			static struct BuildContext : wi::jobsystem::context
+			{
+				BuildContext()
+				{
+					priority = wi::jobsystem::Priority::Low;
+					name = "TriangleBVH";
+				}
+			} ctx;
+			wi::jobsystem::Execute(ctx, [created](wi::jobsystem::JobArgs args) {
+				const uint32_t triangle_count = created->index_count / 3;
+				created->build_aabbs.resize(triangle_count);
+				for (uint32_t triangleIndex = 0; triangleIndex < triangle_count; ++triangleIndex)
+				{
+					const XMVECTOR p0 = XMLoadFloat3(&created->build_positions[created->build_indices[triangleIndex * 3 + 0]]);
+					const XMVECTOR p1 = XMLoadFloat3(&created->build_positions[created->build_indices[triangleIndex * 3 + 1]]);
+					const XMVECTOR p2 = XMLoadFloat3(&created->build_positions[created->build_indices[triangleIndex * 3 + 2]]);
+					AABB& aabb = created->build_aabbs[triangleIndex];
+					XMStoreFloat3(&aabb._min, XMVectorMin(p0, XMVectorMin(p1, p2)));
+					XMStoreFloat3(&aabb._max, XMVectorMax(p0, XMVectorMax(p1, p2)));
+				}
+				created->bvh.Build(created->build_aabbs.data(), triangle_count, wi::jobsystem::Priority::Low);
+				created->bvh.leaf_aabb_data = nullptr;
+				created->build_positions = {};
+				created->build_indices = {};
+				created->build_aabbs = {};
+				created->ready.store(true, std::memory_order_release);
+			});
+			return nullptr;
+		}
+		if (!bvh->ready.load(std::memory_order_acquire))
+			return nullptr;
+		if (bvh->vertex_count != vertex_positions.size() || bvh->index_count != indices.size())
+		{
+			// The geometry was resized without invalidation, the BVH will be rebuilt on the next call:
+			InvalidateTriangleBVH();
+			return nullptr;
+		}
+		return bvh;
+	}
 	void MeshComponent::CreateStreamoutRenderData()
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
@@ -1412,6 +1497,439 @@ namespace wi::scene
 		}
 	}
 
+	void AnimationDataComponent::RefreshTimeRange()
+	{
+		if (IsCompressed())
+		{
+			// The compressed keyframes are always sorted, the range is known from the segments:
+			time_first = compressed_segments.empty() ? 0 : compressed_segments.front().time_start;
+			time_last = compressed_segments.empty() ? 0 : compressed_segments.back().time_end;
+			keyframe_times_sorted = false;
+			return;
+		}
+		if (refreshed_keyframe_times == keyframe_times.data() && refreshed_keyframe_count == keyframe_times.size())
+			return;
+		refreshed_keyframe_times = keyframe_times.data();
+		refreshed_keyframe_count = keyframe_times.size();
+
+		time_first = std::numeric_limits<float>::max();
+		time_last = std::numeric_limits<float>::min();
+		keyframe_times_sorted = !keyframe_times.empty();
+		for (size_t k = 0; k < keyframe_times.size(); ++k)
+		{
+			const float time = keyframe_times[k];
+			time_first = std::min(time_first, time);
+			time_last = std::max(time_last, time);
+			if (k > 0 && time <= keyframe_times[k - 1])
+			{
+				keyframe_times_sorted = false;
+			}
+		}
+	}
+	int AnimationDataComponent::FindKeyframe(float time, int& cursor) const
+	{
+		const int count = (int)keyframe_times.size();
+		const int key = std::max(0, std::min(cursor, count - 1));
+		if (keyframe_times[key] <= time)
+		{
+			// The time is usually still between the same keyframes, or between the next ones:
+			if (key + 1 == count || keyframe_times[key + 1] > time)
+				return cursor = key;
+			if (key + 2 == count || keyframe_times[key + 2] > time)
+				return cursor = key + 1;
+		}
+		const auto it = std::upper_bound(keyframe_times.begin(), keyframe_times.end(), time);
+		cursor = std::max(0, int(it - keyframe_times.begin()) - 1);
+		return int(it - keyframe_times.begin()) - 1;
+	}
+
+	namespace animation_compression
+	{
+		inline void Write16(wi::vector<uint8_t>& data, uint32_t value)
+		{
+			data.push_back(uint8_t(value & 0xFF));
+			data.push_back(uint8_t((value >> 8) & 0xFF));
+		}
+		inline uint32_t Read16(const uint8_t* data, size_t index)
+		{
+			return uint32_t(data[index * 2]) | (uint32_t(data[index * 2 + 1]) << 8);
+		}
+		inline uint32_t Quantize(float value, float min, float extent, float maxvalue)
+		{
+			if (extent <= 0)
+				return 0;
+			return (uint32_t)std::round(wi::math::saturate((value - min) / extent) * maxvalue);
+		}
+		inline float Dequantize(uint32_t value, float min, float extent, float maxvalue)
+		{
+			return min + float(value) / maxvalue * extent;
+		}
+
+		// Smallest three encoding: the largest component is made positive and dropped, it is reconstructed from the unit length
+		//	The remaining three are in [-1/sqrt2, 1/sqrt2] range and quantized to 15 bits, the index of the dropped component takes 2 bits
+		static constexpr float QUATERNION_RANGE = 0.70710678f;
+		static constexpr float QUATERNION_MAX = float((1 << 15) - 1);
+		inline void EncodeQuaternion(const float* q, uint32_t packed[3])
+		{
+			int largest = 0;
+			for (int i = 1; i < 4; ++i)
+			{
+				if (std::abs(q[i]) > std::abs(q[largest]))
+				{
+					largest = i;
+				}
+			}
+			const float sign = q[largest] < 0 ? -1.0f : 1.0f;
+			uint64_t bits = uint64_t(largest) << 45;
+			int shift = 30;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (i == largest)
+					continue;
+				bits |= uint64_t(Quantize(q[i] * sign, -QUATERNION_RANGE, QUATERNION_RANGE * 2, QUATERNION_MAX)) << shift;
+				shift -= 15;
+			}
+			packed[0] = uint32_t(bits & 0xFFFF);
+			packed[1] = uint32_t((bits >> 16) & 0xFFFF);
+			packed[2] = uint32_t((bits >> 32) & 0xFFFF);
+		}
+		inline void DecodeQuaternion(const uint32_t packed[3], float* q)
+		{
+			const uint64_t bits = uint64_t(packed[0]) | (uint64_t(packed[1]) << 16) | (uint64_t(packed[2]) << 32);
+			const int largest = int((bits >> 45) & 3);
+			float sum = 0;
+			int shift = 30;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (i == largest)
+					continue;
+				q[i] = Dequantize(uint32_t((bits >> shift) & 0x7FFF), -QUATERNION_RANGE, QUATERNION_RANGE * 2, QUATERNION_MAX);
+				sum += q[i] * q[i];
+				shift -= 15;
+			}
+			q[largest] = std::sqrt(std::max(0.0f, 1 - sum));
+		}
+
+		// Checks whether the keyframes between first and last can be reconstructed by interpolating first and last within tolerance
+		inline bool CanRemoveKeyframes(const float* times, const float* values, uint32_t component_count, bool quaternion, float tolerance, size_t first, size_t last)
+		{
+			const float* a = values + first * component_count;
+			const float* b = values + last * component_count;
+			for (size_t k = first + 1; k < last; ++k)
+			{
+				const float t = (times[k] - times[first]) / (times[last] - times[first]);
+				const float* v = values + k * component_count;
+				if (quaternion)
+				{
+					const XMVECTOR Q = XMQuaternionNormalize(XMQuaternionSlerp(XMLoadFloat4((const XMFLOAT4*)a), XMLoadFloat4((const XMFLOAT4*)b), t));
+					XMVECTOR V = XMLoadFloat4((const XMFLOAT4*)v);
+					// q and -q are the same rotation:
+					if (XMVectorGetX(XMVector4Dot(Q, V)) < 0)
+					{
+						V = XMVectorNegate(V);
+					}
+					if (!XMVector4LessOrEqual(XMVectorAbs(Q - V), XMVectorReplicate(tolerance)))
+						return false;
+				}
+				else
+				{
+					for (uint32_t c = 0; c < component_count; ++c)
+					{
+						if (std::abs(wi::math::Lerp(a[c], b[c], t) - v[c]) > tolerance)
+							return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Checks whether keyframe b has the same value as keyframe a within tolerance, so it can be removed from STEP sampled data
+		inline bool IsSameKeyframe(const float* values, uint32_t component_count, bool quaternion, float tolerance, size_t a, size_t b)
+		{
+			const float* va = values + a * component_count;
+			const float* vb = values + b * component_count;
+			if (quaternion)
+			{
+				const XMVECTOR A = XMLoadFloat4((const XMFLOAT4*)va);
+				XMVECTOR B = XMLoadFloat4((const XMFLOAT4*)vb);
+				// q and -q are the same rotation:
+				if (XMVectorGetX(XMVector4Dot(A, B)) < 0)
+				{
+					B = XMVectorNegate(B);
+				}
+				return XMVector4LessOrEqual(XMVectorAbs(A - B), XMVectorReplicate(tolerance));
+			}
+			for (uint32_t c = 0; c < component_count; ++c)
+			{
+				if (std::abs(va[c] - vb[c]) > tolerance)
+					return false;
+			}
+			return true;
+		}
+
+		inline float DecodeTime(const AnimationDataComponent::CompressedSegment& segment, const uint8_t* segment_data, uint32_t key)
+		{
+			// The last key is exact, so that it matches the start of the next segment:
+			if (key == segment.key_count - 1)
+				return segment.time_end;
+			return Dequantize(Read16(segment_data, key), segment.time_start, segment.time_end - segment.time_start, 65535.0f);
+		}
+		inline void DecodeValue(const AnimationDataComponent& animationdata, const AnimationDataComponent::CompressedSegment& segment, const uint8_t* segment_data, uint32_t key, float* dst)
+		{
+			const uint8_t* payload = segment_data + segment.key_count * 2;
+			const uint32_t component_count = animationdata.compressed_component_count;
+			if (animationdata.compressed_quaternion)
+			{
+				const uint32_t packed[3] = { Read16(payload, key * 3), Read16(payload, key * 3 + 1), Read16(payload, key * 3 + 2) };
+				DecodeQuaternion(packed, dst);
+			}
+			else
+			{
+				const float* ranges = animationdata.compressed_ranges.data() + segment.range_offset;
+				for (uint32_t c = 0; c < component_count; ++c)
+				{
+					dst[c] = Dequantize(Read16(payload, key * component_count + c), ranges[c * 2], ranges[c * 2 + 1], 65535.0f);
+				}
+			}
+		}
+	}
+	bool AnimationDataComponent::Compress(uint32_t component_count, bool quaternion, float tolerance, bool step)
+	{
+		using namespace animation_compression;
+		RefreshTimeRange();
+		if (IsCompressed() || !keyframe_times_sorted || component_count == 0 || component_count > COMPRESSION_MAX_COMPONENTS || (quaternion && component_count != 4))
+			return false;
+		const size_t count = keyframe_times.size();
+		if (keyframe_data.size() != count * component_count)
+			return false;
+
+		const float* times = keyframe_times.data();
+		const float* values = keyframe_data.data();
+
+		// Keyframe reduction: from every kept keyframe, the span to the next kept keyframe is grown exponentially while the removed keyframes
+		//	stay within tolerance, then the largest valid span is refined with binary search. The span length is limited to bound the cost.
+		//	With STEP interpolation the value is held until the next keyframe, so only repeated values can be removed, but the last keyframe
+		//	is always kept because it determines the time range.
+		static constexpr size_t MAX_SPAN = 256;
+		wi::vector<uint32_t> kept;
+		kept.reserve(count);
+		size_t first = 0;
+		kept.push_back(0);
+		while (step && first + 1 < count)
+		{
+			size_t next = first + 1;
+			while (next < count - 1 && IsSameKeyframe(values, component_count, quaternion, tolerance, first, next))
+			{
+				next++;
+			}
+			kept.push_back((uint32_t)next);
+			first = next;
+		}
+		while (!step && first + 1 < count)
+		{
+			size_t good = first + 1;
+			size_t bad = 0;
+			size_t span = 2;
+			while (bad == 0)
+			{
+				const size_t last = std::min(first + span, count - 1);
+				if (CanRemoveKeyframes(times, values, component_count, quaternion, tolerance, first, last))
+				{
+					good = last;
+					if (last == count - 1 || span >= MAX_SPAN)
+						break;
+					span *= 2;
+				}
+				else
+				{
+					bad = last;
+				}
+			}
+			while (bad > good + 1)
+			{
+				const size_t mid = (good + bad) / 2;
+				if (CanRemoveKeyframes(times, values, component_count, quaternion, tolerance, first, mid))
+				{
+					good = mid;
+				}
+				else
+				{
+					bad = mid;
+				}
+			}
+			kept.push_back((uint32_t)good);
+			first = good;
+		}
+
+		compressed_component_count = component_count;
+		compressed_keyframe_count = (uint32_t)count;
+		compressed_quaternion = quaternion;
+		compressed_segments.clear();
+		compressed_data.clear();
+		compressed_ranges.clear();
+
+		size_t segment_first = 0;
+		while (true)
+		{
+			const size_t segment_last = std::min(segment_first + COMPRESSION_SEGMENT_KEYS - 1, kept.size() - 1);
+			CompressedSegment& segment = compressed_segments.emplace_back();
+			segment.time_start = times[kept[segment_first]];
+			segment.time_end = times[kept[segment_last]];
+			segment.key_count = uint32_t(segment_last - segment_first + 1);
+			segment.data_offset = (uint32_t)compressed_data.size();
+			segment.range_offset = (uint32_t)compressed_ranges.size();
+
+			for (size_t i = segment_first; i <= segment_last; ++i)
+			{
+				Write16(compressed_data, Quantize(times[kept[i]], segment.time_start, segment.time_end - segment.time_start, 65535.0f));
+			}
+
+			if (quaternion)
+			{
+				for (size_t i = segment_first; i <= segment_last; ++i)
+				{
+					uint32_t packed[3];
+					EncodeQuaternion(values + kept[i] * 4, packed);
+					Write16(compressed_data, packed[0]);
+					Write16(compressed_data, packed[1]);
+					Write16(compressed_data, packed[2]);
+				}
+			}
+			else
+			{
+				for (uint32_t c = 0; c < component_count; ++c)
+				{
+					float range_min = std::numeric_limits<float>::max();
+					float range_max = std::numeric_limits<float>::lowest();
+					for (size_t i = segment_first; i <= segment_last; ++i)
+					{
+						const float value = values[kept[i] * component_count + c];
+						range_min = std::min(range_min, value);
+						range_max = std::max(range_max, value);
+					}
+					compressed_ranges.push_back(range_min);
+					compressed_ranges.push_back(range_max - range_min);
+				}
+				const float* ranges = compressed_ranges.data() + segment.range_offset;
+				for (size_t i = segment_first; i <= segment_last; ++i)
+				{
+					for (uint32_t c = 0; c < component_count; ++c)
+					{
+						Write16(compressed_data, Quantize(values[kept[i] * component_count + c], ranges[c * 2], ranges[c * 2 + 1], 65535.0f));
+					}
+				}
+			}
+
+			if (segment_last == kept.size() - 1)
+				break;
+			segment_first = segment_last;
+		}
+
+		keyframe_times.clear();
+		keyframe_times.shrink_to_fit();
+		keyframe_data.clear();
+		keyframe_data.shrink_to_fit();
+		refreshed_keyframe_count = 0;
+		_flags |= COMPRESSED;
+		RefreshTimeRange();
+		return true;
+	}
+	void AnimationDataComponent::Decompress()
+	{
+		if (!IsCompressed())
+			return;
+
+		// Only the kept keyframes are restored, the removed ones are not needed for interpolation
+		keyframe_times.clear();
+		keyframe_data.clear();
+		for (size_t s = 0; s < compressed_segments.size(); ++s)
+		{
+			const CompressedSegment& segment = compressed_segments[s];
+			const uint8_t* segment_data = compressed_data.data() + segment.data_offset;
+			// The first key of a segment is the same as the last key of the previous one:
+			for (uint32_t k = s == 0 ? 0 : 1; k < segment.key_count; ++k)
+			{
+				keyframe_times.push_back(animation_compression::DecodeTime(segment, segment_data, k));
+				keyframe_data.resize(keyframe_data.size() + compressed_component_count);
+				animation_compression::DecodeValue(*this, segment, segment_data, k, keyframe_data.data() + keyframe_data.size() - compressed_component_count);
+			}
+		}
+
+		_flags &= ~COMPRESSED;
+		compressed_component_count = 0;
+		compressed_keyframe_count = 0;
+		compressed_quaternion = false;
+		compressed_segments.clear();
+		compressed_data.clear();
+		compressed_ranges.clear();
+		refreshed_keyframe_count = 0;
+		RefreshTimeRange();
+	}
+	int AnimationDataComponent::DecodeKeyframes(float time, int& cursor, float times[2], float* data) const
+	{
+		using namespace animation_compression;
+		const int segment_count = (int)compressed_segments.size();
+		if (segment_count == 0 || time < compressed_segments.front().time_start)
+			return 0;
+
+		// Segment lookup, the current or the next segment are checked before the binary search:
+		int s = std::max(0, std::min(cursor, segment_count - 1));
+		auto contains = [&](int index) {
+			return compressed_segments[index].time_start <= time && (index + 1 == segment_count || compressed_segments[index + 1].time_start > time);
+		};
+		if (!contains(s))
+		{
+			if (s + 1 < segment_count && contains(s + 1))
+			{
+				s = s + 1;
+			}
+			else
+			{
+				const auto it = std::upper_bound(compressed_segments.begin(), compressed_segments.end(), time, [](float value, const CompressedSegment& segment) {
+					return value < segment.time_start;
+				});
+				s = std::max(0, int(it - compressed_segments.begin()) - 1);
+			}
+		}
+		cursor = s;
+
+		const CompressedSegment& segment = compressed_segments[s];
+		const uint8_t* segment_data = compressed_data.data() + segment.data_offset;
+
+		uint32_t key = 0;
+		times[0] = segment.time_start;
+		while (key + 1 < segment.key_count)
+		{
+			const float next = DecodeTime(segment, segment_data, key + 1);
+			if (next > time)
+			{
+				times[1] = next;
+				break;
+			}
+			times[0] = next;
+			key++;
+		}
+		const int result = key + 1 == segment.key_count || times[0] == time ? 1 : 2;
+		if (result == 1)
+		{
+			times[1] = times[0];
+		}
+		for (int i = 0; i < result; ++i)
+		{
+			DecodeValue(*this, segment, segment_data, key + i, data + i * compressed_component_count);
+		}
+		return result;
+	}
+	size_t AnimationDataComponent::GetMemorySizeInBytes() const
+	{
+		return
+			keyframe_times.size() * sizeof(float) +
+			keyframe_data.size() * sizeof(float) +
+			compressed_segments.size() * sizeof(CompressedSegment) +
+			compressed_data.size() +
+			compressed_ranges.size() * sizeof(float);
+	}
+
 	AnimationComponent::AnimationChannel::PathDataType AnimationComponent::AnimationChannel::GetPathDataType() const
 	{
 		switch (path)
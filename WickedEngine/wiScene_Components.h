@@ -7,6 +7,7 @@
 #include "wiEnums.h"
 #include "wiOcean.h"
 #include "wiPrimitive.h"
+#include "wiBVH.h"
 #include "shaders/ShaderInterop_Renderer.h"
 #include "wiResourceManager.h"
 #include "wiVector.h"
@@ -324,6 +325,8 @@ namespace wi::scene
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 
+	struct ArmatureComponent;
+
 	struct MeshComponent
 	{
 		enum FLAGS
@@ -424,6 +427,44 @@ namespace wi::scene
 		};
 		mutable BLAS_STATE BLAS_state = BLAS_STATE_NEEDS_REBUILD;
 
+		// CPU triangle BVH for intersection queries, it is built on demand by GetTriangleBVH()
+		struct TriangleBVH
+		{
+			static constexpr uint32_t min_triangle_count = 1024; // smaller meshes are tested without BVH
+
+			wi::BVH bvh; // leaf index is the triangle index, the triangle's first index is at indices[leaf * 3]
+			uint32_t vertex_count = 0;
+			uint32_t index_count = 0;
+			std::atomic<bool> ready{ false };
+
+			// Copy of the geometry that the BVH is built from, it is released after the build:
+			wi::vector<XMFLOAT3> build_positions;
+			wi::vector<uint32_t> build_indices;
+			wi::vector<wi::primitive::AABB> build_aabbs;
+		};
+		mutable std::shared_ptr<TriangleBVH> triangle_bvh;
+
+		// CPU skinned vertex positions for intersection queries and physics, they are updated on demand by GetSkinnedPositions()
+		struct SkinningCache
+		{
+			wi::SpinLock locker;
+			const ArmatureComponent* armature = nullptr;
+			uint64_t bone_data_version = ~0ull;
+			wi::vector<XMFLOAT3> positions;
+		};
+		// The cache is not shared by copies of the mesh, because the copy can be modified or skinned by a different armature:
+		struct SkinningCacheRef
+		{
+			std::shared_ptr<SkinningCache> cache;
+
+			SkinningCacheRef() = default;
+			SkinningCacheRef(const SkinningCacheRef&) {}
+			SkinningCacheRef(SkinningCacheRef&&) = default;
+			SkinningCacheRef& operator=(const SkinningCacheRef&) { cache = {}; return *this; }
+			SkinningCacheRef& operator=(SkinningCacheRef&&) = default;
+		};
+		mutable SkinningCacheRef skinning_cache;
+
 		inline void SetRenderable(bool value) { if (value) { _flags |= RENDERABLE; } else { _flags &= ~RENDERABLE; } }
 		inline void SetDoubleSided(bool value) { if (value) { _flags |= DOUBLE_SIDED; } else { _flags &= ~DOUBLE_SIDED; } }
 		inline void SetDoubleSidedShadow(bool value) { if (value) { _flags |= DOUBLE_SIDED_SHADOW; } else { _flags &= ~DOUBLE_SIDED_SHADOW; } }
@@ -454,8 +495,21 @@ namespace wi::scene
 		// Deletes all GPU resources
 		void DeleteRenderData();
 
-		// Recreates GPU resources for index/vertex buffers
+		// Recreates GPU resources for index/vertex buffers, and invalidates the CPU triangle BVH
 		void CreateRenderData();
+
+		// Returns the CPU triangle BVH of the mesh if it is ready, otherwise nullptr
+		//	The first call starts building it in the background, until that is finished the triangles must be tested without it
+		//	It is not used for meshes with less than TriangleBVH::min_triangle_count triangles
+		//	The returned reference must be kept while the BVH is used, because it can be invalidated concurrently
+		std::shared_ptr<const TriangleBVH> GetTriangleBVH() const;
+		// The triangle BVH must be invalidated when vertex_positions or indices are modified, CreateRenderData() also does this
+		inline void InvalidateTriangleBVH() const { std::atomic_store(&triangle_bvh, std::shared_ptr<TriangleBVH>()); }
+
+		// Returns the vertex positions skinned with the current bone matrices of the armature (in armature local space, same as SkinVertex())
+		//	The mesh is skinned at most once per armature update, all callers in between reuse the result
+		//	The returned pointer stays valid until the next armature update, so the armature must not be updated while it is used
+		const XMFLOAT3* GetSkinnedPositions(const ArmatureComponent& armature) const;
 		void CreateStreamoutRenderData();
 		void CreateRaytracingRenderData();
 
@@ -822,6 +876,7 @@ namespace wi::scene
 		wi::primitive::AABB aabb;
 		uint32_t gpuBoneOffset = 0;
 		wi::vector<ShaderTransform> boneData;
+		uint64_t bone_data_version = 0; // incremented every time boneData is updated
 
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
@@ -1093,12 +1148,76 @@ namespace wi::scene
 		enum FLAGS
 		{
 			EMPTY = 0,
+			COMPRESSED = 1 << 0,
 		};
 		uint32_t _flags = EMPTY;
 
 		wi::vector<float> keyframe_times;
 		wi::vector<float> keyframe_data;
 
+		// Compressed keyframes, used instead of keyframe_times and keyframe_data when the COMPRESSED flag is set:
+		//	The keyframes are stored in segments of limited key count, the last key of a segment is repeated as the first key of the next one
+		//	Keyframe times are quantized to 16 bits relative to their segment
+		//	Values are quantized to 16 bits relative to the range of their segment, quaternions are stored as the smallest three components
+		static constexpr uint32_t COMPRESSION_MAX_COMPONENTS = 16;
+		static constexpr uint32_t COMPRESSION_SEGMENT_KEYS = 64;
+		struct CompressedSegment
+		{
+			float time_start = 0;
+			float time_end = 0;
+			uint32_t key_count = 0;
+			uint32_t data_offset = 0;	// byte offset into compressed_data
+			uint32_t range_offset = 0;	// float offset into compressed_ranges
+		};
+		uint32_t compressed_component_count = 0;
+		uint32_t compressed_keyframe_count = 0; // the keyframe count of the uncompressed data
+		bool compressed_quaternion = false;
+		wi::vector<CompressedSegment> compressed_segments;
+		wi::vector<uint8_t> compressed_data;
+		wi::vector<float> compressed_ranges; // min and extent for every component of every segment (unused for quaternions)
+
+		constexpr bool IsCompressed() const { return _flags & COMPRESSED; }
+
+		// Non-serialized attributes:
+		//	These are computed by RefreshTimeRange() when keyframe_times was resized or reallocated
+		float time_first = 0;
+		float time_last = 0;
+		bool keyframe_times_sorted = false; // strictly increasing times allow the binary search and cursor lookup
+		const float* refreshed_keyframe_times = nullptr;
+		size_t refreshed_keyframe_count = 0;
+
+		// Updates the time range and sorted state if keyframe_times changed size or storage since the last refresh
+		//	If the times are modified in place, the animation update detects inconsistent keyframe search results and falls back to the linear search,
+		//	but refreshed_keyframe_count should be reset to force a refresh, so that the faster search is used again
+		void RefreshTimeRange();
+
+		// Returns the last keyframe whose time is not later than the given time, or -1 if the time is before the first keyframe
+		//	cursor	: the previous result for the same lookup, the search starts from there because animation time advances slowly
+		//	Only usable if keyframe_times_sorted is true
+		int FindKeyframe(float time, int& cursor) const;
+
+		// Compresses the keyframes by removing the ones that can be reconstructed by interpolation and quantizing the remaining ones
+		//	component_count	: the number of floats per keyframe (at most COMPRESSION_MAX_COMPONENTS)
+		//	quaternion		: the keyframes are rotation quaternions which are interpolated with slerp (component_count must be 4)
+		//	tolerance		: the largest allowed error of a component caused by removing keyframes, quantization error is added to this
+		//	step			: the keyframes are sampled with STEP interpolation, so only the keyframes that repeat the previous value are removed
+		//	returns true if the data was compressed, false if it is not compressible (unsorted times, mismatching data size, or already compressed)
+		//	Only data sampled with LINEAR interpolation (step = false) or STEP interpolation (step = true) can be compressed
+		bool Compress(uint32_t component_count, bool quaternion = false, float tolerance = 0.0001f, bool step = false);
+
+		// Restores keyframe_times and keyframe_data from the compressed keyframes, for example to allow editing them
+		void Decompress();
+
+		// Decodes the keyframes around the given time from the compressed data
+		//	cursor	: the previous segment for the same lookup, the search starts from there because animation time advances slowly
+		//	times	: receives the time of the left and right keyframes
+		//	data	: receives compressed_component_count values of the left, then of the right keyframe
+		//	returns the number of decoded keyframes: 0 if the time is before the first keyframe, 1 if the time is exactly on a keyframe or after the last one, 2 otherwise
+		int DecodeKeyframes(float time, int& cursor, float times[2], float* data) const;
+
+		// Returns the memory used by the keyframes, either compressed or uncompressed
+		size_t GetMemorySizeInBytes() const;
+
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 
@@ -1193,6 +1312,7 @@ namespace wi::scene
 
 			// Non-serialized attributes:
 			mutable int next_event = 0;
+			mutable int keyframe_cursor = 0; // last keyframe found for this channel, see AnimationDataComponent::FindKeyframe()
 		};
 		struct AnimationSampler
 		{
@@ -1720,3 +1840,11 @@ namespace wi::scene
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 }
+
+namespace wi::ecs
+{
+	// Most entities have these components, and they are looked up several times per entity in the hierarchy update, so they use the paged lookup:
+	template<> struct ComponentLookup<wi::scene::TransformComponent> { using type = PagedLookup; };
+	template<> struct ComponentLookup<wi::scene::HierarchyComponent> { using type = PagedLookup; };
+	template<> struct ComponentLookup<wi::scene::LayerComponent> { using type = PagedLookup; };
+}
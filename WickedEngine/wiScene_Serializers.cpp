@@ -377,14 +377,14 @@ namespace wi::scene
 		if (archive.IsReadMode())
 		{
 			archive >> _flags;
-			archive >> vertex_positions;
-			archive >> vertex_normals;
-			archive >> vertex_uvset_0;
-			archive >> vertex_boneindices;
-			archive >> vertex_boneweights;
-			archive >> vertex_atlas;
-			archive >> vertex_colors;
-			archive >> indices;
+			archive.ReadArray(vertex_positions);
+			archive.ReadArray(vertex_normals);
+			archive.ReadArray(vertex_uvset_0);
+			archive.ReadArray(vertex_boneindices);
+			archive.ReadArray(vertex_boneweights);
+			archive.ReadArray(vertex_atlas);
+			archive.ReadArray(vertex_colors);
+			archive.ReadArray(indices);
 
 			size_t subsetCount;
 			archive >> subsetCount;
@@ -401,7 +401,7 @@ namespace wi::scene
 
 			if (archive.GetVersion() >= 28)
 			{
-				archive >> vertex_uvset_1;
+				archive.ReadArray(vertex_uvset_1);
 			}
 
 			if (archive.GetVersion() >= 41 && archive.GetVersion() < 79)
@@ -417,12 +417,12 @@ namespace wi::scene
 
 			if (archive.GetVersion() >= 43)
 			{
-				archive >> vertex_windweights;
+				archive.ReadArray(vertex_windweights);
 			}
 
 			if (archive.GetVersion() >= 51)
 			{
-				archive >> vertex_tangents;
+				archive.ReadArray(vertex_tangents);
 			}
 
 			if (archive.GetVersion() >= 53)
@@ -432,16 +432,16 @@ namespace wi::scene
 			    morph_targets.resize(targetCount);
 			    for (size_t i = 0; i < targetCount; ++i)
 			    {
-					archive >> morph_targets[i].vertex_positions;
-					archive >> morph_targets[i].vertex_normals;
+					archive.ReadArray(morph_targets[i].vertex_positions);
+					archive.ReadArray(morph_targets[i].vertex_normals);
 					archive >> morph_targets[i].weight;
 					if (seri.GetVersion() >= 1)
 					{
-						archive >> morph_targets[i].sparse_indices_positions;
+						archive.ReadArray(morph_targets[i].sparse_indices_positions);
 					}
 					if (seri.GetVersion() >= 2)
 					{
-						archive >> morph_targets[i].sparse_indices_normals;
+						archive.ReadArray(morph_targets[i].sparse_indices_normals);
 					}
 			    }
 			}
@@ -458,14 +458,14 @@ namespace wi::scene
 		else
 		{
 			archive << _flags;
-			archive << vertex_positions;
-			archive << vertex_normals;
-			archive << vertex_uvset_0;
-			archive << vertex_boneindices;
-			archive << vertex_boneweights;
-			archive << vertex_atlas;
-			archive << vertex_colors;
-			archive << indices;
+			archive.WriteArray(vertex_positions);
+			archive.WriteArray(vertex_normals);
+			archive.WriteArray(vertex_uvset_0);
+			archive.WriteArray(vertex_boneindices);
+			archive.WriteArray(vertex_boneweights);
+			archive.WriteArray(vertex_atlas);
+			archive.WriteArray(vertex_colors);
+			archive.WriteArray(indices);
 
 			archive << subsets.size();
 			for (size_t i = 0; i < subsets.size(); ++i)
@@ -480,7 +480,7 @@ namespace wi::scene
 
 			if (archive.GetVersion() >= 28)
 			{
-				archive << vertex_uvset_1;
+				archive.WriteArray(vertex_uvset_1);
 			}
 
 			if (archive.GetVersion() >= 41 && archive.GetVersion() < 79)
@@ -496,12 +496,12 @@ namespace wi::scene
 
 			if (archive.GetVersion() >= 43)
 			{
-				archive << vertex_windweights;
+				archive.WriteArray(vertex_windweights);
 			}
 
 			if (archive.GetVersion() >= 51)
 			{
-				archive << vertex_tangents;
+				archive.WriteArray(vertex_tangents);
 			}
 
 			if (archive.GetVersion() >= 53)
@@ -509,16 +509,16 @@ namespace wi::scene
 			    archive << morph_targets.size();
 			    for (size_t i = 0; i < morph_targets.size(); ++i)
 			    {
-					archive << morph_targets[i].vertex_positions;
-					archive << morph_targets[i].vertex_normals;
+					archive.WriteArray(morph_targets[i].vertex_positions);
+					archive.WriteArray(morph_targets[i].vertex_normals);
 					archive << morph_targets[i].weight;
 					if (seri.GetVersion() >= 1)
 					{
-						archive << morph_targets[i].sparse_indices_positions;
+						archive.WriteArray(morph_targets[i].sparse_indices_positions);
 					}
 					if (seri.GetVersion() >= 2)
 					{
-						archive << morph_targets[i].sparse_indices_normals;
+						archive.WriteArray(morph_targets[i].sparse_indices_normals);
 					}
 			    }
 			}
@@ -1128,12 +1128,52 @@ namespace wi::scene
 			archive >> _flags;
 			archive >> keyframe_times;
 			archive >> keyframe_data;
+
+			if (archive.GetVersion() >= 90 && IsCompressed())
+			{
+				archive >> compressed_component_count;
+				archive >> compressed_keyframe_count;
+				archive >> compressed_quaternion;
+				size_t segment_count;
+				archive >> segment_count;
+				compressed_segments.resize(segment_count);
+				for (CompressedSegment& segment : compressed_segments)
+				{
+					archive >> segment.time_start;
+					archive >> segment.time_end;
+					archive >> segment.key_count;
+					archive >> segment.data_offset;
+					archive >> segment.range_offset;
+				}
+				archive >> compressed_data;
+				archive >> compressed_ranges;
+			}
+
+			refreshed_keyframe_count = 0;
 		}
 		else
 		{
 			archive << _flags;
 			archive << keyframe_times;
 			archive << keyframe_data;
+
+			if (archive.GetVersion() >= 90 && IsCompressed())
+			{
+				archive << compressed_component_count;
+				archive << compressed_keyframe_count;
+				archive << compressed_quaternion;
+				archive << compressed_segments.size();
+				for (const CompressedSegment& segment : compressed_segments)
+				{
+					archive << segment.time_start;
+					archive << segment.time_end;
+					archive << segment.key_count;
+					archive << segment.data_offset;
+					archive << segment.range_offset;
+				}
+				archive << compressed_data;
+				archive << compressed_ranges;
+			}
 		}
 	}
 	void WeatherComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)
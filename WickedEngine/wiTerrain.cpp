@@ -616,7 +616,7 @@ namespace wi::terrain
 					{
 						chunk_data.vt->free(atlas);
 					}
-					scene->Entity_Remove(it->second.entity);
+					scene->Entity_Remove(it->second.entity, true, true);
 					it = chunks.erase(it);
 					continue; // don't increment iterator
 				}
@@ -625,14 +625,14 @@ namespace wi::terrain
 					// Grass patch removal:
 					if (chunk_data.grass_entity != INVALID_ENTITY && (dist > 1 || !IsGrassEnabled()))
 					{
-						scene->Entity_Remove(chunk_data.grass_entity);
+						scene->Entity_Remove(chunk_data.grass_entity, true, true);
 						chunk_data.grass_entity = INVALID_ENTITY; // grass can be generated here by generation thread...
 					}
 
 					// Prop removal:
 					if (chunk_data.props_entity != INVALID_ENTITY && (dist > prop_generation || std::abs(chunk_data.prop_density_current - prop_density) > std::numeric_limits<float>::epsilon()))
 					{
-						scene->Entity_Remove(chunk_data.props_entity);
+						scene->Entity_Remove(chunk_data.props_entity, true, true);
 						chunk_data.props_entity = INVALID_ENTITY; // prop can be generated here by generation thread...
 					}
 				}
@@ -706,6 +706,7 @@ namespace wi::terrain
 		}
 
 		// Start the generation on a background thread and keep it running until the next frame
+		generator->workload.priority = wi::jobsystem::Priority::Low;
 		wi::jobsystem::Execute(generator->workload, [=](wi::jobsystem::JobArgs args) {
 
 			wi::Timer timer;
@@ -769,6 +770,7 @@ namespace wi::terrain
 
 					// Do a parallel for loop over all the chunk's vertices and compute their properties:
 					wi::jobsystem::context ctx;
+					ctx.priority = wi::jobsystem::Priority::Low; // stays on the background threads with the generation
 					wi::jobsystem::Dispatch(ctx, vertexCount, chunk_width, [&](wi::jobsystem::JobArgs args) {
 						uint32_t index = args.jobIndex;
 						const float x = (float(index % chunk_width) - chunk_half_width) * chunk_scale;